@@ -0,0 +1,83 @@
+/*
+ * AllocationCounter.h
+ *
+ *  Created on: Apr 27, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+// Counts calls to the global operator new, and the bytes they ask for, while isCounting is set.
+// The totals only ever grow; BenchmarkSuite and Profiler measure a stage by their difference across it.
+// The replacement operators below are only compiled into the program once, since this header is only
+// ever included by scene.cpp
+class AllocationCounter {
+	public:
+		static std::atomic<bool> isCounting;
+		static std::atomic<long> numberOfAllocations;
+		static std::atomic<long> bytesAllocated;
+
+	static void *allocate(size_t size) {
+		if (isCounting.load(std::memory_order_relaxed)) {
+			numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+			bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+		}
+		return std::malloc(size == 0 ? 1 : size);
+	}
+};
+
+std::atomic<bool> AllocationCounter::isCounting(false);
+std::atomic<long> AllocationCounter::numberOfAllocations(0);
+std::atomic<long> AllocationCounter::bytesAllocated(0);
+
+void *operator new(size_t size) {
+	void *pointer = AllocationCounter::allocate(size);
+	if (pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return AllocationCounter::allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return AllocationCounter::allocate(size);
+}
+
+// (GCC sees the replacement operator new's malloc and these frees as mismatched once both are inlined)
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+	std::free(pointer);
+}
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+
+#endif /* ALLOCATIONCOUNTER_H_ */
@@ -0,0 +1,155 @@
+/*
+ * BenchmarkSuite.h
+ *
+ *  Created on: Apr 27, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef BENCHMARKSUITE_H_
+#define BENCHMARKSUITE_H_
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Times stages of the tessellation pipeline over and over, and writes what it measured as JSON.
+//
+// Every measurement runs the stage once untimed (to warm the caches and let vectors reach their size),
+// then times it until it has run minimumRuns times and for secondsPerStage seconds in all, or maximumRuns times
+class BenchmarkSuite {
+	public:
+		class Result {
+			public:
+				std::string asset;
+				std::string stage;
+
+				// The step size or error the stage ran with (negative if it doesn't take one)
+				double parameter;
+
+				int runs;
+
+				// Run times in milliseconds: fastest, median and 99th percentile (nearest rank)
+				double minimum, median, p99;
+
+				// Average calls to operator new, and bytes they asked for, per run
+				long allocations;
+				long bytesAllocated;
+
+				// What the stage produced (triangles, vertices or bytes; see the stage), from its last run
+				long outputSize;
+		};
+
+		double secondsPerStage;
+		int minimumRuns;
+		int maximumRuns;
+
+		std::vector<Result> results;
+
+	BenchmarkSuite(double secondsPerStage, int minimumRuns, int maximumRuns) {
+		this->secondsPerStage = secondsPerStage;
+		this->minimumRuns = minimumRuns;
+		this->maximumRuns = maximumRuns;
+	}
+
+	//****************************************************
+	// Measures one stage: setup() prepares each run untimed, then run() is timed and returns the size of
+	// what it produced. Prints the result as a line of the summary table and adds it to 'results'
+	//***************************************************
+	template <class Setup, class Run>
+	void measure(std::string asset, std::string stage, double parameter, Setup setup, Run run) {
+		setup();
+		run();
+
+		std::vector<double> times;
+		long allocations = 0;
+		long bytesAllocated = 0;
+		long outputSize = 0;
+		double totalSeconds = 0;
+		while ((int) times.size() < maximumRuns && ((int) times.size() < minimumRuns || totalSeconds < secondsPerStage)) {
+			setup();
+
+			long allocationsBefore = AllocationCounter::numberOfAllocations;
+			long bytesBefore = AllocationCounter::bytesAllocated;
+			bool wasCounting = AllocationCounter::isCounting.exchange(true);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			outputSize = run();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			AllocationCounter::isCounting = wasCounting;
+
+			allocations += AllocationCounter::numberOfAllocations - allocationsBefore;
+			bytesAllocated += AllocationCounter::bytesAllocated - bytesBefore;
+			times.push_back(elapsed.count() * 1000.0);
+			totalSeconds += elapsed.count();
+		}
+		std::sort(times.begin(), times.end());
+		int n = times.size();
+
+		Result result;
+		result.asset = asset;
+		result.stage = stage;
+		result.parameter = parameter;
+		result.runs = n;
+		result.minimum = times[0];
+		result.median = times[std::max(0, (int) ceil(0.50 * n) - 1)];
+		result.p99 = times[std::max(0, (int) ceil(0.99 * n) - 1)];
+		result.allocations = allocations / n;
+		result.bytesAllocated = bytesAllocated / n;
+		result.outputSize = outputSize;
+		results.push_back(result);
+
+		char parameterText[32] = "";
+		if (parameter >= 0) {
+			snprintf(parameterText, sizeof(parameterText), "%g", parameter);
+		}
+		printf("  %-16s %-21s %-7s %4d runs   min %9.3f ms   median %9.3f ms   p99 %9.3f ms   %9ld allocations\n",
+				asset.c_str(), stage.c_str(), parameterText, n, result.minimum, result.median, result.p99, result.allocations);
+		fflush(stdout);
+	}
+
+	//****************************************************
+	// Writes every result to 'filename' as a JSON array of objects, one per measurement.
+	// Returns false if the file couldn't be written
+	//***************************************************
+	bool writeJSON(std::string filename) {
+		FILE *file = fopen(filename.c_str(), "w");
+		if (file == NULL) {
+			return false;
+		}
+		fprintf(file, "[\n");
+		for (std::vector<Result>::size_type i = 0; i < results.size(); i++) {
+			const Result &result = results[i];
+			fprintf(file, "  {\"asset\": \"%s\", \"stage\": \"%s\", ", escape(result.asset).c_str(), escape(result.stage).c_str());
+			if (result.parameter >= 0) {
+				fprintf(file, "\"parameter\": %g, ", result.parameter);
+			} else {
+				fprintf(file, "\"parameter\": null, ");
+			}
+			fprintf(file, "\"runs\": %d, \"min_ms\": %.6f, \"median_ms\": %.6f, \"p99_ms\": %.6f, "
+					"\"allocations\": %ld, \"bytes_allocated\": %ld, \"output_size\": %ld}%s\n",
+					result.runs, result.minimum, result.median, result.p99, result.allocations, result.bytesAllocated,
+					result.outputSize, (i + 1 < results.size()) ? "," : "");
+		}
+		fprintf(file, "]\n");
+		return fclose(file) == 0;
+	}
+
+	private:
+
+	// Escapes quotes and backslashes (file names are the only strings that could hold them)
+	static std::string escape(const std::string &text) {
+		std::string escaped;
+		for (std::string::size_type i = 0; i < text.size(); i++) {
+			if (text[i] == '"' || text[i] == '\\') {
+				escaped += '\\';
+			}
+			escaped += text[i];
+		}
+		return escaped;
+	}
+};
+
+
+#endif /* BENCHMARKSUITE_H_ */
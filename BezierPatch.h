@@ -8,44 +8,375 @@
 #ifndef BEZIERPATCH_H_
 #define BEZIERPATCH_H_
 
-#include <queue>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <map>
+#include <vector>
+#include <limits>
+#include <stdint.h>
+
+// On x86 we evaluate packets of samples with SSE (always present on x86-64) or AVX (checked at runtime)
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define BEZIER_PATCH_X86_SIMD
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define BEZIER_PATCH_AVX_TARGET __attribute__((target("avx")))
+#else
+#define BEZIER_PATCH_AVX_TARGET
+#endif
+#endif
 
 class BezierPatch {
 	public:
-		std::vector<std::vector <Eigen::Vector3f> > listOfCurves;
+		// The surface evaluators that evaluateDifferentialGeometry can dispatch to
+		// (SIMD evaluates whole SamplePackets at once and falls back to BERNSTEIN for single points)
+		enum EvaluationMethod { DE_CASTELJAU, BERNSTEIN, SIMD };
+
+		// The patch's degreeV + 1 curves of degreeU + 1 control points each, stored in a fixed grid big enough
+		// for any degree so that neither loading nor evaluating the patch touches the heap.
+		// controlPoints[i][j] is the j-th point of the i-th curve
+		BezierControlGrid controlPoints;
+
+		// The patch's degree along each curve (u) and across the curves (v), each 1 ... MAX_BEZIER_DEGREE (default 3)
+		int degreeU, degreeV;
+
+		// If true, the patch is rational: every control point has a weight, and the patch is evaluated from
+		// getHomogeneousControlPoints(), which setControlPoint keeps in step with controlPoints. The weights are all
+		// positive, so the surface still lies inside the convex hull of controlPoints (default = false)
+		bool rational;
+
+		// How many curves have been added with addCurve (or written straight into controlPoints by the loader)
+		int numberOfCurves;
+
+		// Which evaluator evaluateDifferentialGeometry uses (default = BERNSTEIN)
+		EvaluationMethod evaluationMethod;
+
+		// Box around the control points, and so (by the convex hull property) around the whole surface.
+		// Kept up to date by addCurve; the loader calls computeBounds once it has written controlPoints itself
+		BoundingBox bounds;
+
+		// list of differential geometries (i.e. points) that we are evaluating the given patch at.
+		// This is the single owner of every vertex of the tessellation (though it may keep them in a slice
+		// of a scene-wide buffer; see TessellationList)
+		TessellationList<DifferentialGeometry> listOfDifferentialGeometries;
+
+		// final list of subdivided triangles, ready to feed to OpenGL display system.
+		// Every three consecutive entries are the indices (into listOfDifferentialGeometries) of one triangle
+		TessellationList<uint32_t> listOfTriangleIndices;
+
+		// for adaptive subdivision, how many splits away from the initial two each triangle in listOfTriangleIndices is
+		TessellationList<uint32_t> listOfTriangleDepths;
+
+		// The step size or error the patch was last tessellated with (0 = not tessellated yet), and for
+		// uniform subdivision, the number of steps along each side of the grid
+		float tessellationParameter;
+		int uniformSteps;
+
+		// If true, adaptive subdivision's error is in pixels rather than world units (see setScreenSpaceError)
+		bool screenSpaceError;
+
+		// For screen-space error: the eye-space depth of a point p is depthRow . (p, 1), and one pixel at
+		// depth d spans worldErrorPerPixel * d world units. Depths closer than minimumDepth count as minimumDepth.
+		// (DontAlign, since BezierPatches are copied around in plain std::vectors, which don't keep Eigen's 16-byte alignment)
+		Eigen::Matrix<float, 4, 1, Eigen::DontAlign> depthRow;
+		float worldErrorPerPixel;
+		float minimumDepth;
+
+		// With screen-space error, the pixel size of the patch's nearest part when it was last tessellated
+		float tessellatedErrorScale;
+
+		// With screen-space error, true if the view can't see any of the patch, which then isn't refined at all
+		bool outsideView;
+
+		// if true, performAdaptiveSubdivision works depth-first instead of breadth-first
+		bool depthFirstSubdivision;
+
+		// triangles this many splits away from the initial two are never split again (0 = no limit)
+		int maxSubdivisionDepth;
+
+		// the most triangles that were ever waiting in queueOfTriangles at once
+		long peakFrontierSize;
 
-		// final list of subdivided triangles, ready to feed to OpenGL display system
-		std::vector<Triangle> listOfTriangles;
+		// evaluated edge midpoints (and their split vertices) for adaptive triangulation, shared by neighboring triangles
+		EdgeMidpointCache midpointCache;
 
-		// list of differential geometries (i.e. points) that we are evaluating the given patch at
-		std::vector<DifferentialGeometry> listOfDifferentialGeometries;
+		// number of times the surface has been evaluated while tessellating this patch
+		long numberOfSurfaceEvaluations;
 
-		// queue of triangles for adaptive triangulation
-		std::queue<Triangle> queueOfTriangles;
+		// number of triangles adaptive subdivision has sorted into each of its 8 cases (case k is at k - 1)
+		long numberOfTrianglesPerCase[8];
 
 	BezierPatch() {
+		degreeU = degreeV = 3;
+		numberOfCurves = 0;
+		rational = false;
+		for (int i = 0; i <= MAX_BEZIER_DEGREE; i++) {
+			for (int j = 0; j <= MAX_BEZIER_DEGREE; j++) {
+				controlPoints[i][j] = Eigen::Vector3f(0, 0, 0);
+			}
+		}
+		evaluationMethod = BERNSTEIN;
+		numberOfSurfaceEvaluations = 0;
+		for (int k = 0; k < 8; k++) {
+			numberOfTrianglesPerCase[k] = 0;
+		}
+		depthFirstSubdivision = false;
+		maxSubdivisionDepth = 0;
+		peakFrontierSize = 0;
+		tessellationParameter = 0;
+		uniformSteps = 0;
+		screenSpaceError = false;
+		depthRow = Eigen::Vector4f(0, 0, 0, 0);
+		worldErrorPerPixel = 0;
+		minimumDepth = 0;
+		tessellatedErrorScale = 0;
+		outsideView = false;
+	}
 
+	// Sets the patch's degrees, before its curves are added. Returns false (and leaves the patch as it was)
+	// unless both are between 1 and MAX_BEZIER_DEGREE
+	bool setDegrees(int degreeU, int degreeV) {
+		if (degreeU < 1 || degreeU > MAX_BEZIER_DEGREE || degreeV < 1 || degreeV > MAX_BEZIER_DEGREE) {
+			return false;
+		}
+		this->degreeU = degreeU;
+		this->degreeV = degreeV;
+		return true;
 	}
 
 	// Adds a curve to the list of curves.
-	// NOTE: A curve, at initialization from the command line, is represented by a length-4 list of Vector3f's.
-	//       That is, a curve is represented by a list of four points.
+	// NOTE: A curve, at initialization from the command line, is represented by a list of degreeU + 1 Vector3f's.
+	//       That is, a bicubic patch's curve is represented by a list of four points.
 	void addCurve(std::vector<Eigen::Vector3f> curve) {
-		listOfCurves.push_back(curve);
+		for (int j = 0; j <= degreeU; j++) {
+			controlPoints[numberOfCurves][j] = curve[j];
+		}
+		numberOfCurves++;
+		computeBounds();
+	}
+
+	//****************************************************
+	// Sets the j-th point of the i-th curve to 'point' with weight 'weight', making the patch rational (any
+	// points without a weight of their own get weight 1). Like writing controlPoints[i][j] directly, this
+	// doesn't add a curve or update the bounds. Returns false (and leaves the patch as it was) unless the
+	// weight is positive
+	//***************************************************
+	bool setControlPoint(int i, int j, const Eigen::Vector3f &point, float weight) {
+		if (!(weight > 0 && weight <= std::numeric_limits<float>::max())) {
+			return false;
+		}
+		if (!rational) {
+			rational = true;
+			homogeneousGrid.resize(1);
+			for (int k = 0; k <= MAX_BEZIER_DEGREE; k++) {
+				for (int l = 0; l <= MAX_BEZIER_DEGREE; l++) {
+					homogeneousGrid[0].points[k][l] << controlPoints[k][l], 1.0f;
+				}
+			}
+		}
+		controlPoints[i][j] = point;
+		homogeneousGrid[0].points[i][j] << weight * point, weight;
+		return true;
 	}
 
-	void addTriangle(DifferentialGeometry vertex1, DifferentialGeometry vertex2, DifferentialGeometry vertex3) {
-		listOfTriangles.push_back(Triangle(vertex1, vertex2, vertex3));
+	// The weight of the j-th point of the i-th curve (1 unless the patch is rational)
+	float getWeight(int i, int j) const {
+		return rational ? homogeneousGrid[0].points[i][j].w() : 1.0f;
+	}
+
+	// A rational patch's control points in homogeneous form (w * p, w). Only valid if the patch is rational
+	const BezierHomogeneousGrid &getHomogeneousControlPoints() const {
+		return homogeneousGrid[0].points;
+	}
+
+	void computeBounds() {
+		bounds = BoundingBox();
+		for (int i = 0; i < numberOfCurves; i++) {
+			for (int j = 0; j <= degreeU; j++) {
+				bounds.extend(controlPoints[i][j]);
+			}
+		}
+	}
+
+	// Returns the patch's curves as a list of length-(degreeU + 1) lists of points (the format addCurve takes)
+	std::vector<std::vector<Eigen::Vector3f> > getCurves() {
+		std::vector<std::vector<Eigen::Vector3f> > curves;
+		for (int i = 0; i < numberOfCurves; i++) {
+			curves.push_back(std::vector<Eigen::Vector3f>(controlPoints[i], controlPoints[i] + degreeU + 1));
+		}
+		return curves;
+	}
+
+	bool isBicubic() const {
+		return degreeU == 3 && degreeV == 3;
+	}
+
+	// True for the common case that has its own fast paths: bicubic, and not rational
+	bool isPolynomialBicubic() const {
+		return isBicubic() && !rational;
+	}
+
+	void addTriangle(uint32_t index1, uint32_t index2, uint32_t index3) {
+		listOfTriangleIndices.push_back(index1);
+		listOfTriangleIndices.push_back(index2);
+		listOfTriangleIndices.push_back(index3);
+	}
+
+	void addTriangle(IndexedTriangle triangle) {
+		addTriangle(triangle.index1, triangle.index2, triangle.index3);
+		listOfTriangleDepths.push_back(triangle.depth);
 	}
 
 	void addDifferentialGeometry(Eigen::Vector3f position, Eigen::Vector3f normal, Eigen::Vector2f uvValues) {
 		listOfDifferentialGeometries.push_back(DifferentialGeometry(position, normal, uvValues));
 	}
 
+	// Appends a vertex to listOfDifferentialGeometries and returns its index
+	uint32_t addVertex(DifferentialGeometry vertex) {
+		listOfDifferentialGeometries.push_back(vertex);
+		return listOfDifferentialGeometries.size() - 1;
+	}
+
+	// Returns the index of an edge's midpoint vertex, adding the vertex the first time any triangle splits the edge
+	uint32_t getMidpointVertex(EdgeMidpointCache::Entry &edge) {
+		if (edge.vertexIndex < 0) {
+			edge.vertexIndex = addVertex(edge.midpoint);
+		}
+		return edge.vertexIndex;
+	}
+
+	//****************************************************
+	// Makes adaptive subdivision measure error in pixels, as seen through 'modelview' (which must be rigid)
+	// and 'projection', a perspective projection in which one pixel at depth 1 spans 'worldErrorPerPixel'
+	// world units. Takes effect the next time the patch is (re)tessellated
+	//***************************************************
+	void setScreenSpaceError(const Eigen::Matrix4f &modelview, const Eigen::Matrix4f &projection,
+			float worldErrorPerPixel, float minimumDepth) {
+		screenSpaceError = true;
+		depthRow = -modelview.row(2).transpose();
+		this->worldErrorPerPixel = worldErrorPerPixel;
+		this->minimumDepth = minimumDepth;
+		outsideView = isOutsideView(projection * modelview);
+	}
+
+	// How many world units one unit of error is at 'point': one pixel's worth with screen-space error, else 1
+	float getErrorScale(const Eigen::Vector3f &point) {
+		if (!screenSpaceError) {
+			return 1.0f;
+		}
+		if (outsideView) {
+			return std::numeric_limits<float>::infinity();
+		}
+		return computePixelSize(point, depthRow, worldErrorPerPixel, minimumDepth);
+	}
+
+	//****************************************************
+	// True if the patch has no screen-space tessellation yet, if it came into or went out of view, or if
+	// through the new view its nearest part is more than 'tolerance' times larger or smaller on screen
+	// than when it was last tessellated
+	//***************************************************
+	bool needsScreenSpaceRetessellation(const Eigen::Matrix4f &modelview, const Eigen::Matrix4f &projection,
+			float worldErrorPerPixel, float minimumDepth, float tolerance) {
+		if (!screenSpaceError || tessellatedErrorScale <= 0) {
+			return true;
+		}
+		bool outside = isOutsideView(projection * modelview);
+		if (outside != outsideView) {
+			return true;
+		}
+		if (outside) {
+			return false;
+		}
+		float ratio = computeNearestPixelSize(-modelview.row(2).transpose(), worldErrorPerPixel, minimumDepth) / tessellatedErrorScale;
+		return ratio > tolerance || ratio < 1.0f / tolerance;
+	}
+
+	//****************************************************
+	// True if every control point is outside the same clipping plane of 'modelviewProjection'. The patch
+	// lies inside the convex hull of its control points, so then none of it can be seen
+	//***************************************************
+	bool isOutsideView(const Eigen::Matrix4f &modelviewProjection) {
+		int outsideAll = 0x3F;
+		for (int i = 0; i < numberOfCurves && outsideAll != 0; i++) {
+			for (int j = 0; j <= degreeU; j++) {
+				outsideAll &= BoundingBox::getOutcode(modelviewProjection, controlPoints[i][j]);
+			}
+		}
+		return outsideAll != 0;
+	}
+
+	// World units spanned by one pixel at 'point' (see setScreenSpaceError)
+	static float computePixelSize(const Eigen::Vector3f &point, const Eigen::Vector4f &depthRow, float worldErrorPerPixel,
+			float minimumDepth) {
+		float depth = depthRow.dot(Eigen::Vector4f(point.x(), point.y(), point.z(), 1.0f));
+		return worldErrorPerPixel * std::max(std::fabs(depth), minimumDepth);
+	}
+
+	// The smallest computePixelSize() over the control points, i.e. the pixel size of the nearest part of the patch
+	float computeNearestPixelSize(const Eigen::Vector4f &depthRow, float worldErrorPerPixel, float minimumDepth) {
+		float nearest = std::numeric_limits<float>::max();
+		for (int i = 0; i < numberOfCurves; i++) {
+			for (int j = 0; j <= degreeU; j++) {
+				nearest = std::min(nearest, computePixelSize(controlPoints[i][j], depthRow, worldErrorPerPixel, minimumDepth));
+			}
+		}
+		return nearest;
+	}
+
+	int getNumberOfTriangles() {
+		return listOfTriangleIndices.size() / 3;
+	}
+
+	// Expands the i-th triangle into its three vertices
+	Triangle getTriangle(int i) {
+		return Triangle(listOfDifferentialGeometries[listOfTriangleIndices[3 * i]],
+				listOfDifferentialGeometries[listOfTriangleIndices[3 * i + 1]],
+				listOfDifferentialGeometries[listOfTriangleIndices[3 * i + 2]]);
+	}
+
+	//****************************************************
+	// Finds the nearest point where the ray origin + t * direction (0 < t < tMax) hits one of the
+	// tessellation's triangles (Moller-Trumbore, both sides). If there is one, sets t to it and
+	// returns true
+	//***************************************************
+	bool intersectTessellation(const Eigen::Vector3f &origin, const Eigen::Vector3f &direction, float tMax, float &t) {
+		bool hit = false;
+		for (std::vector<uint32_t>::size_type i = 0; i < listOfTriangleIndices.size(); i += 3) {
+			const Eigen::Vector3f &a = listOfDifferentialGeometries[listOfTriangleIndices[i]].position;
+			const Eigen::Vector3f &b = listOfDifferentialGeometries[listOfTriangleIndices[i + 1]].position;
+			const Eigen::Vector3f &c = listOfDifferentialGeometries[listOfTriangleIndices[i + 2]].position;
+
+			Eigen::Vector3f edge1 = b - a;
+			Eigen::Vector3f edge2 = c - a;
+			Eigen::Vector3f p = direction.cross(edge2);
+			float determinant = edge1.dot(p);
+			if (determinant == 0) {
+				continue;
+			}
+			float inverseDeterminant = 1.0f / determinant;
+			Eigen::Vector3f s = origin - a;
+			float u = s.dot(p) * inverseDeterminant;
+			if (u < 0 || u > 1) {
+				continue;
+			}
+			Eigen::Vector3f q = s.cross(edge1);
+			float v = direction.dot(q) * inverseDeterminant;
+			if (v < 0 || u + v > 1) {
+				continue;
+			}
+			float distance = edge2.dot(q) * inverseDeterminant;
+			if (distance > 0 && distance < tMax) {
+				tMax = distance;
+				hit = true;
+			}
+		}
+		if (hit) {
+			t = tMax;
+		}
+		return hit;
+	}
+
 
 
 
@@ -55,95 +386,369 @@ class BezierPatch {
 	// return the curve point and derivative.
 	// This is a helper method that is used in 'evaulateDifferentialGeometry'.
 	//
-	// NOTE: This method is given in the last slide of CS184 Spring 2015 Lecture 14 (O'Brien)
+	// NOTE: This method is given in the last slide of CS184 Spring 2015 Lecture 14 (O'Brien),
+	//       for cubics; here the same reduction runs for a curve of any degree
 	//***************************************************
-	CurveLocalGeometry interpretBezierCurve(std::vector<Eigen::Vector3f> curve, float u) {
-		// First, split each of the three segments to form two new ones, AB and BC
-		// NOTE: 'curve' is a length-4 list of Vector3f's. Each Vector3f represents a control point of the curve.
-		Eigen::Vector3f A = (curve[0] * (1.0 - u)) + (curve[1] * u);
-		Eigen::Vector3f B = (curve[1] * (1.0 - u)) + (curve[2] * u);
-		Eigen::Vector3f C = (curve[2] * (1.0 - u)) + (curve[3] * u);
+	static CurveLocalGeometry interpretBezierCurve(const Eigen::Vector3f *curve, int degree, float u) {
+		Eigen::Vector3f point, derivative;
+		reduceBezierCurve(curve, degree, u, point, derivative);
+		return CurveLocalGeometry(point, derivative);
+	}
 
-		// Now, split AB and BC to form a new segment DE
-		Eigen::Vector3f D = (A * (1.0 - u)) + (B * u);
-		Eigen::Vector3f E = (B * (1.0 - u)) + (C * u);
+	// Same as above, for a curve of any kind of point (e.g. the homogeneous points of a rational curve)
+	template <class Point>
+	static void reduceBezierCurve(const Point *curve, int degree, float u, Point &point, Point &derivative) {
+		// Repeatedly split every segment of the control polygon at u, leaving one segment fewer each time.
+		// NOTE: 'curve' is a length-(degree + 1) list of points (degree >= 1). Each point is a control point of the curve.
+		Point points[MAX_BEZIER_DEGREE + 1];
+		points[0] = curve[0];
+		points[1] = curve[1];
+		for (int k = 2; k <= degree; k++) {
+			points[k] = curve[k];
+		}
+		for (int level = degree; level > 1; level--) {
+			for (int k = 0; k < level; k++) {
+				points[k] = (points[k] * (1.0 - u)) + (points[k + 1] * u);
+			}
+		}
 
-		// Finally, pick the right point on DE; this is the point on the curve
-		Eigen::Vector3f point = (D * (1.0 - u)) + (E * u);
+		// Finally, pick the right point on the last segment DE; this is the point on the curve
+		point = (points[0] * (1.0 - u)) + (points[1] * u);
 
 		// Then, compute the derivative
-		Eigen::Vector3f derivative = 3.0 * (E - D);
+		derivative = (float) degree * (points[1] - points[0]);
+	}
 
-		return CurveLocalGeometry(point, derivative);
+
+	//****************************************************
+	// Computes the four cubic Bernstein weights and their derivatives at parametric value t
+	// (other degrees' are in BernsteinBasis)
+	//***************************************************
+	static void computeBernsteinWeights(float t, float weights[4], float derivativeWeights[4]) {
+		BernsteinBasis<3>::evaluate(t, weights, derivativeWeights);
 	}
 
 
 	//****************************************************
 	// Method that generates a DifferentialGeometry object that represents
-	// the result of evaluating 'this' BezierPatch at (u, v)
-	//
-	// NOTE: This method is given in the last slide of CS184 Spring 2015 Lecture 14 (O'Brien)
+	// the result of evaluating 'this' BezierPatch at (u, v), using whichever
+	// evaluator 'evaluationMethod' selects
 	//***************************************************
 	DifferentialGeometry evaluateDifferentialGeometry(float u, float v) {
-		// listOfCurves[i] returns a list of points that represents one curve
-
-		// Build control points for a Bezier curve in v
-		Eigen::Vector3f vCurve0 = interpretBezierCurve(listOfCurves[0], u).point;
-		Eigen::Vector3f vCurve1 = interpretBezierCurve(listOfCurves[1], u).point;
-		Eigen::Vector3f vCurve2 = interpretBezierCurve(listOfCurves[2], u).point;
-		Eigen::Vector3f vCurve3 = interpretBezierCurve(listOfCurves[3], u).point;
-
-		std::vector<Eigen::Vector3f> uCurve0List;
-		uCurve0List.push_back(listOfCurves[0][0]);
-		uCurve0List.push_back(listOfCurves[1][0]);
-		uCurve0List.push_back(listOfCurves[2][0]);
-		uCurve0List.push_back(listOfCurves[3][0]);
-
-		std::vector<Eigen::Vector3f> uCurve1List;
-		uCurve1List.push_back(listOfCurves[0][1]);
-		uCurve1List.push_back(listOfCurves[1][1]);
-		uCurve1List.push_back(listOfCurves[2][1]);
-		uCurve1List.push_back(listOfCurves[3][1]);
-
-		std::vector<Eigen::Vector3f> uCurve2List;
-		uCurve2List.push_back(listOfCurves[0][2]);
-		uCurve2List.push_back(listOfCurves[1][2]);
-		uCurve2List.push_back(listOfCurves[2][2]);
-		uCurve2List.push_back(listOfCurves[3][2]);
-
-		std::vector<Eigen::Vector3f> uCurve3List;
-		uCurve3List.push_back(listOfCurves[0][3]);
-		uCurve3List.push_back(listOfCurves[1][3]);
-		uCurve3List.push_back(listOfCurves[2][3]);
-		uCurve3List.push_back(listOfCurves[3][3]);
-
-		// Build control points for a Bezier curve in v
-		Eigen::Vector3f uCurve0 = interpretBezierCurve(uCurve0List, v).point;
-		Eigen::Vector3f uCurve1 = interpretBezierCurve(uCurve1List, v).point;
-		Eigen::Vector3f uCurve2 = interpretBezierCurve(uCurve2List, v).point;
-		Eigen::Vector3f uCurve3 = interpretBezierCurve(uCurve3List, v).point;
+		if (evaluationMethod == DE_CASTELJAU) {
+			return evaluateDifferentialGeometryDeCasteljau(u, v);
+		}
+		return evaluateDifferentialGeometryBernstein(u, v);
+	}
 
-		// Evaluate surface and derivative for u and v
-		std::vector<Eigen::Vector3f> vCurve;
-		vCurve.push_back(vCurve0);
-		vCurve.push_back(vCurve1);
-		vCurve.push_back(vCurve2);
-		vCurve.push_back(vCurve3);
 
-		std::vector<Eigen::Vector3f> uCurve;
-		uCurve.push_back(uCurve0);
-		uCurve.push_back(uCurve1);
-		uCurve.push_back(uCurve2);
-		uCurve.push_back(uCurve3);
+	//****************************************************
+	// Evaluates 'this' BezierPatch at (u, v) directly from the tensor-product form, with the
+	// BezierSurface for the patch's degrees. Bicubic patches go straight to theirs; any other
+	// degrees, and rational patches (which are evaluated in homogeneous coordinates), are looked up at runtime
+	//***************************************************
+	DifferentialGeometry evaluateDifferentialGeometryBernstein(float u, float v) {
+		if (isPolynomialBicubic()) {
+			return BezierSurface<3, 3>::evaluate(controlPoints, u, v);
+		}
+		return evaluateDifferentialGeometryOfAnyDegree(u, v);
+	}
+
+
+	//****************************************************
+	// Evaluates every sample in 'packet', writing positions and normals back into it.
+	//
+	// Dispatches at runtime to the widest kernel the CPU supports: AVX (8 samples per instruction),
+	// SSE (4 samples per instruction), or a scalar loop over evaluateDifferentialGeometryBernstein.
+	// The SIMD kernels are for polynomial bicubics, so patches of other degrees and rational patches
+	// always take the scalar loop
+	//***************************************************
+	void evaluatePacket(SamplePacket &packet) {
+#ifdef BEZIER_PATCH_X86_SIMD
+		if (isPolynomialBicubic() && packet.count > 4 && cpuSupportsAVX()) {
+			evaluatePacketAVX(packet);
+			return;
+		}
+		if (isPolynomialBicubic() && cpuSupportsSSE2()) {
+			for (int first = 0; first < packet.count; first += 4) {
+				evaluatePacketSSE(packet, first);
+			}
+			return;
+		}
+#endif
+		for (int i = 0; i < packet.count; i++) {
+			DifferentialGeometry result = evaluateDifferentialGeometryBernstein(packet.u[i], packet.v[i]);
+			packet.x[i] = result.position.x();
+			packet.y[i] = result.position.y();
+			packet.z[i] = result.position.z();
+			packet.nx[i] = result.normal.x();
+			packet.ny[i] = result.normal.y();
+			packet.nz[i] = result.normal.z();
+		}
+	}
+
+#ifdef BEZIER_PATCH_X86_SIMD
+	static bool cpuSupportsSSE2() {
+#if defined(__GNUC__)
+		static bool supported = __builtin_cpu_supports("sse2");
+		return supported;
+#else
+		return true;
+#endif
+	}
+
+	static bool cpuSupportsAVX() {
+#if defined(__GNUC__)
+		static bool supported = __builtin_cpu_supports("avx");
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	//****************************************************
+	// SSE kernel: evaluates samples [first, first + 4) of 'packet'.
+	// This is evaluateDifferentialGeometryBernstein with every float widened to a 4-lane register.
+	//***************************************************
+	void evaluatePacketSSE(SamplePacket &packet, int first) {
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 three = _mm_set1_ps(3.0f);
+		__m128 six = _mm_set1_ps(6.0f);
+
+		// Bernstein weights (and derivatives) for the four lanes, in u and in v
+		__m128 uWeights[4], uDerivativeWeights[4], vWeights[4], vDerivativeWeights[4];
+		__m128 t[2] = { _mm_load_ps(packet.u + first), _mm_load_ps(packet.v + first) };
+		__m128 *weights[2] = { uWeights, vWeights };
+		__m128 *derivativeWeights[2] = { uDerivativeWeights, vDerivativeWeights };
+		for (int d = 0; d < 2; d++) {
+			__m128 s = _mm_sub_ps(one, t[d]);
+			__m128 ss = _mm_mul_ps(s, s);
+			__m128 tt = _mm_mul_ps(t[d], t[d]);
+			__m128 ts = _mm_mul_ps(t[d], s);
+			weights[d][0] = _mm_mul_ps(ss, s);
+			weights[d][1] = _mm_mul_ps(three, _mm_mul_ps(t[d], ss));
+			weights[d][2] = _mm_mul_ps(three, _mm_mul_ps(tt, s));
+			weights[d][3] = _mm_mul_ps(tt, t[d]);
+			derivativeWeights[d][0] = _mm_mul_ps(_mm_set1_ps(-3.0f), ss);
+			derivativeWeights[d][1] = _mm_sub_ps(_mm_mul_ps(three, ss), _mm_mul_ps(six, ts));
+			derivativeWeights[d][2] = _mm_sub_ps(_mm_mul_ps(six, ts), _mm_mul_ps(three, tt));
+			derivativeWeights[d][3] = _mm_mul_ps(three, tt);
+		}
+
+		__m128 point[3], uDerivative[3], vDerivative[3];
+		for (int c = 0; c < 3; c++) {
+			point[c] = uDerivative[c] = vDerivative[c] = _mm_setzero_ps();
+		}
+
+		for (int i = 0; i < 4; i++) {
+			for (int c = 0; c < 3; c++) {
+				// Evaluate coordinate c of the i-th curve (and its derivative) in u...
+				__m128 curvePoint = _mm_setzero_ps();
+				__m128 curveDerivative = _mm_setzero_ps();
+				for (int j = 0; j < 4; j++) {
+					__m128 controlPoint = _mm_set1_ps(controlPoints[i][j](c));
+					curvePoint = _mm_add_ps(curvePoint, _mm_mul_ps(uWeights[j], controlPoint));
+					curveDerivative = _mm_add_ps(curveDerivative, _mm_mul_ps(uDerivativeWeights[j], controlPoint));
+				}
+
+				// ...then blend the curves together in v
+				point[c] = _mm_add_ps(point[c], _mm_mul_ps(vWeights[i], curvePoint));
+				uDerivative[c] = _mm_add_ps(uDerivative[c], _mm_mul_ps(vWeights[i], curveDerivative));
+				vDerivative[c] = _mm_add_ps(vDerivative[c], _mm_mul_ps(vDerivativeWeights[i], curvePoint));
+			}
+		}
+
+		// Take cross product of partials to find normal, then normalize it
+		__m128 nx = _mm_sub_ps(_mm_mul_ps(uDerivative[1], vDerivative[2]), _mm_mul_ps(uDerivative[2], vDerivative[1]));
+		__m128 ny = _mm_sub_ps(_mm_mul_ps(uDerivative[2], vDerivative[0]), _mm_mul_ps(uDerivative[0], vDerivative[2]));
+		__m128 nz = _mm_sub_ps(_mm_mul_ps(uDerivative[0], vDerivative[1]), _mm_mul_ps(uDerivative[1], vDerivative[0]));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+
+		_mm_store_ps(packet.x + first, point[0]);
+		_mm_store_ps(packet.y + first, point[1]);
+		_mm_store_ps(packet.z + first, point[2]);
+		_mm_store_ps(packet.nx + first, _mm_div_ps(nx, length));
+		_mm_store_ps(packet.ny + first, _mm_div_ps(ny, length));
+		_mm_store_ps(packet.nz + first, _mm_div_ps(nz, length));
+	}
+
+	//****************************************************
+	// AVX kernel: evaluates all 8 lanes of 'packet'. Same arithmetic as evaluatePacketSSE.
+	//***************************************************
+	BEZIER_PATCH_AVX_TARGET void evaluatePacketAVX(SamplePacket &packet) {
+		__m256 one = _mm256_set1_ps(1.0f);
+		__m256 three = _mm256_set1_ps(3.0f);
+		__m256 six = _mm256_set1_ps(6.0f);
+
+		// Bernstein weights (and derivatives) for the eight lanes, in u and in v
+		__m256 uWeights[4], uDerivativeWeights[4], vWeights[4], vDerivativeWeights[4];
+		__m256 t[2] = { _mm256_load_ps(packet.u), _mm256_load_ps(packet.v) };
+		__m256 *weights[2] = { uWeights, vWeights };
+		__m256 *derivativeWeights[2] = { uDerivativeWeights, vDerivativeWeights };
+		for (int d = 0; d < 2; d++) {
+			__m256 s = _mm256_sub_ps(one, t[d]);
+			__m256 ss = _mm256_mul_ps(s, s);
+			__m256 tt = _mm256_mul_ps(t[d], t[d]);
+			__m256 ts = _mm256_mul_ps(t[d], s);
+			weights[d][0] = _mm256_mul_ps(ss, s);
+			weights[d][1] = _mm256_mul_ps(three, _mm256_mul_ps(t[d], ss));
+			weights[d][2] = _mm256_mul_ps(three, _mm256_mul_ps(tt, s));
+			weights[d][3] = _mm256_mul_ps(tt, t[d]);
+			derivativeWeights[d][0] = _mm256_mul_ps(_mm256_set1_ps(-3.0f), ss);
+			derivativeWeights[d][1] = _mm256_sub_ps(_mm256_mul_ps(three, ss), _mm256_mul_ps(six, ts));
+			derivativeWeights[d][2] = _mm256_sub_ps(_mm256_mul_ps(six, ts), _mm256_mul_ps(three, tt));
+			derivativeWeights[d][3] = _mm256_mul_ps(three, tt);
+		}
+
+		__m256 point[3], uDerivative[3], vDerivative[3];
+		for (int c = 0; c < 3; c++) {
+			point[c] = uDerivative[c] = vDerivative[c] = _mm256_setzero_ps();
+		}
+
+		for (int i = 0; i < 4; i++) {
+			for (int c = 0; c < 3; c++) {
+				__m256 curvePoint = _mm256_setzero_ps();
+				__m256 curveDerivative = _mm256_setzero_ps();
+				for (int j = 0; j < 4; j++) {
+					__m256 controlPoint = _mm256_set1_ps(controlPoints[i][j](c));
+					curvePoint = _mm256_add_ps(curvePoint, _mm256_mul_ps(uWeights[j], controlPoint));
+					curveDerivative = _mm256_add_ps(curveDerivative, _mm256_mul_ps(uDerivativeWeights[j], controlPoint));
+				}
+
+				point[c] = _mm256_add_ps(point[c], _mm256_mul_ps(vWeights[i], curvePoint));
+				uDerivative[c] = _mm256_add_ps(uDerivative[c], _mm256_mul_ps(vWeights[i], curveDerivative));
+				vDerivative[c] = _mm256_add_ps(vDerivative[c], _mm256_mul_ps(vDerivativeWeights[i], curvePoint));
+			}
+		}
+
+		__m256 nx = _mm256_sub_ps(_mm256_mul_ps(uDerivative[1], vDerivative[2]), _mm256_mul_ps(uDerivative[2], vDerivative[1]));
+		__m256 ny = _mm256_sub_ps(_mm256_mul_ps(uDerivative[2], vDerivative[0]), _mm256_mul_ps(uDerivative[0], vDerivative[2]));
+		__m256 nz = _mm256_sub_ps(_mm256_mul_ps(uDerivative[0], vDerivative[1]), _mm256_mul_ps(uDerivative[1], vDerivative[0]));
+		__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz)));
+
+		_mm256_store_ps(packet.x, point[0]);
+		_mm256_store_ps(packet.y, point[1]);
+		_mm256_store_ps(packet.z, point[2]);
+		_mm256_store_ps(packet.nx, _mm256_div_ps(nx, length));
+		_mm256_store_ps(packet.ny, _mm256_div_ps(ny, length));
+		_mm256_store_ps(packet.nz, _mm256_div_ps(nz, length));
+	}
+#endif
+
+
+	//****************************************************
+	// Evaluates 'this' BezierPatch at every (uValues[k], vValues[l]) pair and appends the results
+	// to 'grid' in u-major order (i.e. the result for (k, l) lands at index k * vValues.size() + l),
+	// in one batch of matrix products (see BezierSurface::evaluateGrid)
+	//***************************************************
+	template <class List>
+	void evaluateGrid(const Eigen::Ref<const Eigen::VectorXf> &uValues, const Eigen::Ref<const Eigen::VectorXf> &vValues,
+			List &grid) {
+		size_t first = grid.size();
+		grid.resize(first + uValues.size() * vValues.size());
+		if (grid.size() > first) {
+			evaluateGrid(uValues, vValues, &grid[first]);
+		}
+	}
+
+
+	//****************************************************
+	// Same as above, but writes the uValues.size() * vValues.size() results to 'grid'
+	//***************************************************
+	void evaluateGrid(const Eigen::Ref<const Eigen::VectorXf> &uValues, const Eigen::Ref<const Eigen::VectorXf> &vValues,
+			DifferentialGeometry *grid) {
+		if (isPolynomialBicubic()) {
+			BezierSurface<3, 3>::evaluateGrid(controlPoints, uValues, vValues, grid);
+			return;
+		}
+		GridEvaluation evaluation(*this, uValues, vValues, grid);
+		visitBezierDegrees(degreeU, degreeV, evaluation);
+	}
+
+
+	//****************************************************
+	// Same as evaluateGrid (uValues.size() * vValues.size() results written to 'grid' in u-major order),
+	// but with whichever evaluator 'evaluationMethod' selects
+	//***************************************************
+	void evaluateGridWithEvaluationMethod(const Eigen::Ref<const Eigen::VectorXf> &uValues,
+			const Eigen::Ref<const Eigen::VectorXf> &vValues, DifferentialGeometry *grid) {
+		int numberOfU = uValues.size();
+		int numberOfV = vValues.size();
+		if (numberOfU == 0 || numberOfV == 0) {
+			return;
+		}
 
-		CurveLocalGeometry finalVCurve = interpretBezierCurve(vCurve, v);
-		CurveLocalGeometry finalUCurve = interpretBezierCurve(uCurve, u);
+		if (evaluationMethod == BERNSTEIN) {
+			evaluateGrid(uValues, vValues, grid);
+		} else if (evaluationMethod == SIMD) {
+			int numberOfSamples = numberOfU * numberOfV;
+			int written = 0;
 
-		// Take cross product of partials to find normal
-		Eigen::Vector3f normal = finalUCurve.derivative.cross(finalVCurve.derivative);
-		normal.normalize();
+			SamplePacket packet;
+			for (int sample = 0; sample < numberOfSamples; sample++) {
+				packet.addSample(uValues(sample / numberOfV), vValues(sample % numberOfV));
 
-		return DifferentialGeometry(finalUCurve.point, normal, Eigen::Vector2f(u, v));
+				if (packet.count == SamplePacket::MAX_SIZE || sample == numberOfSamples - 1) {
+					evaluatePacket(packet);
+					for (int i = 0; i < packet.count; i++) {
+						grid[written++] = packet.getDifferentialGeometry(i);
+					}
+					packet.count = 0;
+				}
+			}
+		} else {
+			for (int k = 0; k < numberOfU; k++) {
+				for (int l = 0; l < numberOfV; l++) {
+					grid[k * numberOfV + l] = evaluateDifferentialGeometry(uValues(k), vValues(l));
+				}
+			}
+		}
+	}
+
+
+	//****************************************************
+	// Method that generates a DifferentialGeometry object that represents
+	// the result of evaluating 'this' BezierPatch at (u, v) by repeated de Casteljau reduction
+	//
+	// NOTE: This method is given in the last slide of CS184 Spring 2015 Lecture 14 (O'Brien).
+	//       A rational patch is reduced the same way in homogeneous coordinates
+	//***************************************************
+	DifferentialGeometry evaluateDifferentialGeometryDeCasteljau(float u, float v) {
+		if (rational) {
+			return evaluateDeCasteljau(getHomogeneousControlPoints(), u, v);
+		}
+		return evaluateDeCasteljau(controlPoints, u, v);
+	}
+
+	template <class Point>
+	DifferentialGeometry evaluateDeCasteljau(const Point (&controlPoints)[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1],
+			float u, float v) {
+		// (zeroed only so that the compiler can see every point read below is set)
+		Point vCurve[MAX_BEZIER_DEGREE + 1], uCurve[MAX_BEZIER_DEGREE + 1], acrossCurves[MAX_BEZIER_DEGREE + 1];
+		for (int k = 0; k <= MAX_BEZIER_DEGREE; k++) {
+			vCurve[k] = uCurve[k] = acrossCurves[k] = Point::Zero();
+		}
+		Point derivative;
+
+		// Build control points for a Bezier curve in v (controlPoints[i] is the i-th curve)
+		for (int i = 0; i <= degreeV; i++) {
+			reduceBezierCurve(controlPoints[i], degreeU, u, vCurve[i], derivative);
+		}
+
+		// Build control points for a Bezier curve in u (from the j-th point of every curve)
+		for (int j = 0; j <= degreeU; j++) {
+			for (int i = 0; i <= degreeV; i++) {
+				acrossCurves[i] = controlPoints[i][j];
+			}
+			reduceBezierCurve(acrossCurves, degreeV, v, uCurve[j], derivative);
+		}
+
+		// Evaluate surface and derivative for u and v
+		Point vPoint, vDerivative, uPoint, uDerivative;
+		reduceBezierCurve(vCurve, degreeV, v, vPoint, vDerivative);
+		reduceBezierCurve(uCurve, degreeU, u, uPoint, uDerivative);
+
+		return toDifferentialGeometry(uPoint, uDerivative, vDerivative, u, v);
 	}
 
 
@@ -152,125 +757,189 @@ class BezierPatch {
 	// and list of Triangles, based on adaptive subdivision
 	//***************************************************
 	void performAdaptiveSubdivision(float error) {
+		TessellationArena &arena = TessellationArena::forThisThread();
+		TessellationArena::Scope scope(arena);
+		TriangleQueue queueOfTriangles(arena);
 
+		// Replace any earlier tessellation (the midpoints evaluated for it stay memoized)
+		listOfDifferentialGeometries.clear();
+		listOfTriangleIndices.clear();
+		listOfTriangleDepths.clear();
+		midpointCache.forgetVertices();
+
+		uint32_t first = 0;
 		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(0, 0));
 		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(0, 1));
 		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(1, 0));
 		listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(1, 1));
+		numberOfSurfaceEvaluations += 4;
 
-		queueOfTriangles.push(Triangle(listOfDifferentialGeometries[1], listOfDifferentialGeometries[2], listOfDifferentialGeometries[0]));
-		queueOfTriangles.push(Triangle(listOfDifferentialGeometries[2], listOfDifferentialGeometries[1], listOfDifferentialGeometries[3]));
-
-		DifferentialGeometry midpointInterpolatedValueAB;
-		DifferentialGeometry midpointInterpolatedValueBC;
-		DifferentialGeometry midpointInterpolatedValueAC;
+		queueOfTriangles.push_back(IndexedTriangle(first + 1, first + 2, first + 0));
+		queueOfTriangles.push_back(IndexedTriangle(first + 2, first + 1, first + 3));
 
-		while (!queueOfTriangles.empty()) {
-
-			Triangle currentTriangleToTest = queueOfTriangles.front();
-			DifferentialGeometry pointA = currentTriangleToTest.point1;
-			DifferentialGeometry pointB = currentTriangleToTest.point2;
-			DifferentialGeometry pointC = currentTriangleToTest.point3;
-			queueOfTriangles.pop();
-
-			bool abSplit = false;
-			bool bcSplit = false;
-			bool acSplit = false;
-
-			// Checking whether A -> B needs to be split
-			Eigen::Vector2f uvValueToInterpolate = (pointA.uvValues + pointB.uvValues)/2.0f;
-			midpointInterpolatedValueAB = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
-
-			Eigen::Vector3f midpointApproximatedValue = (pointB.position - pointA.position)/2.0f + (pointA.position);
+		subdivideQueuedTriangles(error, queueOfTriangles);
+		tessellationParameter = error;
+		uniformSteps = 0;
+		if (screenSpaceError) {
+			tessellatedErrorScale = computeNearestPixelSize(depthRow, worldErrorPerPixel, minimumDepth);
+		}
+	}
 
-			Eigen::Vector3f errorVector = midpointInterpolatedValueAB.position - midpointApproximatedValue;
-			float errorValue = sqrt(errorVector.dot(errorVector));
 
+	//****************************************************
+	// Splits the triangles in queueOfTriangles (and the triangles they split into) until every
+	// edge is within 'error' of the surface, adding the final triangles to listOfTriangleIndices.
+	// Breadth-first subdivision takes triangles from the front of the queue; depth-first subdivision
+	// takes them from the back, so the queue only ever holds O(depth) triangles
+	//***************************************************
+	void subdivideQueuedTriangles(float error, TriangleQueue &queueOfTriangles) {
+		while (!queueOfTriangles.empty()) {
+			peakFrontierSize = std::max(peakFrontierSize, (long) queueOfTriangles.size());
 
-			if (errorValue >= error) {
-				abSplit = true;
+			IndexedTriangle currentTriangleToTest;
+			if (depthFirstSubdivision) {
+				currentTriangleToTest = queueOfTriangles.back();
+				queueOfTriangles.pop_back();
+			} else {
+				currentTriangleToTest = queueOfTriangles.front();
+				queueOfTriangles.pop_front();
 			}
+			uint32_t a = currentTriangleToTest.index1;
+			uint32_t b = currentTriangleToTest.index2;
+			uint32_t c = currentTriangleToTest.index3;
+			uint32_t childDepth = currentTriangleToTest.depth + 1;
+			DifferentialGeometry pointA = listOfDifferentialGeometries[a];
+			DifferentialGeometry pointB = listOfDifferentialGeometries[b];
+			DifferentialGeometry pointC = listOfDifferentialGeometries[c];
 
-			// Checking whether B -> C needs to be split
-			uvValueToInterpolate = (pointB.uvValues + pointC.uvValues)/2.0f;
-			midpointInterpolatedValueBC = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
+			// Look up the edges A -> B, B -> C and A -> C in the midpoint cache. Only edges that no triangle
+			// has tested before need their midpoint evaluated (with the SIMD evaluator, as one packet)
+			const DifferentialGeometry *endpoints[3][2] = { { &pointA, &pointB }, { &pointB, &pointC }, { &pointA, &pointC } };
+			EdgeMidpointCache::Entry *edges[3];
+			int edgesToEvaluate[3];
+			int numberOfEdgesToEvaluate = 0;
+			for (int e = 0; e < 3; e++) {
+				bool found;
+				edges[e] = &midpointCache.findOrInsert(endpoints[e][0]->uvValues, endpoints[e][1]->uvValues, found);
+				if (!found) {
+					edgesToEvaluate[numberOfEdgesToEvaluate++] = e;
+				}
+			}
 
-			midpointApproximatedValue = (pointC.position - pointB.position)/2.0f + (pointB.position);
+			if (evaluationMethod == SIMD && numberOfEdgesToEvaluate > 0) {
+				SamplePacket packet;
+				for (int k = 0; k < numberOfEdgesToEvaluate; k++) {
+					const DifferentialGeometry **edge = endpoints[edgesToEvaluate[k]];
+					Eigen::Vector2f uvValueToInterpolate = (edge[0]->uvValues + edge[1]->uvValues)/2.0f;
+					packet.addSample(uvValueToInterpolate.x(), uvValueToInterpolate.y());
+				}
+				evaluatePacket(packet);
+				for (int k = 0; k < numberOfEdgesToEvaluate; k++) {
+					edges[edgesToEvaluate[k]]->midpoint = packet.getDifferentialGeometry(k);
+				}
+			} else {
+				for (int k = 0; k < numberOfEdgesToEvaluate; k++) {
+					const DifferentialGeometry **edge = endpoints[edgesToEvaluate[k]];
+					Eigen::Vector2f uvValueToInterpolate = (edge[0]->uvValues + edge[1]->uvValues)/2.0f;
+					edges[edgesToEvaluate[k]]->midpoint = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
+				}
+			}
+			numberOfSurfaceEvaluations += numberOfEdgesToEvaluate;
 
-			errorVector = midpointInterpolatedValueBC.position - midpointApproximatedValue;
-			errorValue = sqrt(errorVector.dot(errorVector));
+			// Measure how far each newly evaluated midpoint is from the midpoint of its straight edge
+			for (int k = 0; k < numberOfEdgesToEvaluate; k++) {
+				const DifferentialGeometry **edge = endpoints[edgesToEvaluate[k]];
+				Eigen::Vector3f midpointApproximatedValue = (edge[1]->position - edge[0]->position)/2.0f + (edge[0]->position);
 
-			if (errorValue >= error) {
-				bcSplit = true;
+				Eigen::Vector3f errorVector = edges[edgesToEvaluate[k]]->midpoint.position - midpointApproximatedValue;
+				edges[edgesToEvaluate[k]]->errorValue = sqrt(errorVector.dot(errorVector));
 			}
 
-			// Checking whether A -> C needs to be split
-			uvValueToInterpolate = (pointA.uvValues + pointC.uvValues)/2.0f;
-			midpointInterpolatedValueAC = evaluateDifferentialGeometry(uvValueToInterpolate.x(), uvValueToInterpolate.y());
+			EdgeMidpointCache::Entry &edgeAB = *edges[0];
+			EdgeMidpointCache::Entry &edgeBC = *edges[1];
+			EdgeMidpointCache::Entry &edgeAC = *edges[2];
 
-			midpointApproximatedValue = (pointC.position - pointA.position)/2.0f + (pointA.position);
+			// Checking whether A -> B, B -> C and A -> C need to be split
+			// (with screen-space error, against the error in pixels at the midpoint's depth)
+			bool abSplit = edgeAB.errorValue >= error * getErrorScale(edgeAB.midpoint.position);
+			bool bcSplit = edgeBC.errorValue >= error * getErrorScale(edgeBC.midpoint.position);
+			bool acSplit = edgeAC.errorValue >= error * getErrorScale(edgeAC.midpoint.position);
 
-			errorVector = midpointInterpolatedValueAC.position - midpointApproximatedValue;
-			errorValue = sqrt(errorVector.dot(errorVector));
-			if (errorValue >= error) {
-				acSplit = true;
+			// Stop splitting once we hit the depth limit, even if the triangle is still too coarse
+			if (maxSubdivisionDepth > 0 && currentTriangleToTest.depth >= (uint32_t) maxSubdivisionDepth) {
+				abSplit = bcSplit = acSplit = false;
 			}
 
+			// Never split past the resolution of midpointCache's (u, v) grid. Normally no edge gets anywhere near it,
+			// but triangles next to an edge whose midpoint test can't see its curvature (e.g. a straight boundary
+			// with a symmetric parametrization, as degenerate patches have) would otherwise keep splitting towards it
+			abSplit = abSplit && EdgeMidpointCache::canSplit(pointA.uvValues, pointB.uvValues);
+			bcSplit = bcSplit && EdgeMidpointCache::canSplit(pointB.uvValues, pointC.uvValues);
+			acSplit = acSplit && EdgeMidpointCache::canSplit(pointA.uvValues, pointC.uvValues);
+
 			// Case 1
 			if (!abSplit && !bcSplit && !acSplit) {
-				listOfTriangles.push_back(currentTriangleToTest);
+				numberOfTrianglesPerCase[0]++;
+				addTriangle(currentTriangleToTest);
 			}
 			// Case 2
 			else if (!abSplit && !bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				queueOfTriangles.push(Triangle(pointA, pointB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, pointB, pointC));
+				numberOfTrianglesPerCase[1]++;
+				uint32_t ac = getMidpointVertex(edgeAC);
+				queueOfTriangles.push_back(IndexedTriangle(a, b, ac, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ac, b, c, childDepth));
 			}
 			// Case 3
 			else if (abSplit && !bcSplit && !acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, pointC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, pointC));
+				numberOfTrianglesPerCase[2]++;
+				uint32_t ab = getMidpointVertex(edgeAB);
+				queueOfTriangles.push_back(IndexedTriangle(a, ab, c, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ab, b, c, childDepth));
 			}
 			// Case 4
 			else if (!abSplit && bcSplit && !acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				queueOfTriangles.push(Triangle(pointA, pointB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueBC, pointC));
+				numberOfTrianglesPerCase[3]++;
+				uint32_t bc = getMidpointVertex(edgeBC);
+				queueOfTriangles.push_back(IndexedTriangle(a, b, bc, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(a, bc, c, childDepth));
 			}
 			// Case 5
 			else if (abSplit && !bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueAB, pointC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, pointC));
+				numberOfTrianglesPerCase[4]++;
+				uint32_t ab = getMidpointVertex(edgeAB);
+				uint32_t ac = getMidpointVertex(edgeAC);
+				queueOfTriangles.push_back(IndexedTriangle(a, ab, ac, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ac, ab, c, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ab, b, c, childDepth));
 			}
 			// Case 6
 			else if (abSplit && bcSplit && !acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueBC, pointC));
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, midpointInterpolatedValueBC));
+				numberOfTrianglesPerCase[5]++;
+				uint32_t ab = getMidpointVertex(edgeAB);
+				uint32_t bc = getMidpointVertex(edgeBC);
+				queueOfTriangles.push_back(IndexedTriangle(a, bc, c, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(a, ab, bc, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ab, b, bc, childDepth));
 			}
 			// Case 7
 			else if (!abSplit && bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				queueOfTriangles.push(Triangle(pointA, pointB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, pointB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueBC, pointC));
+				numberOfTrianglesPerCase[6]++;
+				uint32_t ac = getMidpointVertex(edgeAC);
+				uint32_t bc = getMidpointVertex(edgeBC);
+				queueOfTriangles.push_back(IndexedTriangle(a, b, ac, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ac, b, bc, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ac, bc, c, childDepth));
 			}
 			// Case 8
 			else if (abSplit && bcSplit && acSplit) {
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAC);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueBC);
-				listOfDifferentialGeometries.push_back(midpointInterpolatedValueAB);
-				queueOfTriangles.push(Triangle(pointA, midpointInterpolatedValueAB, midpointInterpolatedValueAC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAB, pointB, midpointInterpolatedValueBC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueBC, pointC));
-				queueOfTriangles.push(Triangle(midpointInterpolatedValueAC, midpointInterpolatedValueAB, midpointInterpolatedValueBC));
+				numberOfTrianglesPerCase[7]++;
+				uint32_t ac = getMidpointVertex(edgeAC);
+				uint32_t bc = getMidpointVertex(edgeBC);
+				uint32_t ab = getMidpointVertex(edgeAB);
+				queueOfTriangles.push_back(IndexedTriangle(a, ab, ac, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ab, b, bc, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ac, bc, c, childDepth));
+				queueOfTriangles.push_back(IndexedTriangle(ac, ab, bc, childDepth));
 			}
 		}
 		// Algorithm:
@@ -309,35 +978,247 @@ class BezierPatch {
 		//          if (errorValue >= error):
 		//              then we need to mark (X -> Y) as NEEDING TO BE SPLIT
 		//
+		//          (the midpoint and errorValue of each edge are memoized in midpointCache, so the other
+		//           triangle that shares (X -> Y) reuses them, and the same midpoint vertex, instead of re-evaluating)
+		//
 		//    now, we have 3 boolean variables that correspond to whether (A -> B), (A -> C), (B -> C) need to be split.
 		//    this corresponds with 8 total cases.
 		//
 		//    based on these 8 cases, we simply add relevant vertices to listOfDiferentialGeometries
-		//    and add newly split triangles to our triangle queue as specified in the lecture slides
+		//    and add newly split triangles (as indices of their vertices) to our triangle queue as specified in the lecture slides
 		//
 		//    (if all 3 boolean variables are false, i.e. no splits necessary, then we add our popped triangle
-		//     to the current bezier patch's listOfTriangles)
+		//     to the current bezier patch's listOfTriangleIndices)
 	}
 
 
 	//****************************************************
-	// Method that populates each BezierPatch's list of DifferentialGeometries
-	// and list of Triangles, based on uniform subdivision
+	// Re-tessellates an adaptively subdivided patch for a new error tolerance, redoing as little as possible.
+	//
+	// A smaller error only ever splits triangles further, so refining continues from the current
+	// triangles (and keeps every vertex). A larger error starts over from the corners, but every edge
+	// tested so far is still in midpointCache, so coarsening evaluates almost nothing.
+	// Screen-space error always starts over, since a new view can make some parts coarser and others finer.
+	// So does a depth limit: a leaf already at maxSubdivisionDepth can't split its edges, so refining from the
+	// leaves could let a shallower neighbor split an edge they share and leave a T-junction
 	//***************************************************
-	void performUniformSubdivision(float stepSize) {
-		float epsilon = 0.001f;
-		int numberOfSteps = (1.0 + epsilon) / stepSize;
+	void retessellateAdaptive(float error) {
+		if (!screenSpaceError && maxSubdivisionDepth == 0 && error < tessellationParameter && uniformSteps == 0
+				&& listOfTriangleDepths.size() * 3 == listOfTriangleIndices.size()) {
+			TessellationArena &arena = TessellationArena::forThisThread();
+			TessellationArena::Scope scope(arena);
+
+			// Move the current triangles aside, keeping the lists' capacity for the refined ones
+			size_t numberOfTriangles = listOfTriangleDepths.size();
+			uint32_t *triangles = arena.allocate<uint32_t>(3 * numberOfTriangles);
+			uint32_t *depths = arena.allocate<uint32_t>(numberOfTriangles);
+			std::copy(listOfTriangleIndices.begin(), listOfTriangleIndices.end(), triangles);
+			std::copy(listOfTriangleDepths.begin(), listOfTriangleDepths.end(), depths);
+			listOfTriangleIndices.clear();
+			listOfTriangleDepths.clear();
+
+			// One triangle at a time, so that depth-first subdivision still only holds O(depth) triangles
+			TriangleQueue queueOfTriangles(arena);
+			for (size_t t = 0; t < numberOfTriangles; t++) {
+				queueOfTriangles.push_back(IndexedTriangle(triangles[3 * t], triangles[3 * t + 1], triangles[3 * t + 2], depths[t]));
+				subdivideQueuedTriangles(error, queueOfTriangles);
+			}
+			tessellationParameter = error;
+		} else {
+			performAdaptiveSubdivision(error);
+		}
+	}
+
+
+	//****************************************************
+	// Re-tessellates a uniformly subdivided patch with a new step size.
+	//
+	// Samples of the old grid that the new grid also has (every one of them when the new step divides
+	// the old one, e.g. when halving it; every other one of the new grid's when doubling it) are kept,
+	// so only the new grid's other rows, and the other columns of the kept rows, are evaluated.
+	//
+	// The result matches tessellating from scratch bit for bit only when the two step sizes differ by a power
+	// of two (as with '[' and ']'). Otherwise a kept sample was evaluated at its old step * the old step size,
+	// which can differ in the last bits from the new step * the new step size
+	//***************************************************
+	void retessellateUniform(float stepSize) {
+		int oldSteps = uniformSteps;
+		float oldStepSize = tessellationParameter;
+		if (oldSteps == 0 || listOfDifferentialGeometries.size() != (size_t) (oldSteps + 1) * (oldSteps + 1)) {
+			performUniformSubdivision(stepSize);
+			return;
+		}
+
+		TessellationArena &arena = TessellationArena::forThisThread();
+		TessellationArena::Scope scope(arena);
+
+		int numberOfSteps = getUniformSteps(stepSize);
+
+		// For each step along the new grid's side: which step of the old grid has the same parameter value (or -1),
+		// and its position in the list of kept or new parameter values
+		int *oldStep = arena.allocate<int>(numberOfSteps + 1);
+		int *positionInList = arena.allocate<int>(numberOfSteps + 1);
+		float *allValues = arena.allocate<float>(numberOfSteps + 1);
+		float *keptValues = arena.allocate<float>(numberOfSteps + 1);
+		float *newValues = arena.allocate<float>(numberOfSteps + 1);
+		int numberOfKeptValues = 0;
+		int numberOfNewValues = 0;
+		for (int step = 0; step <= numberOfSteps; step++) {
+			allValues[step] = step * stepSize;
+			float stepInOldGrid = step * stepSize / oldStepSize;
+			int nearestOldStep = (int) floor(stepInOldGrid + 0.5f);
+			if (fabs(stepInOldGrid - nearestOldStep) < 1e-4f && nearestOldStep <= oldSteps) {
+				oldStep[step] = nearestOldStep;
+				positionInList[step] = numberOfKeptValues;
+				keptValues[numberOfKeptValues++] = step * stepSize;
+			} else {
+				oldStep[step] = -1;
+				positionInList[step] = numberOfNewValues;
+				newValues[numberOfNewValues++] = step * stepSize;
+			}
+		}
+
+		Eigen::Map<Eigen::VectorXf> allValueVector(allValues, numberOfSteps + 1);
+		Eigen::Map<Eigen::VectorXf> keptValueVector(keptValues, numberOfKeptValues);
+		Eigen::Map<Eigen::VectorXf> newValueVector(newValues, numberOfNewValues);
+
+		// New rows (all of their columns), then the new columns of the kept rows
+		int numberOfNewRowSamples = numberOfNewValues * (numberOfSteps + 1);
+		int numberOfNewColumnSamples = numberOfKeptValues * numberOfNewValues;
+		DifferentialGeometry *newRows = arena.allocate<DifferentialGeometry>(numberOfNewRowSamples);
+		DifferentialGeometry *newColumns = arena.allocate<DifferentialGeometry>(numberOfNewColumnSamples);
+		evaluateGridWithEvaluationMethod(newValueVector, allValueVector, newRows);
+		evaluateGridWithEvaluationMethod(keptValueVector, newValueVector, newColumns);
+		numberOfSurfaceEvaluations += numberOfNewRowSamples + numberOfNewColumnSamples;
+
+		int numberOfSamples = (numberOfSteps + 1) * (numberOfSteps + 1);
+		DifferentialGeometry *grid = arena.allocate<DifferentialGeometry>(numberOfSamples);
 		for (int u = 0; u <= numberOfSteps; u++) {
 			for (int v = 0; v <= numberOfSteps; v++) {
-				// Evaluate the differential geometry at (u * stepSize, v * stepSize(
-				// For instance, if stepSize = 0.1, then we would evaluate at (0, 0), (0, 0.1), (0, 0.2), etc
-				listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(u * stepSize, v * stepSize));
+				DifferentialGeometry &sample = grid[u * (numberOfSteps + 1) + v];
+				if (oldStep[u] < 0) {
+					sample = newRows[positionInList[u] * (numberOfSteps + 1) + v];
+				} else if (oldStep[v] < 0) {
+					sample = newColumns[positionInList[u] * numberOfNewValues + positionInList[v]];
+				} else {
+					sample = listOfDifferentialGeometries[oldStep[u] * (oldSteps + 1) + oldStep[v]];
+				}
 			}
 		}
 
+		// (assign reuses the list's capacity, so going back to a step size we've had before doesn't allocate)
+		listOfDifferentialGeometries.assign(grid, grid + numberOfSamples);
+		listOfTriangleIndices.clear();
+		triangulateUniformGrid(0, numberOfSteps);
+		uniformSteps = numberOfSteps;
+		tessellationParameter = stepSize;
+	}
+
+
+	// Number of steps along each side of a uniform tessellation's grid with 'stepSize'
+	static int getUniformSteps(float stepSize) {
+		float epsilon = 0.001f;
+		return (1.0 + epsilon) / stepSize;
+	}
+
+
+	//****************************************************
+	// Exactly how many vertices and triangle indices performUniformSubdivision(stepSize) produces
+	// (the same for every patch)
+	//***************************************************
+	static void getUniformTessellationSize(float stepSize, size_t &numberOfVertices, size_t &numberOfIndices) {
+		size_t numberOfSteps = getUniformSteps(stepSize);
+		numberOfVertices = (numberOfSteps + 1) * (numberOfSteps + 1);
+		numberOfIndices = 6 * numberOfSteps * numberOfSteps;
+	}
+
+
+	//****************************************************
+	// Upper bounds on how many vertices and triangle indices adaptive subdivision can produce, whatever
+	// the error. Only with a maxSubdivisionDepth of D is there one: each split at most quadruples a
+	// triangle, so there are at most 2 * 4^D triangles, and every vertex lies on the (2^D + 1) x (2^D + 1)
+	// grid of (u, v) values that D halvings can reach. Returns false (and no bounds) without a depth limit
+	//***************************************************
+	bool getAdaptiveTessellationBound(size_t &numberOfVertices, size_t &numberOfIndices) {
+		if (maxSubdivisionDepth <= 0 || maxSubdivisionDepth > 30) {
+			return false;
+		}
+		size_t sidesPerEdge = (size_t) 1 << maxSubdivisionDepth;
+		numberOfVertices = (sidesPerEdge + 1) * (sidesPerEdge + 1);
+		numberOfIndices = 3 * 2 * sidesPerEdge * sidesPerEdge;
+		return true;
+	}
+
+
+	//****************************************************
+	// Method that populates each BezierPatch's list of DifferentialGeometries
+	// and list of Triangles, based on uniform subdivision (replacing any earlier tessellation).
+	// Both lists are sized exactly up front, so if they're attached to big enough slices
+	// (see getUniformTessellationSize) the tessellation is written straight into them
+	//***************************************************
+	void performUniformSubdivision(float stepSize) {
+		int numberOfSteps = getUniformSteps(stepSize);
+		size_t numberOfVertices, numberOfIndices;
+		getUniformTessellationSize(stepSize, numberOfVertices, numberOfIndices);
+		listOfDifferentialGeometries.clear();
+		listOfTriangleIndices.clear();
+		listOfTriangleDepths.clear();
+		listOfDifferentialGeometries.reserve(numberOfVertices);
+		listOfTriangleIndices.reserve(numberOfIndices);
+
+		uint32_t first = 0;
+		numberOfSurfaceEvaluations += (numberOfSteps + 1) * (numberOfSteps + 1);
+
+		if (evaluationMethod == DE_CASTELJAU) {
+			for (int u = 0; u <= numberOfSteps; u++) {
+				for (int v = 0; v <= numberOfSteps; v++) {
+					// Evaluate the differential geometry at (u * stepSize, v * stepSize(
+					// For instance, if stepSize = 0.1, then we would evaluate at (0, 0), (0, 0.1), (0, 0.2), etc
+					listOfDifferentialGeometries.push_back(evaluateDifferentialGeometry(u * stepSize, v * stepSize));
+				}
+			}
+		} else if (evaluationMethod == SIMD) {
+			// Walk the grid in the same order as above, one SamplePacket at a time
+			int numberOfSamples = (numberOfSteps + 1) * (numberOfSteps + 1);
+
+			SamplePacket packet;
+			for (int sample = 0; sample < numberOfSamples; sample++) {
+				packet.addSample((sample / (numberOfSteps + 1)) * stepSize, (sample % (numberOfSteps + 1)) * stepSize);
+
+				if (packet.count == SamplePacket::MAX_SIZE || sample == numberOfSamples - 1) {
+					evaluatePacket(packet);
+					for (int i = 0; i < packet.count; i++) {
+						listOfDifferentialGeometries.push_back(packet.getDifferentialGeometry(i));
+					}
+					packet.count = 0;
+				}
+			}
+		} else {
+			// Evaluate the whole (numberOfSteps + 1) x (numberOfSteps + 1) grid at once, in the same order as above
+			TessellationArena &arena = TessellationArena::forThisThread();
+			TessellationArena::Scope scope(arena);
+			Eigen::Map<Eigen::VectorXf> parameterValues(arena.allocate<float>(numberOfSteps + 1), numberOfSteps + 1);
+			for (int step = 0; step <= numberOfSteps; step++) {
+				parameterValues(step) = step * stepSize;
+			}
+			evaluateGrid(parameterValues, parameterValues, listOfDifferentialGeometries);
+		}
+
+		triangulateUniformGrid(first, numberOfSteps);
+		uniformSteps = numberOfSteps;
+		tessellationParameter = stepSize;
+	}
+
+
+	//****************************************************
+	// Adds the triangles of a (numberOfSteps + 1) x (numberOfSteps + 1) grid of differential geometries
+	// that starts at index 'first' of listOfDifferentialGeometries, in the order performUniformSubdivision
+	// evaluates them
+	//***************************************************
+	void triangulateUniformGrid(uint32_t first, int numberOfSteps) {
 		// NOTE: Code confirmed as working (tested)
 		// Populate the list of Triangles, based on the list of points in listOfDifferentialGeometries
-		// By ordering above, the DifferentialGeometries are ordered with the following numbering:
+		// By the ordering performUniformSubdivision uses, the DifferentialGeometries are ordered with the following numbering:
 		//
 		// 1 6  11 16 21
 		// 2 7  12 17 22
@@ -369,27 +1250,91 @@ class BezierPatch {
 				// This index represents the TOP LEFT corner of the 4-point rectangle that is described above
 
 				// Index of listOfDifferentialGeometries that corresponds with position (u, v)
-				int differentialGeometrixIndex = (u * (numberOfSteps + 1)) + v;
+				uint32_t differentialGeometrixIndex = first + (u * (numberOfSteps + 1)) + v;
 
 				// NOTE: If stepSize = 0.2, then 1 / 0.2 = 5, but since we INCLUDE the fifth point, we actually have
 				// 36 differential geometries in our list, so if you move RIGHT one point, you have to go
 				// (numberOfSteps + 1) indexes down in the listOfDifferentialGeometries
 
 				// Construct tri-1
-				listOfTriangles.push_back(Triangle(
-						listOfDifferentialGeometries[differentialGeometrixIndex + numberOfSteps + 1], // top right
-						listOfDifferentialGeometries[differentialGeometrixIndex], // top left
-						listOfDifferentialGeometries[differentialGeometrixIndex + 1])); // bottom left
+				addTriangle(
+						differentialGeometrixIndex + numberOfSteps + 1, // top right
+						differentialGeometrixIndex, // top left
+						differentialGeometrixIndex + 1); // bottom left
 
 				// Construct tri-2
-				listOfTriangles.push_back(Triangle(
-						listOfDifferentialGeometries[differentialGeometrixIndex + numberOfSteps + 1], // top right
-						listOfDifferentialGeometries[differentialGeometrixIndex + 1], // bottom left
-						listOfDifferentialGeometries[differentialGeometrixIndex + numberOfSteps + 2])); // bottom right
+				addTriangle(
+						differentialGeometrixIndex + numberOfSteps + 1, // top right
+						differentialGeometrixIndex + 1, // bottom left
+						differentialGeometrixIndex + numberOfSteps + 2); // bottom right
 			}
 		}
 		// We should have (numberOfSteps - 1) * (numberOfSteps - 1) * 2 triangles
 	}
+
+	private:
+		// Holds the homogeneous control points of a rational patch (see getHomogeneousControlPoints). homogeneousGrid
+		// has one of these only once the patch is rational, so polynomial patches don't carry 36 Vector4f they never
+		// use, and keeps it in Eigen's 16-byte aligned storage, which the plain std::vectors of BezierPatches don't give
+		class HomogeneousGrid {
+			public:
+				BezierHomogeneousGrid points;
+		};
+		std::vector<HomogeneousGrid, Eigen::aligned_allocator<HomogeneousGrid> > homogeneousGrid;
+
+		// visitBezierDegrees visitors that run one BezierSurface evaluator for a patch that isn't a
+		// polynomial bicubic, on its homogeneous control points if it is rational
+		class PointEvaluation {
+			public:
+				const BezierPatch &patch;
+				float u, v;
+				DifferentialGeometry result;
+
+			PointEvaluation(const BezierPatch &patch, float u, float v) : patch(patch) {
+				this->u = u;
+				this->v = v;
+			}
+
+			template <int DegreeU, int DegreeV>
+			void visit() {
+				result = patch.rational ? BezierSurface<DegreeU, DegreeV>::evaluate(patch.getHomogeneousControlPoints(), u, v)
+						: BezierSurface<DegreeU, DegreeV>::evaluate(patch.controlPoints, u, v);
+			}
+		};
+
+		class GridEvaluation {
+			public:
+				const BezierPatch &patch;
+				const Eigen::Ref<const Eigen::VectorXf> &uValues;
+				const Eigen::Ref<const Eigen::VectorXf> &vValues;
+				DifferentialGeometry *grid;
+
+			GridEvaluation(const BezierPatch &patch, const Eigen::Ref<const Eigen::VectorXf> &uValues,
+					const Eigen::Ref<const Eigen::VectorXf> &vValues, DifferentialGeometry *grid)
+					: patch(patch), uValues(uValues), vValues(vValues) {
+				this->grid = grid;
+			}
+
+			template <int DegreeU, int DegreeV>
+			void visit() {
+				if (patch.rational) {
+					BezierSurface<DegreeU, DegreeV>::evaluateGrid(patch.getHomogeneousControlPoints(), uValues, vValues, grid);
+				} else {
+					BezierSurface<DegreeU, DegreeV>::evaluateGrid(patch.controlPoints, uValues, vValues, grid);
+				}
+			}
+		};
+
+	// Kept out of line, so that evaluateDifferentialGeometryBernstein's bicubic path stays as small as
+	// evaluating in place. Rational bicubics (the only bicubics that get here) skip the lookup too
+	BEZIER_SURFACE_NOINLINE DifferentialGeometry evaluateDifferentialGeometryOfAnyDegree(float u, float v) {
+		if (isBicubic()) {
+			return BezierSurface<3, 3>::evaluate(getHomogeneousControlPoints(), u, v);
+		}
+		PointEvaluation evaluation(*this, u, v);
+		visitBezierDegrees(degreeU, degreeV, evaluation);
+		return evaluation.result;
+	}
 };
 
 #endif /* BEZIERPATCH_H_ */
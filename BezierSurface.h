@@ -0,0 +1,339 @@
+/*
+ * BezierSurface.h
+ *
+ *  Created on: Apr 29, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef BEZIERSURFACE_H_
+#define BEZIERSURFACE_H_
+
+// The highest degree, in each direction, that a BezierPatch can have. Every patch keeps its control
+// points in a grid this big (so patches of any degree are the same size and never touch the heap), and
+// BezierPatch dispatches each degree pair from 1 to MAX_BEZIER_DEGREE to its own BezierSurface
+const int MAX_BEZIER_DEGREE = 5;
+
+// controlPoints[i][j] is the j-th point (along u) of the i-th curve (along v)
+typedef Eigen::Vector3f BezierControlGrid[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1];
+
+// The same grid for a rational patch, with each point p of weight w stored in homogeneous form (w p, w)
+typedef Eigen::Vector4f BezierHomogeneousGrid[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1];
+
+// The single-point evaluators are inlined into their callers whatever their unrolled size, so that
+// BezierPatch's bicubic path costs no more than evaluating in place. Their loops over control points
+// are unrolled outright (GCC otherwise keeps the loop over curves, since its trip count looks big enough)
+#if defined(__GNUC__)
+#define BEZIER_SURFACE_INLINE inline __attribute__((always_inline))
+#define BEZIER_SURFACE_NOINLINE __attribute__((noinline))
+#else
+#define BEZIER_SURFACE_INLINE inline
+#define BEZIER_SURFACE_NOINLINE
+#endif
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define BEZIER_SURFACE_UNROLL _Pragma("GCC unroll 8")
+#else
+#define BEZIER_SURFACE_UNROLL
+#endif
+
+
+//****************************************************
+// n choose k, at compile time
+//***************************************************
+constexpr int binomialCoefficient(int n, int k) {
+	return (k < 0 || k > n) ? 0 : ((k == 0 || k == n) ? 1 : binomialCoefficient(n - 1, k - 1) + binomialCoefficient(n - 1, k));
+}
+
+// The integers 0 ... N - 1 as a template parameter pack (MakeIndexList<N>::Type is IndexList<0, ..., N - 1>)
+template <int... Indices>
+class IndexList {};
+
+template <int N, int... Indices>
+class MakeIndexList : public MakeIndexList<N - 1, N - 1, Indices...> {};
+
+template <int... Indices>
+class MakeIndexList<0, Indices...> {
+	public:
+		typedef IndexList<Indices...> Type;
+};
+
+// Row 'Degree' of Pascal's triangle, as a constexpr table: VALUES[k] = Degree choose k
+template <int Degree, class Indices = typename MakeIndexList<Degree + 1>::Type>
+class BinomialTable;
+
+template <int Degree, int... K>
+class BinomialTable<Degree, IndexList<K...> > {
+	public:
+		static constexpr float VALUES[Degree + 1] = { (float) binomialCoefficient(Degree, K)... };
+};
+
+template <int Degree, int... K>
+constexpr float BinomialTable<Degree, IndexList<K...> >::VALUES[Degree + 1];
+
+
+// The Bernstein polynomials of one degree, B_k(t) = (Degree choose k) t^k (1 - t)^(Degree - k).
+//
+// Every loop runs a compile-time number of times over constexpr coefficients, so it unrolls completely
+// and the binomials fold into the multiplies
+template <int Degree>
+class BernsteinBasis {
+	public:
+		static_assert(Degree >= 1, "a Bezier curve needs at least two control points");
+
+	//****************************************************
+	// Fills weights[k] = B_k(t) and derivativeWeights[k] = B_k'(t), using
+	//
+	//     B_k'(t) = Degree * (b_(k-1)(t) - b_k(t))
+	//
+	// where the b's are the Bernstein polynomials of degree Degree - 1
+	//***************************************************
+	static BEZIER_SURFACE_INLINE void evaluate(float t, float weights[Degree + 1], float derivativeWeights[Degree + 1]) {
+		float s = 1.0f - t;
+		float tPowers[Degree + 1], sPowers[Degree + 1];
+		tPowers[0] = sPowers[0] = 1.0f;
+		BEZIER_SURFACE_UNROLL
+		for (int k = 1; k <= Degree; k++) {
+			tPowers[k] = tPowers[k - 1] * t;
+			sPowers[k] = sPowers[k - 1] * s;
+		}
+
+		float lowerWeights[Degree + 1];
+		BEZIER_SURFACE_UNROLL
+		for (int k = 0; k < Degree; k++) {
+			lowerWeights[k] = BinomialTable<Degree - 1>::VALUES[k] * tPowers[k] * sPowers[Degree - 1 - k];
+		}
+		lowerWeights[Degree] = 0;
+
+		BEZIER_SURFACE_UNROLL
+		for (int k = 0; k <= Degree; k++) {
+			weights[k] = BinomialTable<Degree>::VALUES[k] * tPowers[k] * sPowers[Degree - k];
+			derivativeWeights[k] = Degree * (((k > 0) ? lowerWeights[k - 1] : 0.0f) - lowerWeights[k]);
+		}
+	}
+};
+
+// Cubics (by far the most common degree) keep their hand-expanded weights
+template <>
+class BernsteinBasis<3> {
+	public:
+
+	static BEZIER_SURFACE_INLINE void evaluate(float t, float weights[4], float derivativeWeights[4]) {
+		float s = 1.0f - t;
+
+		weights[0] = s * s * s;
+		weights[1] = 3.0f * t * s * s;
+		weights[2] = 3.0f * t * t * s;
+		weights[3] = t * t * t;
+
+		derivativeWeights[0] = -3.0f * s * s;
+		derivativeWeights[1] = 3.0f * s * s - 6.0f * t * s;
+		derivativeWeights[2] = 6.0f * t * s - 3.0f * t * t;
+		derivativeWeights[3] = 3.0f * t * t;
+	}
+};
+
+
+//****************************************************
+// The DifferentialGeometry at (u, v) of a surface whose point and partial derivatives there are
+// 'point', 'uDerivative' and 'vDerivative'
+//***************************************************
+BEZIER_SURFACE_INLINE DifferentialGeometry toDifferentialGeometry(const Eigen::Vector3f &point, const Eigen::Vector3f &uDerivative,
+		const Eigen::Vector3f &vDerivative, float u, float v) {
+	// Take cross product of partials to find normal
+	Eigen::Vector3f normal = uDerivative.cross(vDerivative);
+	normal.normalize();
+
+	return DifferentialGeometry(point, normal, Eigen::Vector2f(u, v));
+}
+
+//****************************************************
+// Same as above, for a rational surface whose point and partials are homogeneous, (w S, w). The
+// surface point is S = p / w, and by the quotient rule its partials are
+//
+//     S_u = (p_u - S w_u) / w        S_v = (p_v - S w_v) / w
+//
+// The weights are positive, so leaving out the two divisions by w only scales the (normalized) normal
+//***************************************************
+BEZIER_SURFACE_INLINE DifferentialGeometry toDifferentialGeometry(const Eigen::Vector4f &point, const Eigen::Vector4f &uDerivative,
+		const Eigen::Vector4f &vDerivative, float u, float v) {
+	Eigen::Vector3f position = point.head<3>() / point.w();
+	Eigen::Vector3f scaledPositionU = uDerivative.head<3>() - position * uDerivative.w();
+	Eigen::Vector3f scaledPositionV = vDerivative.head<3>() - position * vDerivative.w();
+	return toDifferentialGeometry(position, scaledPositionU, scaledPositionV, u, v);
+}
+
+
+// Evaluators for a tensor-product Bezier surface of one degree pair, with DegreeU + 1 points along each
+// curve and DegreeV + 1 curves. The degrees are template parameters, so every loop over control points
+// has a compile-time trip count and unrolls completely, and the bicubic instantiation does exactly the
+// arithmetic a hand-written bicubic evaluator would.
+//
+// Each evaluator takes either a BezierControlGrid or, for a rational surface, a BezierHomogeneousGrid.
+// A rational surface is the same sums over 4D homogeneous points, each one a single SIMD register,
+// projected back to 3D at the end (see toDifferentialGeometry).
+//
+// BezierPatch picks the instantiation for its degrees at runtime (see visitBezierDegrees)
+template <int DegreeU, int DegreeV>
+class BezierSurface {
+	public:
+		static_assert(DegreeU <= MAX_BEZIER_DEGREE && DegreeV <= MAX_BEZIER_DEGREE, "degree too high for a BezierControlGrid");
+
+	//****************************************************
+	// Evaluates the surface at (u, v) from the tensor-product form
+	//
+	//     S(u, v) = sum_i sum_j B_i(v) * B_j(u) * controlPoints[i][j]
+	//
+	// Both the Bernstein weights and their derivatives are computed once per call,
+	// so the position and both partials come out of a single pass over the control points
+	// with no temporaries on the heap.
+	//***************************************************
+	template <class Point>
+	static BEZIER_SURFACE_INLINE DifferentialGeometry evaluate(const Point (&controlPoints)[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1],
+			float u, float v) {
+		float uWeights[DegreeU + 1], uDerivativeWeights[DegreeU + 1];
+		float vWeights[DegreeV + 1], vDerivativeWeights[DegreeV + 1];
+		BernsteinBasis<DegreeU>::evaluate(u, uWeights, uDerivativeWeights);
+		BernsteinBasis<DegreeV>::evaluate(v, vWeights, vDerivativeWeights);
+
+		Point point = Point::Zero();
+		Point uDerivative = Point::Zero();
+		Point vDerivative = Point::Zero();
+
+		BEZIER_SURFACE_UNROLL
+		for (int i = 0; i <= DegreeV; i++) {
+			// Evaluate the i-th curve (and its derivative) in u
+			Point curvePoint = uWeights[0] * controlPoints[i][0];
+			Point curveDerivative = uDerivativeWeights[0] * controlPoints[i][0];
+			BEZIER_SURFACE_UNROLL
+			for (int j = 1; j <= DegreeU; j++) {
+				curvePoint += uWeights[j] * controlPoints[i][j];
+				curveDerivative += uDerivativeWeights[j] * controlPoints[i][j];
+			}
+
+			// ...then blend the curves together in v
+			point += vWeights[i] * curvePoint;
+			uDerivative += vWeights[i] * curveDerivative;
+			vDerivative += vDerivativeWeights[i] * curvePoint;
+		}
+
+		return toDifferentialGeometry(point, uDerivative, vDerivative, u, v);
+	}
+
+
+	//****************************************************
+	// Evaluates the surface at every (uValues[k], vValues[l]) pair and writes the results
+	// to 'grid' in u-major order (i.e. the result for (k, l) lands at index k * vValues.size() + l).
+	//
+	// Writing G for the grid of one coordinate of the control points (homogeneous coordinates, weight
+	// included, for a rational surface), and Bu / Bv for the
+	// matrices of Bernstein weights (one row per parametric value), the whole grid of that coordinate is
+	//
+	//     S = Bu * (G^T * Bv^T)
+	//
+	// so the basis matrices are built once and every sample costs a few dense multiply-adds
+	// instead of a full patch evaluation. The basis matrices and products live in the thread's TessellationArena
+	//***************************************************
+	template <class Point>
+	static void evaluateGrid(const Point (&controlPoints)[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1],
+			const Eigen::Ref<const Eigen::VectorXf> &uValues, const Eigen::Ref<const Eigen::VectorXf> &vValues,
+			DifferentialGeometry *grid) {
+		typedef Eigen::Map<Eigen::MatrixXf, Eigen::Aligned> ScratchMatrix;
+		const int numberOfCoordinates = Point::RowsAtCompileTime;
+		TessellationArena &arena = TessellationArena::forThisThread();
+		TessellationArena::Scope scope(arena);
+		int numberOfU = uValues.size();
+		int numberOfV = vValues.size();
+
+		// Build the basis matrices (and their derivatives) for both parametric directions
+		ScratchMatrix uBasis(arena.allocate<float>(numberOfU * (DegreeU + 1)), numberOfU, DegreeU + 1);
+		ScratchMatrix uDerivativeBasis(arena.allocate<float>(numberOfU * (DegreeU + 1)), numberOfU, DegreeU + 1);
+		ScratchMatrix vBasis(arena.allocate<float>(numberOfV * (DegreeV + 1)), numberOfV, DegreeV + 1);
+		ScratchMatrix vDerivativeBasis(arena.allocate<float>(numberOfV * (DegreeV + 1)), numberOfV, DegreeV + 1);
+		float uWeights[DegreeU + 1], uDerivativeWeights[DegreeU + 1];
+		for (int k = 0; k < numberOfU; k++) {
+			BernsteinBasis<DegreeU>::evaluate(uValues(k), uWeights, uDerivativeWeights);
+			for (int j = 0; j <= DegreeU; j++) {
+				uBasis(k, j) = uWeights[j];
+				uDerivativeBasis(k, j) = uDerivativeWeights[j];
+			}
+		}
+		float vWeights[DegreeV + 1], vDerivativeWeights[DegreeV + 1];
+		for (int l = 0; l < numberOfV; l++) {
+			BernsteinBasis<DegreeV>::evaluate(vValues(l), vWeights, vDerivativeWeights);
+			for (int i = 0; i <= DegreeV; i++) {
+				vBasis(l, i) = vWeights[i];
+				vDerivativeBasis(l, i) = vDerivativeWeights[i];
+			}
+		}
+
+		// positions[c](k, l) is coordinate c of the surface at (uValues[k], vValues[l]); likewise for the partials
+		float *positions[numberOfCoordinates], *uDerivatives[numberOfCoordinates], *vDerivatives[numberOfCoordinates];
+		ScratchMatrix blendedInV(arena.allocate<float>((DegreeU + 1) * numberOfV), DegreeU + 1, numberOfV);
+		ScratchMatrix blendedDerivativeInV(arena.allocate<float>((DegreeU + 1) * numberOfV), DegreeU + 1, numberOfV);
+		for (int c = 0; c < numberOfCoordinates; c++) {
+			Eigen::Matrix<float, DegreeV + 1, DegreeU + 1> coordinateGrid;
+			for (int i = 0; i <= DegreeV; i++) {
+				for (int j = 0; j <= DegreeU; j++) {
+					coordinateGrid(i, j) = controlPoints[i][j](c);
+				}
+			}
+
+			blendedInV.noalias() = coordinateGrid.transpose() * vBasis.transpose();
+			blendedDerivativeInV.noalias() = coordinateGrid.transpose() * vDerivativeBasis.transpose();
+
+			positions[c] = arena.allocate<float>(numberOfU * numberOfV);
+			uDerivatives[c] = arena.allocate<float>(numberOfU * numberOfV);
+			vDerivatives[c] = arena.allocate<float>(numberOfU * numberOfV);
+			ScratchMatrix(positions[c], numberOfU, numberOfV).noalias() = uBasis * blendedInV;
+			ScratchMatrix(uDerivatives[c], numberOfU, numberOfV).noalias() = uDerivativeBasis * blendedInV;
+			ScratchMatrix(vDerivatives[c], numberOfU, numberOfV).noalias() = uBasis * blendedDerivativeInV;
+		}
+
+		for (int k = 0; k < numberOfU; k++) {
+			for (int l = 0; l < numberOfV; l++) {
+				// (the matrices are column-major)
+				int i = l * numberOfU + k;
+				Point position, uDerivative, vDerivative;
+				for (int c = 0; c < numberOfCoordinates; c++) {
+					position(c) = positions[c][i];
+					uDerivative(c) = uDerivatives[c][i];
+					vDerivative(c) = vDerivatives[c][i];
+				}
+
+				grid[k * numberOfV + l] = toDifferentialGeometry(position, uDerivative, vDerivative, uValues(k), vValues(l));
+			}
+		}
+	}
+};
+
+
+//****************************************************
+// Calls visitor.template visit<DegreeU, DegreeV>() with the runtime degrees turned into template
+// arguments. Returns false (without calling it) unless both degrees are between 1 and MAX_BEZIER_DEGREE
+//***************************************************
+template <int DegreeU, class Visitor>
+bool visitBezierDegreeV(int degreeV, Visitor &visitor) {
+	switch (degreeV) {
+		case 1: visitor.template visit<DegreeU, 1>(); return true;
+		case 2: visitor.template visit<DegreeU, 2>(); return true;
+		case 3: visitor.template visit<DegreeU, 3>(); return true;
+		case 4: visitor.template visit<DegreeU, 4>(); return true;
+		case 5: visitor.template visit<DegreeU, 5>(); return true;
+		default: return false;
+	}
+}
+
+template <class Visitor>
+bool visitBezierDegrees(int degreeU, int degreeV, Visitor &visitor) {
+	static_assert(MAX_BEZIER_DEGREE == 5, "visitBezierDegrees needs a case for every degree up to MAX_BEZIER_DEGREE");
+	switch (degreeU) {
+		case 1: return visitBezierDegreeV<1>(degreeV, visitor);
+		case 2: return visitBezierDegreeV<2>(degreeV, visitor);
+		case 3: return visitBezierDegreeV<3>(degreeV, visitor);
+		case 4: return visitBezierDegreeV<4>(degreeV, visitor);
+		case 5: return visitBezierDegreeV<5>(degreeV, visitor);
+		default: return false;
+	}
+}
+
+
+#endif /* BEZIERSURFACE_H_ */
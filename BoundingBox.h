@@ -0,0 +1,124 @@
+/*
+ * BoundingBox.h
+ *
+ *  Created on: Apr 25, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef BOUNDINGBOX_H_
+#define BOUNDINGBOX_H_
+
+#include <algorithm>
+#include <limits>
+
+// An axis-aligned box, for culling and ray tests. A new box is empty (minimum > maximum) until something is added to it
+class BoundingBox {
+	public:
+		Eigen::Vector3f minimum, maximum;
+
+		// Bits of getOutcode(), one per clipping plane
+		enum { OUTSIDE_LEFT = 0x01, OUTSIDE_RIGHT = 0x02, OUTSIDE_BOTTOM = 0x04, OUTSIDE_TOP = 0x08,
+			OUTSIDE_NEAR = 0x10, OUTSIDE_FAR = 0x20 };
+
+		// What isInView() can say about a box
+		enum Visibility { OUTSIDE, INTERSECTING, INSIDE };
+
+	BoundingBox() {
+		minimum = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+		maximum = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+	}
+
+	bool isEmpty() const {
+		return minimum.x() > maximum.x();
+	}
+
+	void extend(const Eigen::Vector3f &point) {
+		minimum = minimum.cwiseMin(point);
+		maximum = maximum.cwiseMax(point);
+	}
+
+	void extend(const BoundingBox &box) {
+		minimum = minimum.cwiseMin(box.minimum);
+		maximum = maximum.cwiseMax(box.maximum);
+	}
+
+	Eigen::Vector3f getCenter() const {
+		return (minimum + maximum) / 2.0f;
+	}
+
+	Eigen::Vector3f getSize() const {
+		return maximum - minimum;
+	}
+
+	// Half the surface area, which is all the bounding volume hierarchy's cost estimate needs
+	float getHalfArea() const {
+		if (isEmpty()) {
+			return 0;
+		}
+		Eigen::Vector3f size = getSize();
+		return size.x() * size.y() + size.y() * size.z() + size.z() * size.x();
+	}
+
+	//****************************************************
+	// Which clipping planes of 'modelviewProjection' the point is outside of, as OUTSIDE_* bits
+	// (the homogeneous tests, so this is right for points behind the camera too)
+	//***************************************************
+	static int getOutcode(const Eigen::Matrix4f &modelviewProjection, const Eigen::Vector3f &point) {
+		Eigen::Vector4f clip = modelviewProjection * Eigen::Vector4f(point.x(), point.y(), point.z(), 1.0f);
+		int outcode = 0;
+		outcode |= (clip.x() < -clip.w()) ? OUTSIDE_LEFT : 0;
+		outcode |= (clip.x() > clip.w()) ? OUTSIDE_RIGHT : 0;
+		outcode |= (clip.y() < -clip.w()) ? OUTSIDE_BOTTOM : 0;
+		outcode |= (clip.y() > clip.w()) ? OUTSIDE_TOP : 0;
+		outcode |= (clip.z() < -clip.w()) ? OUTSIDE_NEAR : 0;
+		outcode |= (clip.z() > clip.w()) ? OUTSIDE_FAR : 0;
+		return outcode;
+	}
+
+	//****************************************************
+	// OUTSIDE if all 8 corners are outside the same clipping plane, INSIDE if all of them are inside
+	// every plane, else INTERSECTING (which may still be outside the view, near its corners)
+	//***************************************************
+	Visibility isInView(const Eigen::Matrix4f &modelviewProjection) const {
+		int outsideAll = 0x3F;
+		int outsideAny = 0;
+		for (int corner = 0; corner < 8; corner++) {
+			Eigen::Vector3f point((corner & 1) ? maximum.x() : minimum.x(), (corner & 2) ? maximum.y() : minimum.y(),
+					(corner & 4) ? maximum.z() : minimum.z());
+			int outcode = getOutcode(modelviewProjection, point);
+			outsideAll &= outcode;
+			outsideAny |= outcode;
+		}
+		if (outsideAll != 0) {
+			return OUTSIDE;
+		}
+		return (outsideAny == 0) ? INSIDE : INTERSECTING;
+	}
+
+	//****************************************************
+	// Slab test: true if the ray origin + t * direction enters the box at some t in [0, tMax],
+	// with 'inverseDirection' = 1 / direction per component. Sets tEnter to where it enters
+	//***************************************************
+	bool intersectRay(const Eigen::Vector3f &origin, const Eigen::Vector3f &inverseDirection, float tMax, float &tEnter) const {
+		float tNear = 0;
+		float tFar = tMax;
+		for (int axis = 0; axis < 3; axis++) {
+			float t0 = (minimum[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (maximum[axis] - origin[axis]) * inverseDirection[axis];
+			if (t0 > t1) {
+				std::swap(t0, t1);
+			}
+			// (NaN, from 0 * infinity when the origin is on a slab of a parallel ray, fails both comparisons)
+			tNear = (t0 > tNear) ? t0 : tNear;
+			tFar = (t1 < tFar) ? t1 : tFar;
+			if (tNear > tFar) {
+				return false;
+			}
+		}
+		tEnter = tNear;
+		return true;
+	}
+};
+
+
+#endif /* BOUNDINGBOX_H_ */
@@ -51,6 +51,45 @@ class Camera {
 
 	}
 
+	//****************************************************
+	// The matrix gluPerspective() builds for the current field of view and zoom
+	//***************************************************
+	Eigen::Matrix4f getProjectionMatrix(float aspectRatio) {
+		float fieldOfView = FIELD_OF_VIEW * ZOOM_AMOUNT * M_PI / 180.0f;
+		float f = 1.0f / tan(fieldOfView / 2.0f);
+
+		Eigen::Matrix4f projection = Eigen::Matrix4f::Zero();
+		projection(0, 0) = f / aspectRatio;
+		projection(1, 1) = f;
+		projection(2, 2) = (zFar + zNear) / (zNear - zFar);
+		projection(2, 3) = (2.0f * zFar * zNear) / (zNear - zFar);
+		projection(3, 2) = -1.0f;
+		return projection;
+	}
+
+	//****************************************************
+	// The modelview matrix renderScene() sets up: gluLookAt(), then the rotations, then the translation
+	//***************************************************
+	Eigen::Matrix4f getModelviewMatrix() {
+		Eigen::Vector3f forward = (lookAt - position).normalized();
+		Eigen::Vector3f side = forward.cross(up.normalized()).normalized();
+		Eigen::Vector3f trueUp = side.cross(forward);
+
+		Eigen::Matrix4f view = Eigen::Matrix4f::Identity();
+		view.block<1, 3>(0, 0) = side.transpose();
+		view.block<1, 3>(1, 0) = trueUp.transpose();
+		view.block<1, 3>(2, 0) = -forward.transpose();
+		view.block<3, 1>(0, 3) = -(view.block<3, 3>(0, 0) * position);
+
+		Eigen::Affine3f transform(Eigen::Affine3f::Identity());
+		transform.rotate(Eigen::AngleAxisf(X_ROTATION_AMOUNT * M_PI / 180.0f, Eigen::Vector3f::UnitX()));
+		transform.rotate(Eigen::AngleAxisf(Y_ROTATION_AMOUNT * M_PI / 180.0f, Eigen::Vector3f::UnitY()));
+		transform.rotate(Eigen::AngleAxisf(Z_ROTATION_AMOUNT * M_PI / 180.0f, Eigen::Vector3f::UnitZ()));
+		transform.translate(Eigen::Vector3f(X_TRANSLATION_AMOUNT, Y_TRANSLATION_AMOUNT, Z_TRANSLATION_AMOUNT));
+
+		return view * transform.matrix();
+	}
+
 	void zoomIn() {
 		ZOOM_AMOUNT -= ZOOM_DELTA;
 	}
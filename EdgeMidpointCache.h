@@ -0,0 +1,142 @@
+/*
+ * EdgeMidpointCache.h
+ *
+ *  Created on: Apr 20, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef EDGEMIDPOINTCACHE_H_
+#define EDGEMIDPOINTCACHE_H_
+
+#include <unordered_map>
+#include <algorithm>
+#include <stdint.h>
+
+// Memoizes, for every edge that adaptive subdivision has tested, the surface evaluated at the
+// edge's (u, v) midpoint and how far that point is from the straight edge.
+//
+// Edges are keyed by the quantized (u, v) values of their two endpoints, in either order, so the two
+// triangles that share an edge look up the same entry: the midpoint is evaluated once, both triangles
+// make the same split decision, and once the edge is split both use the same vertex.
+class EdgeMidpointCache {
+	public:
+		class Entry {
+			public:
+				// The surface evaluated at the (u, v) midpoint of the edge
+				DifferentialGeometry midpoint;
+
+				// Distance between 'midpoint' and the midpoint of the straight edge
+				float errorValue;
+
+				// Index of 'midpoint' in the patch's listOfDifferentialGeometries, or -1 if the edge has not been split yet
+				int64_t vertexIndex;
+
+				// The cache's vertexGeneration when vertexIndex was last valid
+				uint32_t vertexGeneration;
+
+			Entry() {
+				errorValue = 0.0f;
+				vertexIndex = -1;
+				vertexGeneration = 0;
+			}
+		};
+
+	EdgeMidpointCache() {
+		vertexGeneration = 0;
+	}
+
+	// Returns the entry for the edge between uvA and uvB, creating an empty one if needed.
+	// 'found' is set to whether the entry already existed (i.e. its midpoint has already been evaluated).
+	// Entries never move, so the returned reference stays valid as more edges are added.
+	Entry &findOrInsert(const Eigen::Vector2f &uvA, const Eigen::Vector2f &uvB, bool &found) {
+		uint64_t keyA = quantize(uvA);
+		uint64_t keyB = quantize(uvB);
+
+		EdgeKey key;
+		key.first = std::min(keyA, keyB);
+		key.second = std::max(keyA, keyB);
+
+		// (looking the key up first, since insert builds the new node before it checks whether the key exists,
+		// which would allocate on every lookup)
+		std::unordered_map<EdgeKey, Entry, EdgeKeyHash>::iterator position = entries.find(key);
+		found = (position != entries.end());
+		if (!found) {
+			position = entries.insert(std::make_pair(key, Entry())).first;
+		}
+
+		Entry &entry = position->second;
+		if (entry.vertexGeneration != vertexGeneration) {
+			entry.vertexIndex = -1;
+			entry.vertexGeneration = vertexGeneration;
+		}
+		return entry;
+	}
+
+	// True if the (u, v) midpoint of the edge between uvA and uvB (computed in floats, as subdivision does) lands
+	// exactly halfway between them on the grid that keys are quantized to. Edges that are already as short as
+	// floats or the grid can resolve can't be split: their halves would share keys with other edges
+	static bool canSplit(const Eigen::Vector2f &uvA, const Eigen::Vector2f &uvB) {
+		uint64_t keyA = quantize(uvA);
+		uint64_t keyB = quantize(uvB);
+		uint64_t keyOfMidpoint = quantize((uvA + uvB) / 2.0f);
+		for (int shift = 0; shift <= 32; shift += 32) {
+			uint64_t a = (keyA >> shift) & 0xFFFFFFFFULL;
+			uint64_t b = (keyB >> shift) & 0xFFFFFFFFULL;
+			uint64_t midpoint = (keyOfMidpoint >> shift) & 0xFFFFFFFFULL;
+			if (a + b != 2 * midpoint) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Forgets which edges have been split, but keeps every evaluated midpoint.
+	// Entries are only reset when they're next looked up, so this takes constant time
+	void forgetVertices() {
+		vertexGeneration++;
+	}
+
+	void clear() {
+		entries.clear();
+	}
+
+	int size() {
+		return entries.size();
+	}
+
+	private:
+		class EdgeKey {
+			public:
+				uint64_t first, second;
+
+			bool operator==(const EdgeKey &other) const {
+				return first == other.first && second == other.second;
+			}
+		};
+
+		class EdgeKeyHash {
+			public:
+			size_t operator()(const EdgeKey &key) const {
+				uint64_t hash = key.first * 0x9E3779B97F4A7C15ULL;
+				hash ^= key.second + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+				return (size_t) hash;
+			}
+		};
+
+		std::unordered_map<EdgeKey, Entry, EdgeKeyHash> entries;
+
+		// Bumped by forgetVertices; entries stamped with an older one have no vertex
+		uint32_t vertexGeneration;
+
+	// Packs a (u, v) value in [0, 1]^2 into 64 bits, 32 bits per coordinate.
+	// Adaptive subdivision only ever halves edges, so every (u, v) it produces lands exactly on this grid.
+	static uint64_t quantize(const Eigen::Vector2f &uv) {
+		const double scale = 1u << 30;
+		uint64_t u = (uint64_t) (uv.x() * scale + 0.5);
+		uint64_t v = (uint64_t) (uv.y() * scale + 0.5);
+		return (u << 32) | v;
+	}
+};
+
+
+#endif /* EDGEMIDPOINTCACHE_H_ */
@@ -0,0 +1,97 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: Apr 21, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file in memory. On POSIX systems the file is mmap'ed, so the parsers
+// read straight out of the page cache without copying; elsewhere it is read into a buffer.
+class MappedFile {
+	public:
+
+	MappedFile(std::string filename) {
+		contents = NULL;
+		length = 0;
+		mapped = false;
+
+#ifndef _WIN32
+		int descriptor = open(filename.c_str(), O_RDONLY);
+		if (descriptor < 0) {
+			return;
+		}
+
+		struct stat status;
+		if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+			void *address = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (address != MAP_FAILED) {
+				contents = (const char *) address;
+				length = status.st_size;
+				mapped = true;
+				madvise(address, length, MADV_SEQUENTIAL);
+			}
+		}
+		close(descriptor);
+#else
+		std::ifstream file(filename.c_str(), std::ios::binary);
+		if (file) {
+			buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			contents = buffer.empty() ? NULL : &buffer[0];
+			length = buffer.size();
+		}
+#endif
+	}
+
+	~MappedFile() {
+#ifndef _WIN32
+		if (mapped) {
+			munmap((void *) contents, length);
+		}
+#endif
+	}
+
+	// True if the file was opened (an empty file counts as not opened)
+	bool isOpen() {
+		return contents != NULL;
+	}
+
+	const char *begin() {
+		return contents;
+	}
+
+	const char *end() {
+		return contents + length;
+	}
+
+	size_t size() {
+		return length;
+	}
+
+	private:
+		const char *contents;
+		size_t length;
+		bool mapped;
+		std::vector<char> buffer;
+
+		// Not copyable: the destructor unmaps the file
+		MappedFile(const MappedFile &);
+		MappedFile &operator=(const MappedFile &);
+};
+
+
+#endif /* MAPPEDFILE_H_ */
@@ -0,0 +1,207 @@
+/*
+ * MeshBuffer.h
+ *
+ *  Created on: Apr 23, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef MESHBUFFER_H_
+#define MESHBUFFER_H_
+
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+
+// The tessellated triangles of every BezierPatch, kept on the GPU so that a frame is a single
+// glDrawElements call instead of a glBegin/glEnd pair per triangle.
+//
+// All patches' vertices go into one interleaved vertex buffer (position, then normal) and all their
+// triangles into one index buffer, with each patch's indices offset past the vertices of the patches
+// before it. The buffers are only rebuilt when the tessellation's generation number changes.
+// Each patch's triangles are a contiguous range of the index buffer, so a subset of the patches can be drawn too.
+//
+// If the GL doesn't have buffer objects (before OpenGL 1.5), the same arrays are drawn from client memory.
+class MeshBuffer {
+	public:
+
+	MeshBuffer() {
+		vertexBuffer = 0;
+		indexBuffer = 0;
+		numberOfIndices = 0;
+		uploadedGeneration = -1;
+		useBufferObjects = false;
+		initialized = false;
+		numberOfUploads = 0;
+	}
+
+	// True if the buffers already hold tessellation 'generation'
+	bool isCurrent(long generation) {
+		return uploadedGeneration == generation;
+	}
+
+	long getNumberOfUploads() {
+		return numberOfUploads;
+	}
+
+	//****************************************************
+	// Copies every patch's vertices and triangles into the buffers, and remembers that they
+	// now hold tessellation 'generation'. Must be called with a current GL context
+	//***************************************************
+	void upload(std::vector<BezierPatch> &patches, long generation) {
+		initialize();
+
+		size_t totalVertices = 0;
+		size_t totalIndices = 0;
+		firstIndexOfPatch.resize(patches.size() + 1);
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			firstIndexOfPatch[i] = totalIndices;
+			totalVertices += patches[i].listOfDifferentialGeometries.size();
+			totalIndices += patches[i].listOfTriangleIndices.size();
+		}
+		firstIndexOfPatch[patches.size()] = totalIndices;
+
+		vertices.resize(totalVertices * FLOATS_PER_VERTEX);
+		indices.resize(totalIndices);
+
+		float *vertex = vertices.empty() ? NULL : &vertices[0];
+		uint32_t *index = indices.empty() ? NULL : &indices[0];
+		uint32_t firstVertexOfPatch = 0;
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			const TessellationList<DifferentialGeometry> &patchVertices = patches[i].listOfDifferentialGeometries;
+			for (TessellationList<DifferentialGeometry>::size_type j = 0; j < patchVertices.size(); j++) {
+				memcpy(vertex, patchVertices[j].position.data(), 3 * sizeof(float));
+				memcpy(vertex + 3, patchVertices[j].normal.data(), 3 * sizeof(float));
+				vertex += FLOATS_PER_VERTEX;
+			}
+
+			const TessellationList<uint32_t> &patchIndices = patches[i].listOfTriangleIndices;
+			for (TessellationList<uint32_t>::size_type j = 0; j < patchIndices.size(); j++) {
+				*index++ = firstVertexOfPatch + patchIndices[j];
+			}
+			firstVertexOfPatch += patchVertices.size();
+		}
+		numberOfIndices = totalIndices;
+
+		if (useBufferObjects) {
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.empty() ? NULL : &indices[0], GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+			// The GL has its own copy now
+			std::vector<float>().swap(vertices);
+			std::vector<uint32_t>().swap(indices);
+		}
+
+		uploadedGeneration = generation;
+		numberOfUploads++;
+	}
+
+	//****************************************************
+	// Draws the triangles of the given patches (indices into the list that was uploaded, in increasing
+	// order) with the current GL state (polygon mode, lighting, color...), one draw call per run of
+	// consecutive patches
+	//***************************************************
+	void draw(const std::vector<int> &patches) {
+		if (numberOfIndices == 0 || patches.empty()) {
+			return;
+		}
+		bindArrays();
+		std::vector<int>::size_type i = 0;
+		while (i < patches.size()) {
+			std::vector<int>::size_type j = i + 1;
+			while (j < patches.size() && patches[j] == patches[j - 1] + 1) {
+				j++;
+			}
+			uint32_t first = firstIndexOfPatch[patches[i]];
+			uint32_t last = firstIndexOfPatch[patches[j - 1] + 1];
+			if (last > first) {
+				glDrawElements(GL_TRIANGLES, last - first, GL_UNSIGNED_INT, indexData(first));
+			}
+			i = j;
+		}
+		unbindArrays();
+	}
+
+	private:
+		// x, y, z, nx, ny, nz
+		static const int FLOATS_PER_VERTEX = 6;
+
+		GLuint vertexBuffer;
+		GLuint indexBuffer;
+		GLsizei numberOfIndices;
+
+		long uploadedGeneration;
+		long numberOfUploads;
+
+		bool useBufferObjects;
+		bool initialized;
+
+		// Only kept around when drawing from client memory
+		std::vector<float> vertices;
+		std::vector<uint32_t> indices;
+
+		// Patch i's triangles are indices [firstIndexOfPatch[i], firstIndexOfPatch[i + 1])
+		std::vector<uint32_t> firstIndexOfPatch;
+
+	void bindArrays() {
+		const char *vertexData = NULL;
+		if (useBufferObjects) {
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		} else {
+			vertexData = (const char *) &vertices[0];
+		}
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glVertexPointer(3, GL_FLOAT, FLOATS_PER_VERTEX * sizeof(float), vertexData);
+		glNormalPointer(GL_FLOAT, FLOATS_PER_VERTEX * sizeof(float), vertexData + 3 * sizeof(float));
+	}
+
+	void unbindArrays() {
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_NORMAL_ARRAY);
+		if (useBufferObjects) {
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		}
+	}
+
+	// What glDrawElements takes to start at index 'first': an offset into the index buffer, or a pointer
+	const GLvoid *indexData(uint32_t first) {
+		if (useBufferObjects) {
+			return (const GLvoid *) (first * sizeof(uint32_t));
+		}
+		return &indices[first];
+	}
+
+	// Creates the buffer objects, the first time we have a GL context to do it with
+	void initialize() {
+		if (initialized) {
+			return;
+		}
+		initialized = true;
+
+		// Buffer objects are core since OpenGL 1.5
+		const char *version = (const char *) glGetString(GL_VERSION);
+		int major = 0, minor = 0;
+		if (version != NULL) {
+			major = atoi(version);
+			const char *dot = strchr(version, '.');
+			minor = (dot != NULL) ? atoi(dot + 1) : 0;
+		}
+		useBufferObjects = (major > 1 || (major == 1 && minor >= 5));
+
+		if (useBufferObjects) {
+			glGenBuffers(1, &vertexBuffer);
+			glGenBuffers(1, &indexBuffer);
+		}
+	}
+};
+
+
+#endif /* MESHBUFFER_H_ */
@@ -0,0 +1,311 @@
+/*
+ * MeshCache.h
+ *
+ *  Created on: Apr 26, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef MESHCACHE_H_
+#define MESHCACHE_H_
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+// Saves the tessellated BezierPatches to a binary file, and loads them back without parsing or
+// tessellating anything, as long as the .bez file and the subdivision options are the same (see Key).
+//
+// The file is laid out so that it can be mmap'ed and copied straight into the patches:
+//
+//     Header
+//     PatchRecord[numberOfPatches]             (degrees, control points, weights and how many of each array every patch has)
+//     DifferentialGeometry[numberOfVertices]   (every patch's listOfDifferentialGeometries, one after another)
+//     uint32_t[numberOfIndices]                (every patch's listOfTriangleIndices)
+//     uint32_t[numberOfDepths]                 (every patch's listOfTriangleDepths)
+//
+// Every section starts on an 8-byte boundary. Numbers are in the writing machine's byte order, which
+// byteOrderMark catches; bump VERSION whenever the layout (or DifferentialGeometry) changes.
+class MeshCache {
+	public:
+		// What a tessellation depends on. A cache is only loaded if its key matches exactly
+		class Key {
+			public:
+				// FNV-1a hash and size of the .bez file's bytes
+				uint64_t sourceHash;
+				uint64_t sourceSize;
+
+				// 1 = adaptive subdivision, 0 = uniform
+				uint32_t adaptive;
+
+				// The BezierPatch::EvaluationMethod used (evaluators round differently)
+				uint32_t evaluationMethod;
+
+				// Step size (uniform) or error (adaptive)
+				float subdivisionParameter;
+
+				// Adaptive subdivision's options (see BezierPatch)
+				uint32_t depthFirstSubdivision;
+				int32_t maxSubdivisionDepth;
+
+				// (keeps the key a multiple of 8 bytes; always 0)
+				uint32_t reserved;
+
+			Key() {
+				memset(this, 0, sizeof(Key));
+			}
+
+			bool operator==(const Key &other) const {
+				return sourceHash == other.sourceHash && sourceSize == other.sourceSize && adaptive == other.adaptive
+						&& evaluationMethod == other.evaluationMethod && subdivisionParameter == other.subdivisionParameter
+						&& depthFirstSubdivision == other.depthFirstSubdivision && maxSubdivisionDepth == other.maxSubdivisionDepth;
+			}
+		};
+
+	//****************************************************
+	// FNV-1a hash of the bytes [begin, end)
+	//***************************************************
+	static uint64_t hash(const char *begin, const char *end) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (const char *c = begin; c < end; c++) {
+			hash = (hash ^ (unsigned char) *c) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	//****************************************************
+	// Writes 'patches' and their tessellations to 'filename'. The file is written under a temporary
+	// name and renamed into place, so an interrupted write never leaves a cache that looks complete.
+	// Returns false if the file couldn't be written
+	//***************************************************
+	static bool save(std::string filename, const Key &key, const std::vector<BezierPatch> &patches) {
+		Header header;
+		memcpy(header.magic, MAGIC, sizeof(header.magic));
+		header.version = VERSION;
+		header.byteOrderMark = BYTE_ORDER_MARK;
+		header.key = key;
+		header.numberOfPatches = patches.size();
+
+		std::vector<PatchRecord> records(patches.size());
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			const BezierPatch &patch = patches[i];
+			PatchRecord &record = records[i];
+			for (int curve = 0; curve < patch.numberOfCurves; curve++) {
+				for (int point = 0; point <= patch.degreeU; point++) {
+					for (int axis = 0; axis < 3; axis++) {
+						record.controlPoints[curve][point][axis] = patch.controlPoints[curve][point][axis];
+					}
+					record.weights[curve][point] = patch.getWeight(curve, point);
+				}
+			}
+			record.rational = patch.rational;
+			record.degreeU = patch.degreeU;
+			record.degreeV = patch.degreeV;
+			record.numberOfCurves = patch.numberOfCurves;
+			record.uniformSteps = patch.uniformSteps;
+			record.tessellationParameter = patch.tessellationParameter;
+			record.numberOfVertices = patch.listOfDifferentialGeometries.size();
+			record.numberOfIndices = patch.listOfTriangleIndices.size();
+			record.numberOfDepths = patch.listOfTriangleDepths.size();
+
+			header.numberOfVertices += record.numberOfVertices;
+			header.numberOfIndices += record.numberOfIndices;
+			header.numberOfDepths += record.numberOfDepths;
+		}
+		header.vertexOffset = sizeof(Header) + records.size() * sizeof(PatchRecord);
+		header.indexOffset = header.vertexOffset + header.numberOfVertices * sizeof(DifferentialGeometry);
+		header.depthOffset = alignTo8(header.indexOffset + header.numberOfIndices * sizeof(uint32_t));
+		header.fileSize = alignTo8(header.depthOffset + header.numberOfDepths * sizeof(uint32_t));
+
+		std::string temporaryFilename = filename + ".tmp";
+		std::ofstream file(temporaryFilename.c_str(), std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write((const char *) &header, sizeof(Header));
+		file.write((const char *) records.data(), records.size() * sizeof(PatchRecord));
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			file.write((const char *) patches[i].listOfDifferentialGeometries.data(),
+					patches[i].listOfDifferentialGeometries.size() * sizeof(DifferentialGeometry));
+		}
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			file.write((const char *) patches[i].listOfTriangleIndices.data(), patches[i].listOfTriangleIndices.size() * sizeof(uint32_t));
+		}
+		writePadding(file, header.depthOffset - (header.indexOffset + header.numberOfIndices * sizeof(uint32_t)));
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			file.write((const char *) patches[i].listOfTriangleDepths.data(), patches[i].listOfTriangleDepths.size() * sizeof(uint32_t));
+		}
+		writePadding(file, header.fileSize - (header.depthOffset + header.numberOfDepths * sizeof(uint32_t)));
+		file.close();
+
+		if (!file || std::rename(temporaryFilename.c_str(), filename.c_str()) != 0) {
+			std::remove(temporaryFilename.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	//****************************************************
+	// Replaces 'patches' with the ones saved in 'filename', tessellations and all, if it is a complete
+	// cache of this version whose key is 'key'. Returns false (leaving 'patches' alone) if it isn't.
+	// The loaded patches' bounds are computed; everything else that isn't saved keeps its default
+	//***************************************************
+	static bool load(std::string filename, const Key &key, std::vector<BezierPatch> &patches) {
+		MappedFile file(filename);
+		if (!file.isOpen() || file.size() < sizeof(Header)) {
+			return false;
+		}
+
+		// (the sections are copied out with memcpy, so nothing here relies on the mapping's alignment)
+		Header header;
+		memcpy(&header, file.begin(), sizeof(Header));
+		if (memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION
+				|| header.byteOrderMark != BYTE_ORDER_MARK || !(header.key == key) || header.fileSize != file.size()
+				|| header.numberOfPatches > (file.size() - sizeof(Header)) / sizeof(PatchRecord)
+				|| header.vertexOffset != sizeof(Header) + header.numberOfPatches * sizeof(PatchRecord)
+				|| header.numberOfVertices > (file.size() - header.vertexOffset) / sizeof(DifferentialGeometry)
+				|| header.indexOffset != header.vertexOffset + header.numberOfVertices * sizeof(DifferentialGeometry)
+				|| header.numberOfIndices > (file.size() - header.indexOffset) / sizeof(uint32_t)
+				|| header.depthOffset != alignTo8(header.indexOffset + header.numberOfIndices * sizeof(uint32_t))
+				|| header.numberOfDepths > (file.size() - header.depthOffset) / sizeof(uint32_t)
+				|| header.fileSize != alignTo8(header.depthOffset + header.numberOfDepths * sizeof(uint32_t))) {
+			return false;
+		}
+
+		std::vector<PatchRecord> records(header.numberOfPatches);
+		memcpy(records.data(), file.begin() + sizeof(Header), records.size() * sizeof(PatchRecord));
+		uint64_t numberOfVertices = 0, numberOfIndices = 0, numberOfDepths = 0;
+		for (std::vector<PatchRecord>::size_type i = 0; i < records.size(); i++) {
+			if (records[i].degreeU < 1 || records[i].degreeU > MAX_BEZIER_DEGREE || records[i].degreeV < 1
+					|| records[i].degreeV > MAX_BEZIER_DEGREE || records[i].numberOfCurves < 0
+					|| records[i].numberOfCurves > records[i].degreeV + 1) {
+				return false;
+			}
+			numberOfVertices += records[i].numberOfVertices;
+			numberOfIndices += records[i].numberOfIndices;
+			numberOfDepths += records[i].numberOfDepths;
+		}
+		if (numberOfVertices != header.numberOfVertices || numberOfIndices != header.numberOfIndices
+				|| numberOfDepths != header.numberOfDepths) {
+			return false;
+		}
+
+		std::vector<BezierPatch> loadedPatches(records.size());
+		const char *vertices = file.begin() + header.vertexOffset;
+		const char *indices = file.begin() + header.indexOffset;
+		const char *depths = file.begin() + header.depthOffset;
+		for (std::vector<PatchRecord>::size_type i = 0; i < records.size(); i++) {
+			const PatchRecord &record = records[i];
+			BezierPatch &patch = loadedPatches[i];
+			patch.setDegrees(record.degreeU, record.degreeV);
+			for (int curve = 0; curve < record.numberOfCurves; curve++) {
+				for (int point = 0; point <= record.degreeU; point++) {
+					Eigen::Vector3f controlPoint(record.controlPoints[curve][point]);
+					if (!record.rational) {
+						patch.controlPoints[curve][point] = controlPoint;
+					} else if (!patch.setControlPoint(curve, point, controlPoint, record.weights[curve][point])) {
+						return false;
+					}
+				}
+			}
+			patch.numberOfCurves = record.numberOfCurves;
+			patch.uniformSteps = record.uniformSteps;
+			patch.tessellationParameter = record.tessellationParameter;
+			patch.computeBounds();
+
+			patch.listOfDifferentialGeometries.resize(record.numberOfVertices);
+			memcpy((void *) patch.listOfDifferentialGeometries.data(), vertices, record.numberOfVertices * sizeof(DifferentialGeometry));
+			vertices += record.numberOfVertices * sizeof(DifferentialGeometry);
+
+			patch.listOfTriangleIndices.resize(record.numberOfIndices);
+			memcpy(patch.listOfTriangleIndices.data(), indices, record.numberOfIndices * sizeof(uint32_t));
+			indices += record.numberOfIndices * sizeof(uint32_t);
+
+			patch.listOfTriangleDepths.resize(record.numberOfDepths);
+			memcpy(patch.listOfTriangleDepths.data(), depths, record.numberOfDepths * sizeof(uint32_t));
+			depths += record.numberOfDepths * sizeof(uint32_t);
+
+			// An index past the patch's vertices would send the renderers off the end of the array
+			for (std::vector<uint32_t>::size_type j = 0; j < patch.listOfTriangleIndices.size(); j++) {
+				if (patch.listOfTriangleIndices[j] >= record.numberOfVertices) {
+					return false;
+				}
+			}
+		}
+
+		patches.swap(loadedPatches);
+		return true;
+	}
+
+	private:
+		static const uint32_t VERSION = 3;
+		static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+		static constexpr const char *MAGIC = "BEZMESH";
+
+		// DifferentialGeometry is written as it is in memory: position, normal, then (u, v), all floats
+		static_assert(sizeof(DifferentialGeometry) == 8 * sizeof(float), "DifferentialGeometry has padding; bump VERSION and write it field by field");
+
+		class Header {
+			public:
+				char magic[8];
+				uint32_t version;
+				uint32_t byteOrderMark;
+				Key key;
+				uint64_t numberOfPatches;
+
+				// Totals over every patch
+				uint64_t numberOfVertices, numberOfIndices, numberOfDepths;
+
+				// Where each section starts, from the beginning of the file, and the whole file's size
+				uint64_t vertexOffset, indexOffset, depthOffset, fileSize;
+
+			Header() {
+				memset(magic, 0, sizeof(magic));
+				version = byteOrderMark = 0;
+				numberOfPatches = numberOfVertices = numberOfIndices = numberOfDepths = 0;
+				vertexOffset = indexOffset = depthOffset = fileSize = 0;
+			}
+		};
+
+		class PatchRecord {
+			public:
+				// (only the first degreeU + 1 points of the first numberOfCurves curves are used; the rest are zero)
+				float controlPoints[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1][3];
+
+				// The used points' weights (all 1 unless 'rational' is 1)
+				float weights[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1];
+				int32_t rational;
+
+				// (keeps the record a multiple of 8 bytes; always 0)
+				int32_t reserved;
+
+				int32_t degreeU, degreeV;
+				int32_t numberOfCurves;
+				int32_t uniformSteps;
+				float tessellationParameter;
+
+				// How many entries of each section belong to this patch
+				uint32_t numberOfVertices, numberOfIndices, numberOfDepths;
+
+			PatchRecord() {
+				memset(this, 0, sizeof(PatchRecord));
+			}
+		};
+
+		// (so that the vertex section after the records starts on an 8-byte boundary)
+		static_assert(sizeof(PatchRecord) % 8 == 0, "PatchRecord needs padding to a multiple of 8 bytes");
+
+	static uint64_t alignTo8(uint64_t offset) {
+		return (offset + 7) & ~(uint64_t) 7;
+	}
+
+	static void writePadding(std::ofstream &file, uint64_t bytes) {
+		static const char zeros[8] = { 0 };
+		file.write(zeros, bytes);
+	}
+};
+
+
+#endif /* MESHCACHE_H_ */
@@ -0,0 +1,346 @@
+/*
+ * ObjMesh.h
+ *
+ *  Created on: Apr 22, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef OBJMESH_H_
+#define OBJMESH_H_
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdint.h>
+
+// A polygon mesh loaded from a Wavefront .obj file.
+//
+// Vertex attributes live in flat arrays (positions and normals as CoordinateArrays), and the faces live in flat per-corner index buffers:
+// the corners of polygon p are positionIndices[polygonOffsets[p]] ... positionIndices[polygonOffsets[p + 1] - 1],
+// with matching entries in normalIndices and textureCoordinateIndices (NO_INDEX where the face didn't give one).
+//
+// load() memory-maps the file, cuts it into newline-aligned chunks that are parsed on the ThreadPool,
+// then stitches the chunks together in a second parallel pass that resolves the face indices.
+class ObjMesh {
+	public:
+		static const uint32_t NO_INDEX = 0xFFFFFFFF;
+
+		CoordinateArrays vertices;
+		CoordinateArrays normals;
+		std::vector<Eigen::Vector2f> textureCoordinates;
+
+		std::vector<uint32_t> positionIndices;
+		std::vector<uint32_t> normalIndices;
+		std::vector<uint32_t> textureCoordinateIndices;
+
+		// Has getNumberOfPolygons() + 1 entries
+		std::vector<uint32_t> polygonOffsets;
+
+	ObjMesh() {
+		polygonOffsets.push_back(0);
+	}
+
+	int getNumberOfPolygons() {
+		return polygonOffsets.size() - 1;
+	}
+
+	// Number of corners of polygon p
+	int getPolygonSize(int p) {
+		return polygonOffsets[p + 1] - polygonOffsets[p];
+	}
+
+	//****************************************************
+	// Loads 'filename', replacing anything already in the mesh. Returns false if the file can't be opened.
+	//
+	// Supports v, vt, vn and f lines, with face corners written as v, v/vt, v//vn or v/vt/vn and
+	// indices counted from 1 or, if negative, backwards from the last attribute defined so far.
+	// Corners whose vertex doesn't exist are dropped, and texture coordinate / normal indices that don't
+	// exist are ignored, with a warning.
+	//***************************************************
+	bool load(std::string filename, ThreadPool &threadPool) {
+		*this = ObjMesh();
+
+		MappedFile file(filename);
+		if (!file.isOpen()) {
+			return false;
+		}
+
+		// Cut the file into chunks that each end just past a newline. We use a few chunks per thread so that
+		// work stealing can even out chunks that happen to be mostly faces (slower) or mostly vertices
+		const size_t MINIMUM_CHUNK_SIZE = 256 * 1024;
+		size_t numberOfChunks = std::max((size_t) 1, std::min((size_t) threadPool.size() * 4, file.size() / MINIMUM_CHUNK_SIZE));
+
+		std::vector<const char *> chunkBoundaries;
+		chunkBoundaries.push_back(file.begin());
+		for (size_t c = 1; c < numberOfChunks; c++) {
+			const char *boundary = std::max(file.begin() + file.size() * c / numberOfChunks, chunkBoundaries.back());
+			TextScanner scanner(boundary, file.end());
+			if (boundary > file.begin() && boundary[-1] != '\n') {
+				scanner.skipLine();
+			}
+			chunkBoundaries.push_back(scanner.position);
+		}
+		chunkBoundaries.push_back(file.end());
+
+		// Pass 1: parse every chunk on its own, with face indices left as written in the file
+		std::vector<Chunk> chunks(numberOfChunks);
+		threadPool.parallelFor(numberOfChunks, [&](int c) {
+			chunks[c].parse(chunkBoundaries[c], chunkBoundaries[c + 1]);
+		});
+
+		// Work out where each chunk's data starts in the combined arrays
+		std::vector<ChunkOffsets> offsets(numberOfChunks + 1);
+		for (size_t c = 0; c < numberOfChunks; c++) {
+			offsets[c + 1].vertices = offsets[c].vertices + chunks[c].vertices.size();
+			offsets[c + 1].normals = offsets[c].normals + chunks[c].normals.size();
+			offsets[c + 1].textureCoordinates = offsets[c].textureCoordinates + chunks[c].textureCoordinates.size();
+			offsets[c + 1].corners = offsets[c].corners + chunks[c].corners.size();
+			offsets[c + 1].polygons = offsets[c].polygons + chunks[c].polygonSizes.size();
+		}
+		ChunkOffsets &totals = offsets[numberOfChunks];
+
+		vertices.resize(totals.vertices);
+		normals.resize(totals.normals);
+		textureCoordinates.resize(totals.textureCoordinates);
+		positionIndices.resize(totals.corners);
+		normalIndices.resize(totals.corners);
+		textureCoordinateIndices.resize(totals.corners);
+		polygonOffsets.resize(totals.polygons + 1);
+		polygonOffsets[totals.polygons] = totals.corners;
+
+		// Pass 2: copy every chunk into place and resolve its face indices
+		std::vector<long> invalidCornersPerChunk(numberOfChunks, 0);
+		threadPool.parallelFor(numberOfChunks, [&](int c) {
+			invalidCornersPerChunk[c] = resolveChunk(chunks[c], offsets[c], totals);
+		});
+
+		long invalidCorners = 0;
+		for (size_t c = 0; c < numberOfChunks; c++) {
+			invalidCorners += invalidCornersPerChunk[c];
+		}
+		if (invalidCorners > 0) {
+			std::cerr << "Warning: " << filename << " has " << invalidCorners << " face corners that refer to missing vertices, texture coordinates or normals. Ignoring them.\n";
+			removeCornersWithoutVertices();
+		}
+
+		return true;
+	}
+
+	//****************************************************
+	// Box around the vertices that faces actually use (empty if there are none)
+	//***************************************************
+	BoundingBox computeBounds() {
+		// Usually every vertex is used, and the whole arrays can be scanned as they are
+		std::vector<bool> isUsed(vertices.size(), false);
+		size_t numberOfUsedVertices = 0;
+		for (std::vector<uint32_t>::size_type k = 0; k < positionIndices.size(); k++) {
+			if (!isUsed[positionIndices[k]]) {
+				isUsed[positionIndices[k]] = true;
+				numberOfUsedVertices++;
+			}
+		}
+		if (numberOfUsedVertices == vertices.size()) {
+			return vertices.computeBounds();
+		}
+
+		CoordinateArrays usedVertices;
+		usedVertices.reserve(numberOfUsedVertices);
+		for (size_t i = 0; i < vertices.size(); i++) {
+			if (isUsed[i]) {
+				usedVertices.push_back(vertices.get(i));
+			}
+		}
+		return usedVertices.computeBounds();
+	}
+
+	private:
+
+		// One corner of a face, exactly as written in the file (1-based or negative, 0 if absent)
+		class RawCorner {
+			public:
+				long position, textureCoordinate, normal;
+		};
+
+		// Everything parsed out of one chunk of the file
+		class Chunk {
+			public:
+				std::vector<Eigen::Vector3f> vertices;
+				std::vector<Eigen::Vector3f> normals;
+				std::vector<Eigen::Vector2f> textureCoordinates;
+				std::vector<RawCorner> corners;
+				std::vector<uint32_t> polygonSizes;
+
+				// For every negative (relative) index, which corner it is in and how many vertices / texture
+				// coordinates / normals this chunk had defined at that point
+				std::vector<std::pair<uint32_t, RawCorner> > relativeCorners;
+
+			void parse(const char *begin, const char *end) {
+				TextScanner scanner(begin, end);
+				const char *keywordBegin;
+				const char *keywordEnd;
+
+				while (!scanner.atEnd()) {
+					if (!scanner.nextToken(keywordBegin, keywordEnd)) {
+						scanner.skipLine();
+						continue;
+					}
+
+					size_t keywordLength = keywordEnd - keywordBegin;
+					if (keywordLength == 1 && keywordBegin[0] == 'v') {
+						Eigen::Vector3f vertex(0, 0, 0);
+						parseFloats(scanner, vertex.data(), 3);
+						vertices.push_back(vertex);
+					} else if (keywordLength == 2 && keywordBegin[0] == 'v' && keywordBegin[1] == 'n') {
+						Eigen::Vector3f normal(0, 0, 0);
+						parseFloats(scanner, normal.data(), 3);
+						normals.push_back(normal);
+					} else if (keywordLength == 2 && keywordBegin[0] == 'v' && keywordBegin[1] == 't') {
+						Eigen::Vector2f textureCoordinate(0, 0);
+						parseFloats(scanner, textureCoordinate.data(), 2);
+						textureCoordinates.push_back(textureCoordinate);
+					} else if (keywordLength == 1 && keywordBegin[0] == 'f') {
+						parseFace(scanner);
+					}
+
+					// Anything else (comments, groups, materials, extra values) is skipped
+					scanner.skipLine();
+				}
+			}
+
+			private:
+
+			static void parseFloats(TextScanner &scanner, float *values, int count) {
+				for (int i = 0; i < count; i++) {
+					scanner.skipSpaces();
+					if (!scanner.parseFloat(values[i])) {
+						return;
+					}
+				}
+			}
+
+			void parseFace(TextScanner &scanner) {
+				uint32_t numberOfCorners = 0;
+				while (true) {
+					scanner.skipSpaces();
+					RawCorner corner;
+					corner.position = corner.textureCoordinate = corner.normal = 0;
+					if (!scanner.parseInt(corner.position)) {
+						break;
+					}
+					if (!scanner.atEnd() && *scanner.position == '/') {
+						scanner.position++;
+						scanner.parseInt(corner.textureCoordinate);
+						if (!scanner.atEnd() && *scanner.position == '/') {
+							scanner.position++;
+							scanner.parseInt(corner.normal);
+						}
+					}
+
+					if (corner.position < 0 || corner.textureCoordinate < 0 || corner.normal < 0) {
+						RawCorner definedSoFar;
+						definedSoFar.position = vertices.size();
+						definedSoFar.textureCoordinate = textureCoordinates.size();
+						definedSoFar.normal = normals.size();
+						relativeCorners.push_back(std::make_pair((uint32_t) corners.size(), definedSoFar));
+					}
+					corners.push_back(corner);
+					numberOfCorners++;
+				}
+				polygonSizes.push_back(numberOfCorners);
+			}
+		};
+
+		class ChunkOffsets {
+			public:
+				size_t vertices, normals, textureCoordinates, corners, polygons;
+
+			ChunkOffsets() {
+				vertices = normals = textureCoordinates = corners = polygons = 0;
+			}
+		};
+
+		// Turns an index as written in the file into a 0-based index, or NO_INDEX if it's absent (0) or out of range.
+		// 'definedBefore' is how many attributes of this kind come before the face in the whole file
+		static uint32_t resolveIndex(long index, size_t definedBefore, size_t total, bool &valid) {
+			if (index == 0) {
+				return NO_INDEX;
+			}
+			long resolved = (index > 0) ? index - 1 : (long) definedBefore + index;
+			if (resolved < 0 || resolved >= (long) total) {
+				valid = false;
+				return NO_INDEX;
+			}
+			return resolved;
+		}
+
+		// Copies one parsed chunk into the combined arrays and returns how many of its indices are invalid
+		long resolveChunk(Chunk &chunk, ChunkOffsets &start, ChunkOffsets &totals) {
+			for (size_t i = 0; i < chunk.vertices.size(); i++) {
+				vertices.set(start.vertices + i, chunk.vertices[i]);
+			}
+			for (size_t i = 0; i < chunk.normals.size(); i++) {
+				normals.set(start.normals + i, chunk.normals[i]);
+			}
+			std::copy(chunk.textureCoordinates.begin(), chunk.textureCoordinates.end(), textureCoordinates.begin() + start.textureCoordinates);
+
+			uint32_t corner = start.corners;
+			for (size_t p = 0; p < chunk.polygonSizes.size(); p++) {
+				polygonOffsets[start.polygons + p] = corner;
+				corner += chunk.polygonSizes[p];
+			}
+
+			long invalidCorners = 0;
+			size_t nextRelativeCorner = 0;
+			for (size_t k = 0; k < chunk.corners.size(); k++) {
+				RawCorner &raw = chunk.corners[k];
+
+				// Negative indices count back from what had been defined when the face was read
+				RawCorner definedBefore;
+				definedBefore.position = definedBefore.textureCoordinate = definedBefore.normal = 0;
+				if (nextRelativeCorner < chunk.relativeCorners.size() && chunk.relativeCorners[nextRelativeCorner].first == k) {
+					definedBefore = chunk.relativeCorners[nextRelativeCorner].second;
+					nextRelativeCorner++;
+				}
+
+				bool valid = true;
+				size_t out = start.corners + k;
+				positionIndices[out] = resolveIndex(raw.position, start.vertices + definedBefore.position, totals.vertices, valid);
+				textureCoordinateIndices[out] = resolveIndex(raw.textureCoordinate, start.textureCoordinates + definedBefore.textureCoordinate,
+						totals.textureCoordinates, valid);
+				normalIndices[out] = resolveIndex(raw.normal, start.normals + definedBefore.normal, totals.normals, valid);
+				if (positionIndices[out] == NO_INDEX) {
+					valid = false;
+				}
+				if (!valid) {
+					invalidCorners++;
+				}
+			}
+			return invalidCorners;
+		}
+
+		// Drops every corner whose position index is NO_INDEX (only needed for broken files)
+		void removeCornersWithoutVertices() {
+			size_t kept = 0;
+			for (int p = 0; p < getNumberOfPolygons(); p++) {
+				uint32_t first = polygonOffsets[p];
+				uint32_t last = polygonOffsets[p + 1];
+				polygonOffsets[p] = kept;
+				for (uint32_t k = first; k < last; k++) {
+					if (positionIndices[k] != NO_INDEX) {
+						positionIndices[kept] = positionIndices[k];
+						normalIndices[kept] = normalIndices[k];
+						textureCoordinateIndices[kept] = textureCoordinateIndices[k];
+						kept++;
+					}
+				}
+			}
+			polygonOffsets.back() = kept;
+			positionIndices.resize(kept);
+			normalIndices.resize(kept);
+			textureCoordinateIndices.resize(kept);
+		}
+};
+
+
+#endif /* OBJMESH_H_ */
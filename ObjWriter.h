@@ -0,0 +1,301 @@
+/*
+ * ObjWriter.h
+ *
+ *  Created on: Apr 22, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef OBJWRITER_H_
+#define OBJWRITER_H_
+
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+// Writes a Wavefront .obj file through one large buffer, formatting numbers by hand instead of through iostreams.
+//
+// Floats come out exactly as iostream's default formatting (printf's "%g") would write them.
+// writeUniqueVertex / writeUniqueNormal only write values they haven't seen before (compared bit for bit),
+// which is how vertices shared by neighboring BezierPatches get written once.
+class ObjWriter {
+	public:
+
+	ObjWriter(std::string filename) {
+		file.open(filename.c_str(), std::ios::binary);
+		buffer.resize(BUFFER_SIZE);
+		used = 0;
+		bytesWritten = 0;
+		numberOfVertices = 0;
+		numberOfNormals = 0;
+	}
+
+	~ObjWriter() {
+		flush();
+	}
+
+	bool isOpen() {
+		return file.is_open();
+	}
+
+	// Total number of bytes handed to the file so far (including what's still buffered)
+	long getBytesWritten() {
+		return bytesWritten + used;
+	}
+
+	// Writes "v x y z" and returns the (1-based) index that faces should use to refer to it
+	long writeVertex(const Eigen::Vector3f &position) {
+		writeVector("v ", position);
+		return ++numberOfVertices;
+	}
+
+	// Writes "vn x y z" and returns its (1-based) index. A normal that isn't finite (from a degenerate point of a
+	// patch, e.g. a collapsed corner) is written as "0 0 1" instead, since .obj readers (ours included) reject "nan"
+	long writeNormal(const Eigen::Vector3f &normal) {
+		writeVector("vn ", normal.allFinite() ? normal : Eigen::Vector3f(0, 0, 1));
+		return ++numberOfNormals;
+	}
+
+	// Writes a "v" line for 'position' unless an identical one has already been written.
+	// Returns the (1-based) index that faces should use to refer to it
+	long writeUniqueVertex(const Eigen::Vector3f &position) {
+		std::pair<std::unordered_map<VectorKey, long, VectorKeyHash>::iterator, bool> result =
+				vertexIndices.insert(std::make_pair(VectorKey(position), 0L));
+		if (result.second) {
+			result.first->second = writeVertex(position);
+		}
+		return result.first->second;
+	}
+
+	// Same as writeUniqueVertex, for "vn" lines
+	long writeUniqueNormal(const Eigen::Vector3f &normal) {
+		std::pair<std::unordered_map<VectorKey, long, VectorKeyHash>::iterator, bool> result =
+				normalIndices.insert(std::make_pair(VectorKey(normal), 0L));
+		if (result.second) {
+			result.first->second = writeNormal(normal);
+		}
+		return result.first->second;
+	}
+
+	// "f a//na b//nb c//nc", with 1-based indices
+	void writeTriangle(long a, long na, long b, long nb, long c, long nc) {
+		reserve(3 * 2 * MAX_INTEGER_LENGTH + 16);
+		append("f ", 2);
+		writeCorner(a, na);
+		buffer[used++] = ' ';
+		writeCorner(b, nb);
+		buffer[used++] = ' ';
+		writeCorner(c, nc);
+		buffer[used++] = '\n';
+	}
+
+	void flush() {
+		if (used > 0) {
+			file.write(&buffer[0], used);
+			bytesWritten += used;
+			used = 0;
+		}
+	}
+
+	//****************************************************
+	// Writes 'value' the way printf("%g") does (6 significant digits, trailing zeros removed, scientific
+	// notation for very large or small values) into 'out', and returns the number of characters written.
+	//
+	// The 6 digits are found by scaling by an exact power of ten in double precision and rounding to an
+	// integer; values that land too close to a rounding tie for that to be trusted go through snprintf.
+	//***************************************************
+	static int formatFloat(float value, char *out) {
+		double magnitude = std::fabs((double) value);
+		if (magnitude == 0.0) {
+			return std::signbit(value) ? copyString("-0", out) : copyString("0", out);
+		}
+		if (!(magnitude >= 1e-22 && magnitude < 1e22)) {
+			return snprintf(out, MAX_FLOAT_LENGTH, "%g", value);
+		}
+
+		static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		// Decimal exponent of the leading digit, i.e. 10^exponent <= magnitude < 10^(exponent + 1).
+		// Estimated from the binary exponent (log10(2) ~= 1233 / 4096), which is at most one too big
+		int binaryExponent;
+		std::frexp(magnitude, &binaryExponent);
+		int exponent = (binaryExponent * 1233) >> 12;
+		if (exponent < -21 || exponent > 21) {
+			return snprintf(out, MAX_FLOAT_LENGTH, "%g", value);
+		}
+		if (magnitude < (exponent >= 0 ? powersOfTen[exponent] : 1.0 / powersOfTen[-exponent])) {
+			exponent--;
+		}
+
+		// Scale so that the 6 significant digits sit left of the decimal point
+		int shift = 5 - exponent;
+		if (shift > 22 || shift < -22) {
+			return snprintf(out, MAX_FLOAT_LENGTH, "%g", value);
+		}
+		double scaled = (shift >= 0) ? magnitude * powersOfTen[shift] : magnitude / powersOfTen[-shift];
+
+		double fraction = scaled - std::floor(scaled);
+		if (std::fabs(fraction - 0.5) < 1e-7) {
+			return snprintf(out, MAX_FLOAT_LENGTH, "%g", value);
+		}
+		long digits = (long) (scaled + 0.5);
+		if (digits >= 1000000) {
+			// Rounded up to the next power of ten (e.g. 9.999996 -> 10.0000)
+			digits /= 10;
+			exponent++;
+		}
+
+		char digitCharacters[6];
+		for (int i = 5; i >= 0; i--) {
+			digitCharacters[i] = '0' + digits % 10;
+			digits /= 10;
+		}
+		int numberOfDigits = 6;
+		while (numberOfDigits > 1 && digitCharacters[numberOfDigits - 1] == '0') {
+			numberOfDigits--;
+		}
+
+		char *position = out;
+		if (value < 0) {
+			*position++ = '-';
+		}
+
+		if (exponent < -4 || exponent >= 6) {
+			// Scientific: d.ddddde+XX
+			*position++ = digitCharacters[0];
+			if (numberOfDigits > 1) {
+				*position++ = '.';
+				for (int i = 1; i < numberOfDigits; i++) {
+					*position++ = digitCharacters[i];
+				}
+			}
+			*position++ = 'e';
+			*position++ = (exponent < 0) ? '-' : '+';
+			int exponentMagnitude = (exponent < 0) ? -exponent : exponent;
+			*position++ = '0' + exponentMagnitude / 10;
+			*position++ = '0' + exponentMagnitude % 10;
+		} else if (exponent >= 0) {
+			// Fixed, with 'exponent + 1' digits before the decimal point
+			for (int i = 0; i <= exponent; i++) {
+				*position++ = digitCharacters[i];
+			}
+			if (numberOfDigits > exponent + 1) {
+				*position++ = '.';
+				for (int i = exponent + 1; i < numberOfDigits; i++) {
+					*position++ = digitCharacters[i];
+				}
+			}
+		} else {
+			// Fixed, below 1: 0.000ddd
+			*position++ = '0';
+			*position++ = '.';
+			for (int i = 0; i < -exponent - 1; i++) {
+				*position++ = '0';
+			}
+			for (int i = 0; i < numberOfDigits; i++) {
+				*position++ = digitCharacters[i];
+			}
+		}
+		return position - out;
+	}
+
+	private:
+		// The bit patterns of a vector's 3 floats
+		class VectorKey {
+			public:
+				uint32_t bits[3];
+
+			VectorKey(const Eigen::Vector3f &vector) {
+				memcpy(bits, vector.data(), sizeof(bits));
+			}
+
+			bool operator==(const VectorKey &other) const {
+				return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+			}
+		};
+
+		class VectorKeyHash {
+			public:
+			size_t operator()(const VectorKey &key) const {
+				uint64_t hash = key.bits[0] * 0x9E3779B97F4A7C15ULL;
+				hash ^= (key.bits[1] + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2));
+				hash ^= (key.bits[2] + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2));
+				return (size_t) hash;
+			}
+		};
+
+		static const size_t BUFFER_SIZE = 1 << 20;
+		static const int MAX_FLOAT_LENGTH = 32;
+		static const int MAX_INTEGER_LENGTH = 21;
+
+		std::ofstream file;
+		std::vector<char> buffer;
+		size_t used;
+		long bytesWritten;
+
+		long numberOfVertices;
+		long numberOfNormals;
+
+		std::unordered_map<VectorKey, long, VectorKeyHash> vertexIndices;
+		std::unordered_map<VectorKey, long, VectorKeyHash> normalIndices;
+
+	// Makes sure at least 'length' more bytes fit in the buffer
+	void reserve(size_t length) {
+		if (used + length > buffer.size()) {
+			flush();
+		}
+	}
+
+	void append(const char *text, size_t length) {
+		memcpy(&buffer[used], text, length);
+		used += length;
+	}
+
+	void writeVector(const char *prefix, const Eigen::Vector3f &vector) {
+		reserve(3 * MAX_FLOAT_LENGTH + 8);
+		append(prefix, strlen(prefix));
+		used += formatFloat(vector.x(), &buffer[used]);
+		buffer[used++] = ' ';
+		used += formatFloat(vector.y(), &buffer[used]);
+		buffer[used++] = ' ';
+		used += formatFloat(vector.z(), &buffer[used]);
+		buffer[used++] = '\n';
+	}
+
+	void writeCorner(long vertexIndex, long normalIndex) {
+		writeInteger(vertexIndex);
+		append("//", 2);
+		writeInteger(normalIndex);
+	}
+
+	void writeInteger(long value) {
+		char digits[MAX_INTEGER_LENGTH];
+		int length = 0;
+		unsigned long magnitude = (value < 0) ? -(unsigned long) value : value;
+		do {
+			digits[length++] = '0' + magnitude % 10;
+			magnitude /= 10;
+		} while (magnitude > 0);
+
+		if (value < 0) {
+			buffer[used++] = '-';
+		}
+		while (length > 0) {
+			buffer[used++] = digits[--length];
+		}
+	}
+
+	static int copyString(const char *text, char *out) {
+		int length = strlen(text);
+		memcpy(out, text, length);
+		return length;
+	}
+};
+
+
+#endif /* OBJWRITER_H_ */
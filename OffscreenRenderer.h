@@ -0,0 +1,140 @@
+/*
+ * OffscreenRenderer.h
+ *
+ *  Created on: Apr 23, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef OFFSCREENRENDERER_H_
+#define OFFSCREENRENDERER_H_
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <iostream>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// An OpenGL context plus a framebuffer object to draw into, for rendering without a window.
+//
+// On Linux the context comes from EGL with no window system at all (e.g. Mesa's llvmpipe on a
+// headless machine); elsewhere it borrows the context of a hidden GLUT window.
+// Either way everything is drawn into the framebuffer object, never the window.
+class OffscreenRenderer {
+	public:
+
+	OffscreenRenderer() {
+		width = height = 0;
+		framebuffer = colorBuffer = depthBuffer = 0;
+	}
+
+	//****************************************************
+	// Creates a GL context and makes a width x height color + depth framebuffer the current draw target.
+	// Returns false (after printing why) if either can't be created
+	//***************************************************
+	bool create(int width, int height, int argc, char *argv[]) {
+		this->width = width;
+		this->height = height;
+
+		if (!createContext(argc, argv)) {
+			return false;
+		}
+
+		glGenFramebuffers(1, &framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+		glGenRenderbuffers(1, &colorBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+		glGenRenderbuffers(1, &depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			std::cout << "Could not create an offscreen framebuffer.\n";
+			return false;
+		}
+		return true;
+	}
+
+	// Name of the GL implementation we ended up with (e.g. "llvmpipe")
+	std::string getRendererName() {
+		const char *renderer = (const char *) glGetString(GL_RENDERER);
+		return renderer != NULL ? renderer : "unknown";
+	}
+
+	//****************************************************
+	// Writes what has been drawn so far to a binary .ppm (P6) file
+	//***************************************************
+	bool writePPM(std::string filename) {
+		std::vector<unsigned char> pixels(width * height * 3);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+		FILE *file = fopen(filename.c_str(), "wb");
+		if (file == NULL) {
+			return false;
+		}
+		fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+		// OpenGL's rows start at the bottom of the image, .ppm's at the top
+		for (int row = height - 1; row >= 0; row--) {
+			fwrite(&pixels[row * width * 3], 1, width * 3, file);
+		}
+		fclose(file);
+		return true;
+	}
+
+	private:
+		int width, height;
+		GLuint framebuffer, colorBuffer, depthBuffer;
+
+#ifdef __linux__
+	bool createContext(int argc, char *argv[]) {
+		// Prefer Mesa's surfaceless platform, which needs no X server; otherwise use the default display
+		EGLDisplay display = EGL_NO_DISPLAY;
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+				(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL) {
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+		if (display == EGL_NO_DISPLAY) {
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		EGLint major, minor;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			std::cout << "Could not initialize EGL for offscreen rendering.\n";
+			return false;
+		}
+
+		// A compatibility (not core) context, since we draw with the fixed-function pipeline.
+		// With no window we never need a surface, so we don't need a config either
+		eglBindAPI(EGL_OPENGL_API);
+		EGLContext context = eglCreateContext(display, (EGLConfig) 0, EGL_NO_CONTEXT, NULL);
+		if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			std::cout << "Could not create an EGL context for offscreen rendering.\n";
+			return false;
+		}
+		return true;
+	}
+#else
+	bool createContext(int argc, char *argv[]) {
+		glutInit(&argc, argv);
+		glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGB);
+		glutInitWindowSize(width, height);
+		glutCreateWindow(argv[0]);
+		glutHideWindow();
+		return true;
+	}
+#endif
+};
+
+
+#endif /* OFFSCREENRENDERER_H_ */
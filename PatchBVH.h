@@ -0,0 +1,304 @@
+/*
+ * PatchBVH.h
+ *
+ *  Created on: Apr 25, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef PATCHBVH_H_
+#define PATCHBVH_H_
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+
+// A bounding volume hierarchy over the BezierPatches' bounding boxes, for finding what the camera can see
+// and what a ray hits (in their tessellations, or their exact surfaces) without looking at every patch.
+//
+// Nodes live in one array, and every node covers a contiguous range of patchIndices. It is built top-down,
+// splitting each node along the axis its patch centers are most spread out on, at the point where the
+// surface area heuristic (over a few bins of patch centers) says is cheapest. Patches never move, so it
+// is built once.
+class PatchBVH {
+	public:
+
+	PatchBVH() {
+	}
+
+	bool isEmpty() {
+		return nodes.empty();
+	}
+
+	//****************************************************
+	// Builds the hierarchy over the bounding boxes of 'patches'
+	//***************************************************
+	void build(std::vector<BezierPatch> &patches) {
+		nodes.clear();
+		patchIndices.resize(patches.size());
+		patchBounds.resize(patches.size());
+		for (std::vector<BezierPatch>::size_type i = 0; i < patches.size(); i++) {
+			patchIndices[i] = i;
+			patchBounds[i] = patches[i].bounds;
+		}
+		if (patches.empty()) {
+			return;
+		}
+
+		nodes.reserve(2 * patches.size());
+		nodes.push_back(Node());
+		buildNode(0, 0, patches.size());
+	}
+
+	// Box around every patch (empty if there are none)
+	BoundingBox getSceneBounds() {
+		return nodes.empty() ? BoundingBox() : nodes[0].bounds;
+	}
+
+	//****************************************************
+	// Fills 'visiblePatches' with the index of every patch whose box 'modelviewProjection' may see,
+	// in increasing order. Subtrees entirely inside the view are taken whole, without testing their boxes
+	//***************************************************
+	void findVisiblePatches(const Eigen::Matrix4f &modelviewProjection, std::vector<int> &visiblePatches) {
+		visiblePatches.clear();
+		if (nodes.empty()) {
+			return;
+		}
+
+		int stack[MAX_DEPTH];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0) {
+			const Node &node = nodes[stack[--stackSize]];
+			BoundingBox::Visibility visibility = node.bounds.isInView(modelviewProjection);
+			if (visibility == BoundingBox::OUTSIDE) {
+				continue;
+			}
+			if (visibility == BoundingBox::INSIDE || node.isLeaf()) {
+				visiblePatches.insert(visiblePatches.end(), patchIndices.begin() + node.first,
+						patchIndices.begin() + node.first + node.count);
+			} else {
+				stack[stackSize++] = node.children[1];
+				stack[stackSize++] = node.children[0];
+			}
+		}
+		std::sort(visiblePatches.begin(), visiblePatches.end());
+	}
+
+	//****************************************************
+	// Finds the nearest point where the ray origin + t * direction (t > 0) hits the patches' tessellations.
+	// Returns the patch's index and sets t, or returns -1 if the ray misses everything
+	//***************************************************
+	int pick(std::vector<BezierPatch> &patches, const Eigen::Vector3f &origin, const Eigen::Vector3f &direction, float &t) {
+		float nearest = std::numeric_limits<float>::infinity();
+		int patch = traverse(origin, direction, nearest, [&](int k, float &tHit) {
+			return patches[k].intersectTessellation(origin, direction, nearest, tHit);
+		});
+		if (patch >= 0) {
+			t = nearest;
+		}
+		return patch;
+	}
+
+	//****************************************************
+	// Finds the nearest point where 'ray' hits the patches' actual surfaces (see PatchIntersector),
+	// filling in 'hit'. Returns false if it misses everything
+	//***************************************************
+	bool intersect(std::vector<BezierPatch> &patches, const Ray &ray, RayHit &hit) {
+		hit = RayHit();
+		DifferentialGeometry geometry;
+		hit.patch = traverse(ray.origin, ray.direction, hit.t, [&](int k, float &tHit) {
+			if (PatchIntersector::intersect(patches[k], ray, hit.t, tHit, geometry)) {
+				hit.geometry = geometry;
+				return true;
+			}
+			return false;
+		});
+		return hit.patch >= 0;
+	}
+
+	//****************************************************
+	// intersect() for every ray, spread over the thread pool. hits[i] is where rays[i] hit
+	//***************************************************
+	void intersect(ThreadPool &threadPool, std::vector<BezierPatch> &patches, const std::vector<Ray> &rays,
+			std::vector<RayHit> &hits) {
+		hits.resize(rays.size());
+
+		// Enough chunks to keep every thread busy, each big enough to be worth handing out
+		const size_t RAYS_PER_CHUNK = 1024;
+		int numberOfChunks = (rays.size() + RAYS_PER_CHUNK - 1) / RAYS_PER_CHUNK;
+		threadPool.parallelFor(numberOfChunks, [&](int chunk) {
+			size_t last = std::min(rays.size(), (chunk + 1) * RAYS_PER_CHUNK);
+			for (size_t i = chunk * RAYS_PER_CHUNK; i < last; i++) {
+				intersect(patches, rays[i], hits[i]);
+			}
+		});
+	}
+
+	private:
+		// Traversal stack size. buildNode stops splitting before the tree gets deep enough to overflow it
+		static const int MAX_DEPTH = 64;
+		static const int MAX_PATCHES_PER_LEAF = 4;
+		static const int NUMBER_OF_BINS = 12;
+
+		class Node {
+			public:
+				BoundingBox bounds;
+
+				// The node's patches are patchIndices[first, first + count)
+				int first, count;
+
+				// Inner nodes only: the indices of the two children (-1 for leaves), and the axis they were split along
+				int children[2];
+				int axis;
+
+			Node() {
+				first = count = 0;
+				children[0] = children[1] = -1;
+				axis = 0;
+			}
+
+			bool isLeaf() const {
+				return children[0] < 0;
+			}
+		};
+
+		std::vector<Node> nodes;
+		std::vector<int> patchIndices;
+		std::vector<BoundingBox> patchBounds;
+
+	//****************************************************
+	// Walks the nodes whose boxes the ray enters before 'nearest', calling hitPatch(k, t) for each of their
+	// patches k, which returns true and sets t if the ray hits patch k before 'nearest'. The caller's
+	// 'nearest' is updated with every hit, so that farther nodes are skipped.
+	// Returns the index of the patch hit last (i.e. nearest), or -1
+	//***************************************************
+	template <class HitPatch>
+	int traverse(const Eigen::Vector3f &origin, const Eigen::Vector3f &direction, float &nearest, HitPatch hitPatch) {
+		if (nodes.empty()) {
+			return -1;
+		}
+		Eigen::Vector3f inverseDirection(1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z());
+		int nearestPatch = -1;
+
+		int stack[MAX_DEPTH];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0) {
+			const Node &node = nodes[stack[--stackSize]];
+			float tEnter;
+			if (!node.bounds.intersectRay(origin, inverseDirection, nearest, tEnter)) {
+				continue;
+			}
+
+			if (node.isLeaf()) {
+				for (int k = node.first; k < node.first + node.count; k++) {
+					float tHit;
+					if (patchBounds[patchIndices[k]].intersectRay(origin, inverseDirection, nearest, tEnter)
+							&& hitPatch(patchIndices[k], tHit)) {
+						nearest = tHit;
+						nearestPatch = patchIndices[k];
+					}
+				}
+			} else {
+				// Visit the child the ray enters first first, so that hits there cut the other one short
+				int nearSide = (direction[node.axis] < 0) ? 1 : 0;
+				stack[stackSize++] = node.children[1 - nearSide];
+				stack[stackSize++] = node.children[nearSide];
+			}
+		}
+		return nearestPatch;
+	}
+
+	void buildNode(int nodeIndex, int first, int count, int depth = 0) {
+		BoundingBox bounds;
+		BoundingBox centerBounds;
+		for (int k = first; k < first + count; k++) {
+			bounds.extend(patchBounds[patchIndices[k]]);
+			centerBounds.extend(patchBounds[patchIndices[k]].getCenter());
+		}
+		nodes[nodeIndex].bounds = bounds;
+		nodes[nodeIndex].first = first;
+		nodes[nodeIndex].count = count;
+
+		if (count <= MAX_PATCHES_PER_LEAF || depth >= MAX_DEPTH - 2) {
+			return;
+		}
+
+		// Split along the axis the centers are most spread out on
+		Eigen::Vector3f spread = centerBounds.getSize();
+		int axis = 0;
+		if (spread.y() > spread[axis]) {
+			axis = 1;
+		}
+		if (spread.z() > spread[axis]) {
+			axis = 2;
+		}
+		if (spread[axis] <= 0) {
+			// Every center is the same point; there's nothing to split on
+			return;
+		}
+
+		// Sort the centers into bins, then try a split after every bin
+		BoundingBox binBounds[NUMBER_OF_BINS];
+		int binCounts[NUMBER_OF_BINS] = { 0 };
+		float binScale = NUMBER_OF_BINS / spread[axis];
+		for (int k = first; k < first + count; k++) {
+			int bin = getBin(patchBounds[patchIndices[k]], axis, centerBounds.minimum[axis], binScale);
+			binBounds[bin].extend(patchBounds[patchIndices[k]]);
+			binCounts[bin]++;
+		}
+
+		// Cost of a split = area * count of each side (the shared costs don't change which split is best)
+		float rightCosts[NUMBER_OF_BINS];
+		BoundingBox right;
+		int rightCount = 0;
+		for (int bin = NUMBER_OF_BINS - 1; bin > 0; bin--) {
+			right.extend(binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightCosts[bin] = right.getHalfArea() * rightCount;
+		}
+		int bestSplit = -1;
+		float bestCost = std::numeric_limits<float>::max();
+		BoundingBox left;
+		int leftCount = 0;
+		for (int bin = 0; bin < NUMBER_OF_BINS - 1; bin++) {
+			left.extend(binBounds[bin]);
+			leftCount += binCounts[bin];
+			float cost = left.getHalfArea() * leftCount + rightCosts[bin + 1];
+			if (leftCount > 0 && leftCount < count && cost < bestCost) {
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+		if (bestSplit < 0) {
+			return;
+		}
+
+		// Move the patches left of the split to the front of the range
+		int *middle = std::partition(&patchIndices[first], &patchIndices[first] + count, [&](int patch) {
+			return getBin(patchBounds[patch], axis, centerBounds.minimum[axis], binScale) <= bestSplit;
+		});
+		int leftSize = middle - &patchIndices[first];
+
+		int firstChild = nodes.size();
+		nodes.push_back(Node());
+		buildNode(firstChild, first, leftSize, depth + 1);
+
+		int secondChild = nodes.size();
+		nodes.push_back(Node());
+		buildNode(secondChild, first + leftSize, count - leftSize, depth + 1);
+
+		nodes[nodeIndex].children[0] = firstChild;
+		nodes[nodeIndex].children[1] = secondChild;
+		nodes[nodeIndex].axis = axis;
+	}
+
+	static int getBin(const BoundingBox &box, int axis, float minimum, float binScale) {
+		int bin = (int) ((box.getCenter()[axis] - minimum) * binScale);
+		return std::min(std::max(bin, 0), NUMBER_OF_BINS - 1);
+	}
+};
+
+
+#endif /* PATCHBVH_H_ */
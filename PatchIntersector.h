@@ -0,0 +1,419 @@
+/*
+ * PatchIntersector.h
+ *
+ *  Created on: Apr 26, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef PATCHINTERSECTOR_H_
+#define PATCHINTERSECTOR_H_
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// A ray origin + t * direction
+class Ray {
+	public:
+		Eigen::Vector3f origin, direction;
+
+	Ray() {
+		origin = direction = Eigen::Vector3f(0, 0, 0);
+	}
+
+	Ray(Eigen::Vector3f origin, Eigen::Vector3f direction) {
+		this->origin = origin;
+		this->direction = direction;
+	}
+};
+
+// Where a ray hit: which patch (-1 = nothing), at which t, and the surface there
+class RayHit {
+	public:
+		int patch;
+		float t;
+		DifferentialGeometry geometry;
+
+	RayHit() {
+		patch = -1;
+		t = std::numeric_limits<float>::infinity();
+	}
+};
+
+// Intersects rays with BezierPatches directly, without tessellating them.
+//
+// The patch's control points are moved into "ray space", where the ray is the positive z axis
+// (x and y measured along two planes that contain the ray, z in units of the ray's t), so that the
+// ray hits the surface where x(u, v) = y(u, v) = 0. The patch is then split into quarters with
+// de Casteljau's algorithm, throwing away every piece whose control points' box misses the ray or
+// lies beyond the nearest hit so far (the convex hull property says the piece can't contain a hit then).
+// Once a piece is small and provably crossed by the ray at most once, Newton's method finds the exact (u, v).
+//
+// The pieces and their splitting are templated on the patch's degrees, like BezierSurface, so each
+// degree pair gets its own fully unrolled intersector.
+//
+// A rational patch's pieces keep homogeneous ray-space points (w x, w y, w z, w), which split exactly
+// like ordinary ones. Its weights are positive, so the ray hits it where the polynomials w x and w y are
+// both zero: Newton's method and the one-to-one test run on those, and only the boxes (and z) need the
+// points divided by their weights
+class PatchIntersector {
+	public:
+
+	//****************************************************
+	// Finds the nearest point where 'ray' hits 'patch' with 0 < t < tMax. If there is one, sets t and
+	// 'hit' (position, normal and (u, v) values) and returns true
+	//***************************************************
+	static bool intersect(BezierPatch &patch, const Ray &ray, float tMax, float &t, DifferentialGeometry &hit) {
+		if (patch.isPolynomialBicubic()) {
+			return intersect<3, 3>(patch, patch.controlPoints, ray, tMax, t, hit);
+		}
+		Intersection intersection(patch, ray, tMax, t, hit);
+		visitBezierDegrees(patch.degreeU, patch.degreeV, intersection);
+		return intersection.found;
+	}
+
+	// Same as above, for a patch whose degrees are DegreeU and DegreeV, and whose control points (the
+	// homogeneous ones, if it is rational) are 'controlPoints'
+	template <int DegreeU, int DegreeV, class Point>
+	static bool intersect(BezierPatch &patch, const Point (&controlPoints)[MAX_BEZIER_DEGREE + 1][MAX_BEZIER_DEGREE + 1],
+			const Ray &ray, float tMax, float &t, DifferentialGeometry &hit) {
+		typedef Piece<DegreeU, DegreeV, Point> Piece;
+
+		float lengthSquared = ray.direction.squaredNorm();
+		if (lengthSquared == 0) {
+			return false;
+		}
+
+		// Two unit vectors perpendicular to the ray and to each other
+		Eigen::Vector3f unitDirection = ray.direction / std::sqrt(lengthSquared);
+		Eigen::Vector3f helper = (std::fabs(unitDirection.x()) < 0.5f) ? Eigen::Vector3f::UnitX() : Eigen::Vector3f::UnitY();
+		Eigen::Vector3f xAxis = unitDirection.cross(helper).normalized();
+		Eigen::Vector3f yAxis = unitDirection.cross(xAxis);
+		Eigen::Vector3f zAxis = ray.direction / lengthSquared;
+
+		Piece root;
+		for (int i = 0; i <= DegreeV; i++) {
+			for (int j = 0; j <= DegreeU; j++) {
+				root.points[i][j] = toRaySpace(controlPoints[i][j], ray.origin, xAxis, yAxis, zAxis);
+			}
+		}
+		root.u0 = root.v0 = 0;
+		root.size = 1;
+
+		// How far from the ray (in x and y) counts as on it: a tiny fraction of the patch's extent
+		Eigen::Vector2f rootMinimum, rootMaximum;
+		float zMinimum, zMaximum;
+		root.getBounds(rootMinimum, rootMaximum, zMinimum, zMaximum);
+		float tolerance = (rootMaximum - rootMinimum).maxCoeff() * RELATIVE_TOLERANCE;
+		if (tolerance == 0) {
+			return false;
+		}
+
+		float nearest = tMax;
+		Eigen::Vector2f nearestUV;
+		bool found = false;
+
+		Piece stack[MAX_STACK];
+		int stackSize = 0;
+		stack[stackSize++] = root;
+		while (stackSize > 0) {
+			Piece piece = stack[--stackSize];
+
+			Eigen::Vector2f minimum, maximum;
+			piece.getBounds(minimum, maximum, zMinimum, zMaximum);
+			if (minimum.x() > tolerance || maximum.x() < -tolerance || minimum.y() > tolerance || maximum.y() < -tolerance
+					|| zMaximum <= 0 || zMinimum >= nearest) {
+				continue;
+			}
+
+			if (piece.size <= NEWTON_SIZE && piece.isOneToOne()) {
+				// The ray can cross this piece at most once, so if Newton's method (started in the middle)
+				// finds a hit inside the piece, that's the piece's only one
+				Eigen::Vector2f uv(piece.u0 + piece.size / 2, piece.v0 + piece.size / 2);
+				float z;
+				if (refine(root, tolerance, uv, z) && piece.contains(uv)) {
+					if (z > 0 && z < nearest) {
+						nearest = z;
+						nearestUV = uv;
+						found = true;
+					}
+					continue;
+				}
+			}
+
+			if (piece.size <= MINIMUM_SIZE) {
+				// Too small to be worth splitting further, though it wasn't settled above (e.g. the ray grazes
+				// the surface here, where it folds over). Only a hit Newton's method can confirm counts: the
+				// box of a piece this small can still reach the ray when the surface just misses it
+				Eigen::Vector2f uv(piece.u0 + piece.size / 2, piece.v0 + piece.size / 2);
+				float z;
+				if (refine(root, tolerance, uv, z) && piece.contains(uv) && z > 0 && z < nearest) {
+					nearest = z;
+					nearestUV = uv;
+					found = true;
+				}
+				continue;
+			}
+
+			// Split into quarters, and visit the nearest one first so that its hits cut the others short
+			Piece quarters[4];
+			piece.split(quarters);
+
+			float nearZ[4];
+			for (int k = 0; k < 4; k++) {
+				Eigen::Vector2f quarterMinimum, quarterMaximum;
+				float quarterZMaximum;
+				quarters[k].getBounds(quarterMinimum, quarterMaximum, nearZ[k], quarterZMaximum);
+			}
+			int order[4] = { 0, 1, 2, 3 };
+			std::sort(order, order + 4, [&](int a, int b) { return nearZ[a] > nearZ[b]; });
+			for (int k = 0; k < 4; k++) {
+				stack[stackSize++] = quarters[order[k]];
+			}
+		}
+
+		if (!found) {
+			return false;
+		}
+		t = nearest;
+		hit = patch.evaluateDifferentialGeometryBernstein(nearestUV.x(), nearestUV.y());
+		return true;
+	}
+
+	private:
+		// Pieces this small (in u and v) try Newton's method; pieces this much smaller aren't split any further
+		static constexpr float NEWTON_SIZE = 1.0f / 8;
+		static constexpr float MINIMUM_SIZE = 1.0f / 4096;
+		static const int NEWTON_ITERATIONS = 8;
+
+		// Each split replaces one piece on the stack with four, and there are log2(1 / MINIMUM_SIZE) levels
+		static const int MAX_STACK = 3 * 12 + 4;
+
+		// Fraction of the patch's size that counts as zero distance from the ray
+		static constexpr float RELATIVE_TOLERANCE = 1e-6f;
+
+		// A square piece [u0, u0 + size] x [v0, v0 + size] of a patch of degrees DegreeU and DegreeV, as
+		// ray-space control points (homogeneous ones, for a rational patch)
+		template <int DegreeU, int DegreeV, class Point>
+		class Piece {
+			public:
+				Point points[DegreeV + 1][DegreeU + 1];
+				float u0, v0, size;
+
+			void getBounds(Eigen::Vector2f &minimum, Eigen::Vector2f &maximum, float &zMinimum, float &zMaximum) const {
+				Eigen::Vector3f low = project(points[0][0]);
+				Eigen::Vector3f high = low;
+				for (int i = 0; i <= DegreeV; i++) {
+					for (int j = 0; j <= DegreeU; j++) {
+						Eigen::Vector3f point = project(points[i][j]);
+						low = low.cwiseMin(point);
+						high = high.cwiseMax(point);
+					}
+				}
+				minimum = low.head<2>();
+				maximum = high.head<2>();
+				zMinimum = low.z();
+				zMaximum = high.z();
+			}
+
+			// True if (u, v) is in the piece (give or take rounding)
+			bool contains(const Eigen::Vector2f &uv) const {
+				float margin = size * 1e-3f;
+				return uv.x() >= u0 - margin && uv.x() <= u0 + size + margin && uv.y() >= v0 - margin && uv.y() <= v0 + size + margin;
+			}
+
+			//****************************************************
+			// True if the piece's (x, y) is one-to-one in (u, v), so the ray crosses it at most once.
+			//
+			// The Jacobian determinant x_u y_v - x_v y_u is a positive combination of the cross products of the
+			// control net's u and v differences, so if those all have the same sign, so does the determinant.
+			// (Zero differences, from collapsed edges, don't contribute either way)
+			//***************************************************
+			bool isOneToOne() const {
+				int sign = 0;
+				for (int i = 0; i <= DegreeV; i++) {
+					for (int j = 0; j < DegreeU; j++) {
+						Eigen::Vector2f uDifference = (points[i][j + 1] - points[i][j]).template head<2>();
+						if (uDifference.isZero(0)) {
+							continue;
+						}
+						for (int k = 0; k < DegreeV; k++) {
+							for (int l = 0; l <= DegreeU; l++) {
+								Eigen::Vector2f vDifference = (points[k + 1][l] - points[k][l]).template head<2>();
+								if (vDifference.isZero(0)) {
+									continue;
+								}
+								float cross = uDifference.x() * vDifference.y() - uDifference.y() * vDifference.x();
+								int crossSign = (cross > 0) ? 1 : ((cross < 0) ? -1 : 0);
+								if (crossSign == 0 || (sign != 0 && crossSign != sign)) {
+									return false;
+								}
+								sign = crossSign;
+							}
+						}
+					}
+				}
+				return sign != 0;
+			}
+
+			//****************************************************
+			// Splits the piece into its four quarters: [low u, low v], [low u, high v], [high u, low v], [high u, high v].
+			// u runs along each curve (the second index of points), v across the curves (the first)
+			//***************************************************
+			void split(Piece quarters[4]) const {
+				Piece halves[2];
+				for (int i = 0; i <= DegreeV; i++) {
+					splitCurve<DegreeU>(points[i], 1, halves[0].points[i], halves[1].points[i], 1);
+				}
+				for (int h = 0; h < 2; h++) {
+					for (int j = 0; j <= DegreeU; j++) {
+						splitCurve<DegreeV>(&halves[h].points[0][j], DegreeU + 1, &quarters[2 * h].points[0][j],
+								&quarters[2 * h + 1].points[0][j], DegreeU + 1);
+					}
+				}
+				for (int k = 0; k < 4; k++) {
+					quarters[k].u0 = u0 + ((k & 2) ? size / 2 : 0);
+					quarters[k].v0 = v0 + ((k & 1) ? size / 2 : 0);
+					quarters[k].size = size / 2;
+				}
+			}
+
+			// de Casteljau at 1/2 on the Degree + 1 points 'stride' apart from 'curve': writes the two halves'
+			// control points 'stride' points apart too
+			template <int Degree>
+			static void splitCurve(const Point *curve, int stride, Point *low, Point *high, int outputStride) {
+				Point reduced[Degree + 1];
+				BEZIER_SURFACE_UNROLL
+				for (int k = 0; k <= Degree; k++) {
+					reduced[k] = curve[k * stride];
+				}
+				low[0] = reduced[0];
+				high[Degree * outputStride] = reduced[Degree];
+				BEZIER_SURFACE_UNROLL
+				for (int level = 1; level <= Degree; level++) {
+					BEZIER_SURFACE_UNROLL
+					for (int k = 0; k <= Degree - level; k++) {
+						reduced[k] = (reduced[k] + reduced[k + 1]) * 0.5f;
+					}
+					low[level * outputStride] = reduced[0];
+					high[(Degree - level) * outputStride] = reduced[Degree - level];
+				}
+			}
+		};
+
+		// visitBezierDegrees visitor that runs intersect<DegreeU, DegreeV> for a patch that isn't bicubic
+		class Intersection {
+			public:
+				BezierPatch &patch;
+				const Ray &ray;
+				float tMax;
+				float &t;
+				DifferentialGeometry &hit;
+				bool found;
+
+			Intersection(BezierPatch &patch, const Ray &ray, float tMax, float &t, DifferentialGeometry &hit)
+					: patch(patch), ray(ray), t(t), hit(hit) {
+				this->tMax = tMax;
+				found = false;
+			}
+
+			template <int DegreeU, int DegreeV>
+			void visit() {
+				found = patch.rational ? PatchIntersector::intersect<DegreeU, DegreeV>(patch, patch.getHomogeneousControlPoints(), ray, tMax, t, hit)
+						: PatchIntersector::intersect<DegreeU, DegreeV>(patch, patch.controlPoints, ray, tMax, t, hit);
+			}
+		};
+
+	// A control point moved into ray space: 'origin' goes to 0, and x, y and z are measured along the axes
+	static Eigen::Vector3f toRaySpace(const Eigen::Vector3f &point, const Eigen::Vector3f &origin, const Eigen::Vector3f &xAxis,
+			const Eigen::Vector3f &yAxis, const Eigen::Vector3f &zAxis) {
+		Eigen::Vector3f relative = point - origin;
+		return Eigen::Vector3f(xAxis.dot(relative), yAxis.dot(relative), zAxis.dot(relative));
+	}
+
+	// Same as above, for a homogeneous point (w p, w), which becomes (w p', w) for p' = p in ray space
+	static Eigen::Vector4f toRaySpace(const Eigen::Vector4f &point, const Eigen::Vector3f &origin, const Eigen::Vector3f &xAxis,
+			const Eigen::Vector3f &yAxis, const Eigen::Vector3f &zAxis) {
+		Eigen::Vector3f relative = point.head<3>() - point.w() * origin;
+		return Eigen::Vector4f(xAxis.dot(relative), yAxis.dot(relative), zAxis.dot(relative), point.w());
+	}
+
+	// The 3D point that a (ray-space) control point or surface point stands for
+	static const Eigen::Vector3f &project(const Eigen::Vector3f &point) {
+		return point;
+	}
+
+	static Eigen::Vector3f project(const Eigen::Vector4f &point) {
+		return point.head<3>() / point.w();
+	}
+
+	// The ray-space point at (u, v) of the whole patch, and optionally its partial derivatives
+	// (all homogeneous, for a rational patch)
+	template <int DegreeU, int DegreeV, class Point>
+	static Point evaluate(const Piece<DegreeU, DegreeV, Point> &root, const Eigen::Vector2f &uv,
+			Point *uDerivative = NULL, Point *vDerivative = NULL) {
+		float uWeights[DegreeU + 1], uDerivativeWeights[DegreeU + 1];
+		float vWeights[DegreeV + 1], vDerivativeWeights[DegreeV + 1];
+		BernsteinBasis<DegreeU>::evaluate(uv.x(), uWeights, uDerivativeWeights);
+		BernsteinBasis<DegreeV>::evaluate(uv.y(), vWeights, vDerivativeWeights);
+
+		Point point = Point::Zero();
+		Point du = Point::Zero();
+		Point dv = Point::Zero();
+		BEZIER_SURFACE_UNROLL
+		for (int i = 0; i <= DegreeV; i++) {
+			Point curvePoint = uWeights[0] * root.points[i][0];
+			Point curveDerivative = uDerivativeWeights[0] * root.points[i][0];
+			BEZIER_SURFACE_UNROLL
+			for (int j = 1; j <= DegreeU; j++) {
+				curvePoint += uWeights[j] * root.points[i][j];
+				curveDerivative += uDerivativeWeights[j] * root.points[i][j];
+			}
+			point += vWeights[i] * curvePoint;
+			du += vWeights[i] * curveDerivative;
+			dv += vDerivativeWeights[i] * curvePoint;
+		}
+		if (uDerivative != NULL) {
+			*uDerivative = du;
+			*vDerivative = dv;
+		}
+		return point;
+	}
+
+	//****************************************************
+	// Newton's method on x(u, v) = y(u, v) = 0 (for a rational patch, on w x = w y = 0), starting from 'uv'.
+	// Returns true (with uv and the hit's ray-space z, i.e. its t) if it gets within 'tolerance' of the ray
+	// inside the patch
+	//***************************************************
+	template <int DegreeU, int DegreeV, class Point>
+	static bool refine(const Piece<DegreeU, DegreeV, Point> &root, float tolerance, Eigen::Vector2f &uv, float &z) {
+		for (int iteration = 0; iteration < NEWTON_ITERATIONS; iteration++) {
+			Point du, dv;
+			Point point = evaluate(root, uv, &du, &dv);
+			Eigen::Vector3f position = project(point);
+			if (std::fabs(position.x()) <= tolerance && std::fabs(position.y()) <= tolerance) {
+				if (uv.x() < 0 || uv.x() > 1 || uv.y() < 0 || uv.y() > 1) {
+					return false;
+				}
+				z = position.z();
+				return true;
+			}
+
+			float determinant = du.x() * dv.y() - dv.x() * du.y();
+			if (determinant == 0 || !std::isfinite(determinant)) {
+				return false;
+			}
+			uv.x() -= (dv.y() * point.x() - dv.x() * point.y()) / determinant;
+			uv.y() -= (du.x() * point.y() - du.y() * point.x()) / determinant;
+
+			// Wandering far outside the patch means it's converging on something else, if at all
+			if (!(uv.x() > -0.5f && uv.x() < 1.5f && uv.y() > -0.5f && uv.y() < 1.5f)) {
+				return false;
+			}
+		}
+		return false;
+	}
+};
+
+
+#endif /* PATCHINTERSECTOR_H_ */
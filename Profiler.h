@@ -0,0 +1,210 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: Apr 28, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Per-stage timings and whole-program counters, for seeing where a run spends its time without an
+// external profiler. Stages are timed with a ScopedTimer around each call; the calls are coarse (a whole
+// parse, tessellation or frame), so the timers are always on. Their allocations are only counted while
+// AllocationCounter is counting.
+//
+// Stages are timed on the main thread only. A stage that runs inside another (e.g. screen-space
+// tessellation inside a frame) counts towards both
+class Profiler {
+	public:
+		enum Stage { PARSE_BEZIER, LOAD_MESH_CACHE, SUBDIVIDE, RETESSELLATE, SCREEN_SPACE_TESSELLATION, EXPORT_OBJ,
+			PARSE_OBJ, FRAME, NUMBER_OF_STAGES };
+
+		// Counters that the program sets before reporting (see setCounter)
+		enum Counter { PATCHES, VERTICES, TRIANGLES, SURFACE_EVALUATIONS, PEAK_ADAPTIVE_FRONTIER,
+			ADAPTIVE_CASE_1, ADAPTIVE_CASE_2, ADAPTIVE_CASE_3, ADAPTIVE_CASE_4,
+			ADAPTIVE_CASE_5, ADAPTIVE_CASE_6, ADAPTIVE_CASE_7, ADAPTIVE_CASE_8,
+			SCRATCH_ARENA_BLOCK_ALLOCATIONS, SCRATCH_ARENA_BYTES, NUMBER_OF_COUNTERS };
+
+		// Times the enclosing scope as one call of 'stage'
+		class ScopedTimer {
+			public:
+
+			ScopedTimer(Profiler &profiler, Stage stage) : profiler(profiler) {
+				this->stage = stage;
+				allocationsBefore = AllocationCounter::numberOfAllocations;
+				bytesBefore = AllocationCounter::bytesAllocated;
+				start = std::chrono::steady_clock::now();
+			}
+
+			~ScopedTimer() {
+				std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+				profiler.record(stage, elapsed.count(), AllocationCounter::numberOfAllocations - allocationsBefore,
+						AllocationCounter::bytesAllocated - bytesBefore);
+			}
+
+			private:
+				Profiler &profiler;
+				Stage stage;
+				long allocationsBefore;
+				long bytesBefore;
+				std::chrono::steady_clock::time_point start;
+		};
+
+	Profiler() {
+		for (int stage = 0; stage < NUMBER_OF_STAGES; stage++) {
+			stages[stage].calls = 0;
+			stages[stage].totalMilliseconds = 0;
+			stages[stage].minimum = stages[stage].maximum = 0;
+			stages[stage].allocations = stages[stage].bytesAllocated = 0;
+			stages[stage].nextRecentTime = 0;
+		}
+		for (int counter = 0; counter < NUMBER_OF_COUNTERS; counter++) {
+			counters[counter] = 0;
+		}
+	}
+
+	void record(Stage stage, double milliseconds, long allocations, long bytesAllocated) {
+		StageStatistics &statistics = stages[stage];
+		statistics.minimum = (statistics.calls == 0) ? milliseconds : std::min(statistics.minimum, milliseconds);
+		statistics.maximum = std::max(statistics.maximum, milliseconds);
+		statistics.calls++;
+		statistics.totalMilliseconds += milliseconds;
+		statistics.allocations += allocations;
+		statistics.bytesAllocated += bytesAllocated;
+
+		// Keep the latest MAX_RECENT_TIMES, overwriting the oldest, so that a long session stays small
+		if (statistics.recentTimes.size() < MAX_RECENT_TIMES) {
+			statistics.recentTimes.push_back(milliseconds);
+		} else {
+			statistics.recentTimes[statistics.nextRecentTime] = milliseconds;
+		}
+		statistics.nextRecentTime = (statistics.nextRecentTime + 1) % MAX_RECENT_TIMES;
+	}
+
+	void setCounter(Counter counter, long value) {
+		counters[counter] = value;
+	}
+
+	//****************************************************
+	// Prints a table of every stage that ran (median and p99 are over its latest calls) and the counters.
+	// Allocation columns are left out unless 'withAllocations'
+	//***************************************************
+	void print(bool withAllocations) {
+		printf("\n  Profile:\n\n");
+		printf("    %-28s %7s %11s %10s %10s %10s %10s %10s", "stage", "calls", "total ms", "min ms", "median ms",
+				"p99 ms", "max ms", "mean ms");
+		if (withAllocations) {
+			printf(" %12s %12s", "allocations", "MB allocated");
+		}
+		printf("\n");
+		for (int stage = 0; stage < NUMBER_OF_STAGES; stage++) {
+			const StageStatistics &statistics = stages[stage];
+			if (statistics.calls == 0) {
+				continue;
+			}
+			printf("    %-28s %7ld %11.3f %10.3f %10.3f %10.3f %10.3f %10.3f", getStageName((Stage) stage), statistics.calls,
+					statistics.totalMilliseconds, statistics.minimum, getRecentPercentile(statistics, 0.50),
+					getRecentPercentile(statistics, 0.99), statistics.maximum, statistics.totalMilliseconds / statistics.calls);
+			if (withAllocations) {
+				printf(" %12ld %12.2f", statistics.allocations, statistics.bytesAllocated / (1024.0 * 1024.0));
+			}
+			printf("\n");
+		}
+		printf("\n");
+		for (int counter = 0; counter < NUMBER_OF_COUNTERS; counter++) {
+			printf("    %-28s %ld\n", getCounterName((Counter) counter), counters[counter]);
+		}
+		fflush(stdout);
+	}
+
+	//****************************************************
+	// Writes the same as print() to 'filename' as one JSON object, with "stages" (one object per stage
+	// that ran) and "counters". Allocations are null unless 'withAllocations'.
+	// Returns false if the file couldn't be written
+	//***************************************************
+	bool writeJSON(std::string filename, bool withAllocations) {
+		FILE *file = fopen(filename.c_str(), "w");
+		if (file == NULL) {
+			return false;
+		}
+		fprintf(file, "{\n  \"stages\": [");
+		bool first = true;
+		for (int stage = 0; stage < NUMBER_OF_STAGES; stage++) {
+			const StageStatistics &statistics = stages[stage];
+			if (statistics.calls == 0) {
+				continue;
+			}
+			fprintf(file, "%s\n    {\"stage\": \"%s\", \"calls\": %ld, \"total_ms\": %.6f, \"min_ms\": %.6f, \"median_ms\": %.6f, "
+					"\"p99_ms\": %.6f, \"max_ms\": %.6f, ", first ? "" : ",", getStageName((Stage) stage), statistics.calls,
+					statistics.totalMilliseconds, statistics.minimum, getRecentPercentile(statistics, 0.50),
+					getRecentPercentile(statistics, 0.99), statistics.maximum);
+			if (withAllocations) {
+				fprintf(file, "\"allocations\": %ld, \"bytes_allocated\": %ld}", statistics.allocations, statistics.bytesAllocated);
+			} else {
+				fprintf(file, "\"allocations\": null, \"bytes_allocated\": null}");
+			}
+			first = false;
+		}
+		fprintf(file, "\n  ],\n  \"counters\": {");
+		for (int counter = 0; counter < NUMBER_OF_COUNTERS; counter++) {
+			fprintf(file, "%s\n    \"%s\": %ld", (counter == 0) ? "" : ",", getCounterName((Counter) counter), counters[counter]);
+		}
+		fprintf(file, "\n  }\n}\n");
+		return fclose(file) == 0;
+	}
+
+	private:
+		static const size_t MAX_RECENT_TIMES = 4096;
+
+		class StageStatistics {
+			public:
+				long calls;
+				double totalMilliseconds;
+				double minimum, maximum;
+				long allocations;
+				long bytesAllocated;
+
+				// The latest calls' times, as a ring buffer whose next slot to overwrite is nextRecentTime
+				std::vector<float> recentTimes;
+				size_t nextRecentTime;
+		};
+
+		StageStatistics stages[NUMBER_OF_STAGES];
+		long counters[NUMBER_OF_COUNTERS];
+
+	// (The names are function-local statics, so the header can be included by more than one source file)
+	static const char *getStageName(Stage stage) {
+		static const char *const names[NUMBER_OF_STAGES] = { "parse_bez", "load_mesh_cache", "subdivide",
+				"retessellate", "screen_space_tessellation", "export_obj", "parse_obj", "frame" };
+		return names[stage];
+	}
+
+	// The adaptive cases are numbered as in BezierPatch::subdivideQueuedTriangles, by which edges they split
+	static const char *getCounterName(Counter counter) {
+		static const char *const names[NUMBER_OF_COUNTERS] = { "patches", "vertices", "triangles",
+				"surface_evaluations", "peak_adaptive_frontier", "adaptive_case_1_no_split", "adaptive_case_2_split_ac",
+				"adaptive_case_3_split_ab", "adaptive_case_4_split_bc", "adaptive_case_5_split_ab_ac",
+				"adaptive_case_6_split_ab_bc", "adaptive_case_7_split_bc_ac", "adaptive_case_8_split_all",
+				"scratch_arena_block_allocations", "scratch_arena_bytes" };
+		return names[counter];
+	}
+
+	// Nearest-rank percentile of the stage's recent times
+	static double getRecentPercentile(const StageStatistics &statistics, double percentile) {
+		std::vector<float> times = statistics.recentTimes;
+		std::sort(times.begin(), times.end());
+		int n = times.size();
+		return times[std::max(0, (int) ceil(percentile * n) - 1)];
+	}
+};
+
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,56 @@
+/*
+ * SamplePacket.h
+ *
+ *  Created on: Apr 18, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef SAMPLEPACKET_H_
+#define SAMPLEPACKET_H_
+
+// A small batch of (u, v) samples of a BezierPatch and the results of evaluating them,
+// stored as a structure of arrays so that one SIMD register holds the same component of several samples.
+//
+// Fill in 'u', 'v' and 'count', hand the packet to BezierPatch::evaluatePacket, and read back
+// positions (x, y, z) and unit normals (nx, ny, nz).
+class SamplePacket {
+	public:
+		// Widest packet any kernel handles at once (one AVX register of floats)
+		static const int MAX_SIZE = 8;
+
+		// Number of valid samples in the packet (lanes past 'count' are ignored)
+		int count;
+
+		alignas(32) float u[MAX_SIZE];
+		alignas(32) float v[MAX_SIZE];
+
+		alignas(32) float x[MAX_SIZE];
+		alignas(32) float y[MAX_SIZE];
+		alignas(32) float z[MAX_SIZE];
+
+		alignas(32) float nx[MAX_SIZE];
+		alignas(32) float ny[MAX_SIZE];
+		alignas(32) float nz[MAX_SIZE];
+
+	SamplePacket() {
+		count = 0;
+		for (int i = 0; i < MAX_SIZE; i++) {
+			u[i] = v[i] = 0.0f;
+		}
+	}
+
+	void addSample(float uValue, float vValue) {
+		u[count] = uValue;
+		v[count] = vValue;
+		count++;
+	}
+
+	// Packages the i-th result as a DifferentialGeometry
+	DifferentialGeometry getDifferentialGeometry(int i) {
+		return DifferentialGeometry(Eigen::Vector3f(x[i], y[i], z[i]), Eigen::Vector3f(nx[i], ny[i], nz[i]),
+				Eigen::Vector2f(u[i], v[i]));
+	}
+};
+
+
+#endif /* SAMPLEPACKET_H_ */
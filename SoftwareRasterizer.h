@@ -0,0 +1,687 @@
+/*
+ * SoftwareRasterizer.h
+ *
+ *  Created on: Apr 24, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef SOFTWARERASTERIZER_H_
+#define SOFTWARERASTERIZER_H_
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+// Draws the scene on the CPU, for machines without a GPU (or with only a slow software GL).
+//
+// It follows the same fixed-function pipeline the OpenGL path uses: per-vertex lighting with OpenGL's
+// default material, clipping against the near plane, a z-buffer with GL_LESS, and Gouraud (or flat)
+// shading, so both produce the same images up to rounding.
+//
+// Each frame runs in three parallel steps on the ThreadPool: transform and light every vertex; set up
+// the triangles and sort them into the screen tiles they overlap ("binning"); then draw every tile on
+// its own. Every tile draws its triangles in the order they were submitted, so the result doesn't
+// depend on the number of threads.
+class SoftwareRasterizer {
+	public:
+		enum Mode { FILLED, WIREFRAME, HIDDEN_LINE };
+
+		// A light as glLightfv gives it: position in eye space (w = 0 for a directional light) and diffuse color
+		class Light {
+			public:
+				Eigen::Vector4f position;
+				Eigen::Vector3f diffuse;
+
+			Light(Eigen::Vector4f position, Eigen::Vector3f diffuse) {
+				this->position = position;
+				this->diffuse = diffuse;
+			}
+
+			EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+		};
+
+		// Lights hold a Vector4f, so they need Eigen's 16-byte aligned storage
+		typedef std::vector<Light, Eigen::aligned_allocator<Light> > LightList;
+
+	SoftwareRasterizer() {
+		width = height = 0;
+		tilesAcross = tilesDown = 0;
+		uploadedGeneration = -1;
+		flatShadingCorner = 2;
+		globalAmbient = Eigen::Vector3f(0.2f, 0.2f, 0.2f);
+	}
+
+	void setLighting(Eigen::Vector3f globalAmbient, const LightList &lights) {
+		this->globalAmbient = globalAmbient;
+		this->lights = lights;
+	}
+
+	// True if the mesh already holds tessellation 'generation'
+	bool isCurrent(long generation) {
+		return uploadedGeneration == generation;
+	}
+
+	long getNumberOfTriangles() {
+		return triangleIndices.size() / 3;
+	}
+
+	// True if the mesh holds exactly these patches (see setPatches)
+	bool holdsPatches(const std::vector<int> &patchesToDraw) {
+		return patchesInMesh == patchesToDraw;
+	}
+
+	//****************************************************
+	// Takes the triangles of patches[k] for every k in 'patchesToDraw' as the mesh to draw (like MeshBuffer::upload)
+	//***************************************************
+	void setPatches(std::vector<BezierPatch> &patches, const std::vector<int> &patchesToDraw, long generation) {
+		vertices.clear();
+		triangleIndices.clear();
+		edgeIndices.clear();
+
+		uint32_t firstVertexOfPatch = 0;
+		for (std::vector<int>::size_type k = 0; k < patchesToDraw.size(); k++) {
+			int i = patchesToDraw[k];
+			const TessellationList<DifferentialGeometry> &patchVertices = patches[i].listOfDifferentialGeometries;
+			vertices.append(patchVertices);
+
+			const TessellationList<uint32_t> &patchIndices = patches[i].listOfTriangleIndices;
+			for (TessellationList<uint32_t>::size_type j = 0; j < patchIndices.size(); j += 3) {
+				uint32_t a = firstVertexOfPatch + patchIndices[j];
+				uint32_t b = firstVertexOfPatch + patchIndices[j + 1];
+				uint32_t c = firstVertexOfPatch + patchIndices[j + 2];
+				addTriangle(a, b, c);
+				addEdge(a, b);
+				addEdge(b, c);
+				addEdge(c, a);
+			}
+			firstVertexOfPatch += patchVertices.size();
+		}
+
+		// GL_TRIANGLES takes a flat-shaded triangle's color from its last vertex
+		flatShadingCorner = 2;
+		patchesInMesh = patchesToDraw;
+		uploadedGeneration = generation;
+	}
+
+	//****************************************************
+	// Takes an .obj mesh as the mesh to draw. Polygons are split into triangle fans,
+	// but wireframes only show the polygons' own edges, as with GL_POLYGON
+	//***************************************************
+	void setObjMesh(ObjMesh &mesh, long generation) {
+		vertices.clear();
+		triangleIndices.clear();
+		edgeIndices.clear();
+
+		// Every corner becomes its own vertex, since corners can pair the same position with different normals.
+		// Corners without a normal get OpenGL's initial current normal
+		vertices.reserve(mesh.positionIndices.size());
+		for (std::vector<uint32_t>::size_type k = 0; k < mesh.positionIndices.size(); k++) {
+			Eigen::Vector3f normal(0, 0, 1);
+			if (mesh.normalIndices[k] != ObjMesh::NO_INDEX) {
+				normal = mesh.normals.get(mesh.normalIndices[k]);
+			}
+			Eigen::Vector2f textureCoordinate(0, 0);
+			if (mesh.textureCoordinateIndices[k] != ObjMesh::NO_INDEX) {
+				textureCoordinate = mesh.textureCoordinates[mesh.textureCoordinateIndices[k]];
+			}
+			vertices.push_back(DifferentialGeometry(mesh.vertices.get(mesh.positionIndices[k]), normal, textureCoordinate));
+		}
+
+		for (int p = 0; p < mesh.getNumberOfPolygons(); p++) {
+			uint32_t first = mesh.polygonOffsets[p];
+			uint32_t last = mesh.polygonOffsets[p + 1];
+			for (uint32_t k = first + 1; k + 1 < last; k++) {
+				addTriangle(first, k, k + 1);
+			}
+			for (uint32_t k = first; k < last; k++) {
+				addEdge(k, (k + 1 < last) ? k + 1 : first);
+			}
+		}
+
+		// GL_POLYGON takes a flat-shaded polygon's color from its first vertex
+		flatShadingCorner = 0;
+		patchesInMesh.clear();
+		uploadedGeneration = generation;
+	}
+
+	//****************************************************
+	// Draws the mesh into a width x height image, as OpenGL would with the given matrices.
+	// The image is cleared to black first
+	//***************************************************
+	void render(ThreadPool &threadPool, int width, int height, const Eigen::Matrix4f &modelview,
+			const Eigen::Matrix4f &projection, Mode mode, bool smoothShading) {
+		resize(width, height);
+
+		// Step 1: transform (and, if we're filling with shading, light) every vertex
+		Eigen::Matrix4f modelviewProjection = projection * modelview;
+		bool lit = (mode == FILLED);
+		clipPositions.resize(vertices.size());
+		colors.resize(vertices.size());
+
+		const CoordinateArrays &positions = vertices.positions;
+		const CoordinateArrays &normals = vertices.normals;
+		int numberOfVertexChunks = chunkCount(vertices.size(), threadPool);
+		threadPool.parallelFor(numberOfVertexChunks, [&](int chunk) {
+			size_t first = vertices.size() * chunk / numberOfVertexChunks;
+			size_t last = vertices.size() * (chunk + 1) / numberOfVertexChunks;
+			for (size_t i = first; i < last; i++) {
+				Eigen::Vector4f position(positions.x[i], positions.y[i], positions.z[i], 1.0f);
+				clipPositions[i] = modelviewProjection * position;
+				if (lit) {
+					colors[i] = computeLighting((modelview * position).head<3>(), modelview.block<3, 3>(0, 0) * normals.get(i));
+				}
+			}
+		});
+
+		// Step 2: set up and bin triangles (for filling) and edges (for wireframes), each chunk into its own bins
+		int numberOfChunks = std::max(chunkCount(triangleIndices.size() / 3, threadPool), chunkCount(edgeIndices.size() / 2, threadPool));
+		prepareChunks(numberOfChunks);
+
+		bool drawTriangles = (mode == FILLED || mode == HIDDEN_LINE);
+		bool drawLines = (mode == WIREFRAME || mode == HIDDEN_LINE);
+		threadPool.parallelFor(numberOfChunks, [&](int chunk) {
+			if (drawTriangles) {
+				size_t numberOfTriangles = triangleIndices.size() / 3;
+				size_t first = numberOfTriangles * chunk / numberOfChunks;
+				size_t last = numberOfTriangles * (chunk + 1) / numberOfChunks;
+				for (size_t t = first; t < last; t++) {
+					setUpTriangle(chunks[chunk], &triangleIndices[3 * t], smoothShading, mode == HIDDEN_LINE);
+				}
+			}
+			if (drawLines) {
+				size_t numberOfEdges = edgeIndices.size() / 2;
+				size_t first = numberOfEdges * chunk / numberOfChunks;
+				size_t last = numberOfEdges * (chunk + 1) / numberOfChunks;
+				for (size_t e = first; e < last; e++) {
+					setUpLine(chunks[chunk], edgeIndices[2 * e], edgeIndices[2 * e + 1]);
+				}
+			}
+		});
+
+		// Step 3: draw every tile. Hidden-line mode draws the white lines, then fills the triangles in black
+		// (pushed back slightly, as glPolygonOffset does) to hide the lines behind them, just like myDisplay
+		threadPool.parallelFor(tilesAcross * tilesDown, [&](int tile) {
+			drawTile(tile, drawLines, drawTriangles);
+		});
+	}
+
+	// The image from the last render(), as tightly packed RGB rows from the bottom up (like glReadPixels)
+	const unsigned char *getPixels() {
+		return pixels.empty() ? NULL : &pixels[0];
+	}
+
+	//****************************************************
+	// Writes the last rendered image to a binary .ppm (P6) file
+	//***************************************************
+	bool writePPM(std::string filename) {
+		FILE *file = fopen(filename.c_str(), "wb");
+		if (file == NULL) {
+			return false;
+		}
+		fprintf(file, "P6\n%d %d\n255\n", width, height);
+		for (int row = height - 1; row >= 0; row--) {
+			fwrite(&pixels[row * width * 3], 1, width * 3, file);
+		}
+		fclose(file);
+		return true;
+	}
+
+	private:
+		static const int TILE_SIZE = 64;
+
+		// A triangle after clipping, in window coordinates, ready to be drawn
+		class SetUpTriangle {
+			public:
+				float x[3], y[3];
+
+				// Window depth in [0, 1], plus any polygon offset
+				float z[3];
+
+				// 1 / clip w, and the vertex colors premultiplied by it, for perspective-correct interpolation
+				float inverseW[3];
+				Eigen::Vector3f colorOverW[3];
+
+				// Set if the triangle is drawn in one color (flat shading, or the black hidden-line fill)
+				bool flat;
+				Eigen::Vector3f flatColor;
+		};
+
+		class SetUpLine {
+			public:
+				float x[2], y[2], z[2];
+		};
+
+		// What one chunk of the triangle / edge lists produced: its set up primitives, and for
+		// every tile, which of them overlap it
+		class Chunk {
+			public:
+				std::vector<SetUpTriangle> triangles;
+				std::vector<SetUpLine> lines;
+				std::vector<std::vector<uint32_t> > triangleBins;
+				std::vector<std::vector<uint32_t> > lineBins;
+		};
+
+		// The mesh
+		VertexArrays vertices;
+		std::vector<uint32_t> triangleIndices;
+		std::vector<uint32_t> edgeIndices;
+		int flatShadingCorner;
+		long uploadedGeneration;
+
+		// Which patches setPatches took the mesh from
+		std::vector<int> patchesInMesh;
+
+		Eigen::Vector3f globalAmbient;
+		LightList lights;
+
+		// Per frame
+		std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > clipPositions;
+		std::vector<Eigen::Vector3f> colors;
+		std::vector<Chunk> chunks;
+
+		// The image
+		int width, height;
+		int tilesAcross, tilesDown;
+		std::vector<unsigned char> pixels;
+		std::vector<float> depthBuffer;
+
+	void addTriangle(uint32_t a, uint32_t b, uint32_t c) {
+		triangleIndices.push_back(a);
+		triangleIndices.push_back(b);
+		triangleIndices.push_back(c);
+	}
+
+	void addEdge(uint32_t a, uint32_t b) {
+		edgeIndices.push_back(a);
+		edgeIndices.push_back(b);
+	}
+
+	// A few chunks per thread, but not so many that each is tiny
+	static int chunkCount(size_t numberOfItems, ThreadPool &threadPool) {
+		const size_t MINIMUM_CHUNK_SIZE = 1024;
+		return std::max((size_t) 1, std::min((size_t) threadPool.size() * 4, numberOfItems / MINIMUM_CHUNK_SIZE));
+	}
+
+	void resize(int width, int height) {
+		if (width != this->width || height != this->height) {
+			this->width = width;
+			this->height = height;
+			tilesAcross = (width + TILE_SIZE - 1) / TILE_SIZE;
+			tilesDown = (height + TILE_SIZE - 1) / TILE_SIZE;
+			pixels.assign(width * height * 3, 0);
+			depthBuffer.assign(width * height, 1.0f);
+			chunks.clear();
+		}
+	}
+
+	// Empties every chunk's primitives and bins, keeping their memory for the next frame
+	void prepareChunks(int numberOfChunks) {
+		chunks.resize(numberOfChunks);
+		for (int c = 0; c < numberOfChunks; c++) {
+			chunks[c].triangles.clear();
+			chunks[c].lines.clear();
+			chunks[c].triangleBins.resize(tilesAcross * tilesDown);
+			chunks[c].lineBins.resize(tilesAcross * tilesDown);
+			for (int t = 0; t < tilesAcross * tilesDown; t++) {
+				chunks[c].triangleBins[t].clear();
+				chunks[c].lineBins[t].clear();
+			}
+		}
+	}
+
+	//****************************************************
+	// OpenGL's lighting equation for one vertex (in eye space), with the default material
+	// (ambient 0.2, diffuse 0.8, no specular or emission) and lights that have only a diffuse color
+	//***************************************************
+	Eigen::Vector3f computeLighting(const Eigen::Vector3f &eyePosition, const Eigen::Vector3f &eyeNormal) {
+		const float MATERIAL_AMBIENT = 0.2f;
+		const float MATERIAL_DIFFUSE = 0.8f;
+
+		Eigen::Vector3f color = globalAmbient * MATERIAL_AMBIENT;
+		for (LightList::size_type i = 0; i < lights.size(); i++) {
+			Eigen::Vector3f toLight;
+			if (lights[i].position.w() == 0.0f) {
+				toLight = lights[i].position.head<3>().normalized();
+			} else {
+				toLight = (lights[i].position.head<3>() / lights[i].position.w() - eyePosition).normalized();
+			}
+			float diffuse = std::max(0.0f, eyeNormal.dot(toLight));
+			color += lights[i].diffuse * (diffuse * MATERIAL_DIFFUSE);
+		}
+		return color.cwiseMin(1.0f);
+	}
+
+	// A vertex in clip space with its color, for clipping
+	class ClipVertex {
+		public:
+			Eigen::Vector4f position;
+			Eigen::Vector3f color;
+	};
+
+	//****************************************************
+	// Clips a triangle against the near plane, projects it to the window and adds it to the bins
+	// of the tiles it overlaps
+	//***************************************************
+	void setUpTriangle(Chunk &chunk, const uint32_t *corners, bool smoothShading, bool hiddenLineFill) {
+		const Eigen::Vector4f &a = clipPositions[corners[0]];
+		const Eigen::Vector4f &b = clipPositions[corners[1]];
+		const Eigen::Vector4f &c = clipPositions[corners[2]];
+
+		// Skip triangles entirely outside one of the frustum's side planes
+		if ((a.x() > a.w() && b.x() > b.w() && c.x() > c.w()) || (a.x() < -a.w() && b.x() < -b.w() && c.x() < -c.w())
+				|| (a.y() > a.w() && b.y() > b.w() && c.y() > c.w()) || (a.y() < -a.w() && b.y() < -b.w() && c.y() < -c.w())
+				|| (a.z() > a.w() && b.z() > b.w() && c.z() > c.w())) {
+			return;
+		}
+
+		ClipVertex polygon[4];
+		int numberOfVertices = 0;
+		ClipVertex triangle[3];
+		for (int i = 0; i < 3; i++) {
+			triangle[i].position = clipPositions[corners[i]];
+			triangle[i].color = colors[corners[i]];
+		}
+
+		// Sutherland-Hodgman against the near plane (z >= -w) only; the other planes are handled per pixel
+		for (int i = 0; i < 3; i++) {
+			const ClipVertex &current = triangle[i];
+			const ClipVertex &next = triangle[(i + 1) % 3];
+			float currentDistance = current.position.z() + current.position.w();
+			float nextDistance = next.position.z() + next.position.w();
+			if (currentDistance >= 0) {
+				polygon[numberOfVertices++] = current;
+			}
+			if ((currentDistance >= 0) != (nextDistance >= 0)) {
+				float t = currentDistance / (currentDistance - nextDistance);
+				polygon[numberOfVertices].position = current.position + t * (next.position - current.position);
+				polygon[numberOfVertices].color = current.color + t * (next.color - current.color);
+				numberOfVertices++;
+			}
+		}
+
+		Eigen::Vector3f flatColor = hiddenLineFill ? Eigen::Vector3f(0, 0, 0) : colors[corners[flatShadingCorner]];
+		bool flat = hiddenLineFill || !smoothShading;
+		for (int i = 1; i + 1 < numberOfVertices; i++) {
+			addTriangle(chunk, polygon[0], polygon[i], polygon[i + 1], flat, flatColor, hiddenLineFill);
+		}
+	}
+
+	void addTriangle(Chunk &chunk, const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, bool flat,
+			const Eigen::Vector3f &flatColor, bool polygonOffset) {
+		SetUpTriangle triangle;
+		const ClipVertex *vertices[3] = { &a, &b, &c };
+		for (int i = 0; i < 3; i++) {
+			float inverseW = 1.0f / vertices[i]->position.w();
+			triangle.x[i] = (vertices[i]->position.x() * inverseW * 0.5f + 0.5f) * width;
+			triangle.y[i] = (vertices[i]->position.y() * inverseW * 0.5f + 0.5f) * height;
+			triangle.z[i] = vertices[i]->position.z() * inverseW * 0.5f + 0.5f;
+			triangle.inverseW[i] = inverseW;
+			triangle.colorOverW[i] = vertices[i]->color * inverseW;
+		}
+		triangle.flat = flat;
+		triangle.flatColor = flatColor;
+
+		float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])
+				- (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+		if (area == 0.0f || area != area) {
+			return;
+		}
+
+		// glPolygonOffset(1.0, 1.0): push the triangle back by its depth slope plus one depth buffer step
+		if (polygonOffset) {
+			float dzdx = ((triangle.z[1] - triangle.z[0]) * (triangle.y[2] - triangle.y[0])
+					- (triangle.z[2] - triangle.z[0]) * (triangle.y[1] - triangle.y[0])) / area;
+			float dzdy = ((triangle.x[1] - triangle.x[0]) * (triangle.z[2] - triangle.z[0])
+					- (triangle.x[2] - triangle.x[0]) * (triangle.z[1] - triangle.z[0])) / area;
+			float offset = std::max(std::fabs(dzdx), std::fabs(dzdy)) + 1.0f / (1 << 24);
+			for (int i = 0; i < 3; i++) {
+				triangle.z[i] += offset;
+			}
+		}
+
+		int firstTileX, lastTileX, firstTileY, lastTileY;
+		if (!overlappedTiles(std::min(triangle.x[0], std::min(triangle.x[1], triangle.x[2])),
+				std::max(triangle.x[0], std::max(triangle.x[1], triangle.x[2])),
+				std::min(triangle.y[0], std::min(triangle.y[1], triangle.y[2])),
+				std::max(triangle.y[0], std::max(triangle.y[1], triangle.y[2])), firstTileX, lastTileX, firstTileY, lastTileY)) {
+			return;
+		}
+
+		uint32_t index = chunk.triangles.size();
+		chunk.triangles.push_back(triangle);
+		for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+			for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+				chunk.triangleBins[tileY * tilesAcross + tileX].push_back(index);
+			}
+		}
+	}
+
+	//****************************************************
+	// Clips an edge against the near plane, projects it and adds it to the bins of the tiles its bounds overlap
+	//***************************************************
+	void setUpLine(Chunk &chunk, uint32_t first, uint32_t second) {
+		Eigen::Vector4f a = clipPositions[first];
+		Eigen::Vector4f b = clipPositions[second];
+
+		float distanceA = a.z() + a.w();
+		float distanceB = b.z() + b.w();
+		if (distanceA < 0 && distanceB < 0) {
+			return;
+		}
+		if (distanceA < 0) {
+			a = a + (distanceA / (distanceA - distanceB)) * (b - a);
+		} else if (distanceB < 0) {
+			b = b + (distanceB / (distanceB - distanceA)) * (a - b);
+		}
+
+		SetUpLine line;
+		const Eigen::Vector4f *ends[2] = { &a, &b };
+		for (int i = 0; i < 2; i++) {
+			float inverseW = 1.0f / ends[i]->w();
+			line.x[i] = (ends[i]->x() * inverseW * 0.5f + 0.5f) * width;
+			line.y[i] = (ends[i]->y() * inverseW * 0.5f + 0.5f) * height;
+			line.z[i] = ends[i]->z() * inverseW * 0.5f + 0.5f;
+		}
+
+		int firstTileX, lastTileX, firstTileY, lastTileY;
+		if (!overlappedTiles(std::min(line.x[0], line.x[1]), std::max(line.x[0], line.x[1]),
+				std::min(line.y[0], line.y[1]), std::max(line.y[0], line.y[1]), firstTileX, lastTileX, firstTileY, lastTileY)) {
+			return;
+		}
+
+		uint32_t index = chunk.lines.size();
+		chunk.lines.push_back(line);
+		for (int tileY = firstTileY; tileY <= lastTileY; tileY++) {
+			for (int tileX = firstTileX; tileX <= lastTileX; tileX++) {
+				chunk.lineBins[tileY * tilesAcross + tileX].push_back(index);
+			}
+		}
+	}
+
+	// Which tiles a window-space bounding box overlaps; false if none
+	bool overlappedTiles(float minimumX, float maximumX, float minimumY, float maximumY,
+			int &firstTileX, int &lastTileX, int &firstTileY, int &lastTileY) {
+		if (!(maximumX >= 0 && minimumX < width && maximumY >= 0 && minimumY < height)) {
+			return false;
+		}
+		firstTileX = clampToInt(minimumX, 0, width - 1) / TILE_SIZE;
+		lastTileX = clampToInt(maximumX, 0, width - 1) / TILE_SIZE;
+		firstTileY = clampToInt(minimumY, 0, height - 1) / TILE_SIZE;
+		lastTileY = clampToInt(maximumY, 0, height - 1) / TILE_SIZE;
+		return true;
+	}
+
+	// (int) value, clamped to [low, high] while still a float: window coordinates of a vertex just in front of
+	// the eye (w near 0) can be far outside the range of an int, where converting them is undefined. NaN gives low
+	static int clampToInt(float value, int low, int high) {
+		if (!(value > low)) {
+			return low;
+		}
+		return (value < high) ? (int) value : high;
+	}
+
+	//****************************************************
+	// Clears one tile, then draws everything binned into it, chunk by chunk (i.e. in submission order)
+	//***************************************************
+	void drawTile(int tile, bool drawLines, bool drawTriangles) {
+		int tileX0 = (tile % tilesAcross) * TILE_SIZE;
+		int tileY0 = (tile / tilesAcross) * TILE_SIZE;
+		int tileX1 = std::min(tileX0 + TILE_SIZE, width);
+		int tileY1 = std::min(tileY0 + TILE_SIZE, height);
+
+		for (int y = tileY0; y < tileY1; y++) {
+			std::fill(&pixels[(y * width + tileX0) * 3], &pixels[(y * width + tileX1) * 3], 0);
+			std::fill(&depthBuffer[y * width + tileX0], &depthBuffer[y * width + tileX1], 1.0f);
+		}
+
+		if (drawLines) {
+			for (std::vector<Chunk>::size_type c = 0; c < chunks.size(); c++) {
+				const std::vector<uint32_t> &bin = chunks[c].lineBins[tile];
+				for (std::vector<uint32_t>::size_type i = 0; i < bin.size(); i++) {
+					drawLine(chunks[c].lines[bin[i]], tileX0, tileY0, tileX1, tileY1);
+				}
+			}
+		}
+		if (drawTriangles) {
+			for (std::vector<Chunk>::size_type c = 0; c < chunks.size(); c++) {
+				const std::vector<uint32_t> &bin = chunks[c].triangleBins[tile];
+				for (std::vector<uint32_t>::size_type i = 0; i < bin.size(); i++) {
+					drawTriangle(chunks[c].triangles[bin[i]], tileX0, tileY0, tileX1, tileY1);
+				}
+			}
+		}
+	}
+
+	// Depth test (GL_LESS, and inside the near / far planes), and depth write if it passes
+	bool testAndWriteDepth(int pixel, float z) {
+		if (z < 0.0f || z > 1.0f || z >= depthBuffer[pixel]) {
+			return false;
+		}
+		depthBuffer[pixel] = z;
+		return true;
+	}
+
+	void writeColor(int pixel, const Eigen::Vector3f &color) {
+		for (int channel = 0; channel < 3; channel++) {
+			pixels[pixel * 3 + channel] = (unsigned char) (std::min(1.0f, std::max(0.0f, color[channel])) * 255.0f + 0.5f);
+		}
+	}
+
+	//****************************************************
+	// Draws the part of a triangle inside the tile [x0, x1) x [y0, y1), sampling at pixel centers.
+	// Edges follow the top-left rule, so triangles that share an edge never both draw a pixel on it
+	//***************************************************
+	void drawTriangle(const SetUpTriangle &triangle, int x0, int y0, int x1, int y1) {
+		const float *x = triangle.x;
+		const float *y = triangle.y;
+
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		float sign = (area > 0) ? 1.0f : -1.0f;
+
+		// Edge i is opposite vertex i; E_i(px, py) = A_i * px + B_i * py + C_i is positive inside
+		float A[3], B[3], C[3];
+		bool inclusive[3];
+		for (int i = 0; i < 3; i++) {
+			int from = (i + 1) % 3;
+			int to = (i + 2) % 3;
+			A[i] = sign * (y[from] - y[to]);
+			B[i] = sign * (x[to] - x[from]);
+			C[i] = -(A[i] * x[from] + B[i] * y[from]);
+
+			// Pixels exactly on an edge belong to the triangle if the edge is a top or left edge
+			inclusive[i] = (A[i] > 0) || (A[i] == 0 && B[i] < 0);
+		}
+
+		int minimumX = clampToInt(std::floor(std::min(x[0], std::min(x[1], x[2]))), x0, x1);
+		int maximumX = clampToInt(std::ceil(std::max(x[0], std::max(x[1], x[2]))), x0 - 1, x1 - 1);
+		int minimumY = clampToInt(std::floor(std::min(y[0], std::min(y[1], y[2]))), y0, y1);
+		int maximumY = clampToInt(std::ceil(std::max(y[0], std::max(y[1], y[2]))), y0 - 1, y1 - 1);
+
+		float inverseArea = 1.0f / (sign * area);
+		for (int py = minimumY; py <= maximumY; py++) {
+			float sampleY = py + 0.5f;
+			for (int px = minimumX; px <= maximumX; px++) {
+				float sampleX = px + 0.5f;
+
+				float weights[3];
+				bool inside = true;
+				for (int i = 0; i < 3; i++) {
+					float edge = A[i] * sampleX + B[i] * sampleY + C[i];
+					if (edge < 0 || (edge == 0 && !inclusive[i])) {
+						inside = false;
+						break;
+					}
+					weights[i] = edge * inverseArea;
+				}
+				if (!inside) {
+					continue;
+				}
+
+				int pixel = py * width + px;
+				float z = weights[0] * triangle.z[0] + weights[1] * triangle.z[1] + weights[2] * triangle.z[2];
+				if (!testAndWriteDepth(pixel, z)) {
+					continue;
+				}
+
+				if (triangle.flat) {
+					writeColor(pixel, triangle.flatColor);
+				} else {
+					float inverseW = weights[0] * triangle.inverseW[0] + weights[1] * triangle.inverseW[1]
+							+ weights[2] * triangle.inverseW[2];
+					Eigen::Vector3f color = (weights[0] * triangle.colorOverW[0] + weights[1] * triangle.colorOverW[1]
+							+ weights[2] * triangle.colorOverW[2]) / inverseW;
+					writeColor(pixel, color);
+				}
+			}
+		}
+	}
+
+	//****************************************************
+	// Draws the part of a white, 1 pixel wide line inside the tile [x0, x1) x [y0, y1), one pixel per
+	// step along its major axis
+	//***************************************************
+	void drawLine(const SetUpLine &line, int x0, int y0, int x1, int y1) {
+		float dx = line.x[1] - line.x[0];
+		float dy = line.y[1] - line.y[0];
+		bool xMajor = std::fabs(dx) >= std::fabs(dy);
+
+		// Walk the major axis at pixel centers, from whichever end is smaller
+		float majorStart = xMajor ? line.x[0] : line.y[0];
+		float majorEnd = xMajor ? line.x[1] : line.y[1];
+		float minorStart = xMajor ? line.y[0] : line.x[0];
+		float majorDelta = xMajor ? dx : dy;
+		float minorDelta = xMajor ? dy : dx;
+		if (majorDelta == 0) {
+			return;
+		}
+
+		int tileMajor0 = xMajor ? x0 : y0;
+		int tileMajor1 = xMajor ? x1 : y1;
+		int tileMinor0 = xMajor ? y0 : x0;
+		int tileMinor1 = xMajor ? y1 : x1;
+
+		int first = clampToInt(std::ceil(std::min(majorStart, majorEnd) - 0.5f), tileMajor0, tileMajor1);
+		int last = clampToInt(std::ceil(std::max(majorStart, majorEnd) - 0.5f) - 1, tileMajor0 - 1, tileMajor1 - 1);
+
+		const Eigen::Vector3f white(1.0f, 1.0f, 1.0f);
+		for (int major = first; major <= last; major++) {
+			float t = (major + 0.5f - majorStart) / majorDelta;
+			int minor = clampToInt(std::floor(minorStart + t * minorDelta), tileMinor0 - 1, tileMinor1);
+			if (minor < tileMinor0 || minor >= tileMinor1) {
+				continue;
+			}
+
+			int pixel = xMajor ? (minor * width + major) : (major * width + minor);
+			float z = line.z[0] + t * (line.z[1] - line.z[0]);
+			if (testAndWriteDepth(pixel, z)) {
+				writeColor(pixel, white);
+			}
+		}
+	}
+};
+
+
+#endif /* SOFTWARERASTERIZER_H_ */
@@ -0,0 +1,191 @@
+/*
+ * TessellationArena.h
+ *
+ *  Created on: Apr 28, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef TESSELLATIONARENA_H_
+#define TESSELLATIONARENA_H_
+
+#include <new>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
+
+// A bump allocator for the scratch memory of one tessellation pass (work queues, basis matrices,
+// temporary grids). Every thread has its own (see forThisThread), so patches tessellated in parallel
+// never share one.
+//
+// Memory is handed out by bumping an offset and is never freed one piece at a time: a Scope remembers the
+// offset when it starts and rewinds to it when it ends, which takes constant time however much was allocated.
+// If a pass needs more than the arena holds, the extra comes from overflow blocks; when the outermost Scope
+// ends they're freed and the arena grows to one block big enough for the whole pass. So once an arena has
+// seen its largest pass, tessellating again never calls operator new
+class TessellationArena {
+	public:
+		// Rewinds the arena to where it was when the Scope was created
+		class Scope {
+			public:
+
+			Scope(TessellationArena &arena) : arena(arena) {
+				block = arena.currentBlock;
+				used = arena.currentBlock->used;
+				arena.depth++;
+			}
+
+			~Scope() {
+				arena.rewind(block, used);
+				arena.depth--;
+				if (arena.depth == 0) {
+					arena.consolidate();
+				}
+			}
+
+			private:
+				TessellationArena &arena;
+				void *block;
+				size_t used;
+		};
+
+	// Calls to operator new that arenas have made, in all threads (only grows).
+	// (These counters are function-local statics, so the header can be included by more than one source file)
+	static std::atomic<long> &numberOfBlockAllocations() {
+		static std::atomic<long> count(0);
+		return count;
+	}
+
+	// Bytes in every arena's blocks, in all threads
+	static std::atomic<long> &bytesReserved() {
+		static std::atomic<long> bytes(0);
+		return bytes;
+	}
+
+	TessellationArena() {
+		depth = 0;
+		peakUsed = 0;
+		currentBlock = &emptyBlock;
+		firstBlock = &emptyBlock;
+		emptyBlock.previous = NULL;
+		emptyBlock.capacity = 0;
+		emptyBlock.used = 0;
+	}
+
+	~TessellationArena() {
+		while (currentBlock != NULL && currentBlock != &emptyBlock) {
+			Block *previous = currentBlock->previous;
+			freeBlock(currentBlock);
+			currentBlock = previous;
+		}
+	}
+
+	// The calling thread's arena
+	static TessellationArena &forThisThread() {
+		static thread_local TessellationArena arena;
+		return arena;
+	}
+
+	//****************************************************
+	// Returns room for 'count' default-constructed T's, aligned for SIMD loads. T must not need its
+	// destructor run, since the memory is simply reused once the enclosing Scope ends
+	//***************************************************
+	template <class T>
+	T *allocate(size_t count) {
+		T *items = (T *) allocateBytes(count * sizeof(T));
+		for (size_t i = 0; i < count; i++) {
+			new (&items[i]) T;
+		}
+		return items;
+	}
+
+	private:
+		enum { ALIGNMENT = 32, MINIMUM_BLOCK_SIZE = 64 * 1024 };
+
+		// A block's header, followed by its 'capacity' bytes
+		class Block {
+			public:
+				Block *previous;
+				size_t capacity;
+				size_t used;
+
+			// The first aligned byte past the header
+			char *data() {
+				return (char *) (((uintptr_t) (this + 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+			}
+		};
+
+		// The block that allocations come from, and the first one (what consolidate keeps)
+		Block *currentBlock;
+		Block *firstBlock;
+
+		// Stands in for a block while the arena has none
+		Block emptyBlock;
+
+		int depth;
+
+		// The most bytes the current outermost Scope has had allocated at once
+		size_t peakUsed;
+
+	void *allocateBytes(size_t size) {
+		size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		if (currentBlock->used + size > currentBlock->capacity) {
+			Block *block = newBlock(std::max(size, std::max((size_t) MINIMUM_BLOCK_SIZE, 2 * currentBlock->capacity)));
+			block->previous = currentBlock;
+			currentBlock = block;
+		}
+		void *pointer = currentBlock->data() + currentBlock->used;
+		currentBlock->used += size;
+		peakUsed = std::max(peakUsed, getTotalUsed());
+		return pointer;
+	}
+
+	// Frees the blocks added after 'block' and rewinds it to 'used'
+	void rewind(void *block, size_t used) {
+		while (currentBlock != (Block *) block) {
+			Block *previous = currentBlock->previous;
+			freeBlock(currentBlock);
+			currentBlock = previous;
+		}
+		currentBlock->used = used;
+	}
+
+	// Once nothing is allocated: if the last pass overflowed the first block, replaces it with one that fits the whole pass
+	void consolidate() {
+		if (peakUsed > firstBlock->capacity) {
+			if (firstBlock != &emptyBlock) {
+				freeBlock(firstBlock);
+			}
+			firstBlock = newBlock(std::max((size_t) MINIMUM_BLOCK_SIZE, peakUsed));
+			firstBlock->previous = NULL;
+			currentBlock = firstBlock;
+		}
+		peakUsed = 0;
+	}
+
+	size_t getTotalUsed() {
+		size_t total = 0;
+		for (Block *block = currentBlock; block != NULL; block = block->previous) {
+			total += block->used;
+		}
+		return total;
+	}
+
+	// (with ALIGNMENT bytes of slack, since operator new only promises 16-byte alignment)
+	static Block *newBlock(size_t capacity) {
+		Block *block = (Block *) ::operator new(sizeof(Block) + ALIGNMENT + capacity);
+		block->capacity = capacity;
+		block->used = 0;
+		numberOfBlockAllocations()++;
+		bytesReserved() += capacity;
+		return block;
+	}
+
+	static void freeBlock(Block *block) {
+		bytesReserved() -= block->capacity;
+		::operator delete(block);
+	}
+};
+
+
+#endif /* TESSELLATIONARENA_H_ */
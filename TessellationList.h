@@ -0,0 +1,199 @@
+/*
+ * TessellationList.h
+ *
+ *  Created on: Apr 28, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef TESSELLATIONLIST_H_
+#define TESSELLATIONLIST_H_
+
+#include <algorithm>
+#include <cstddef>
+
+// A growable array, like std::vector, for a BezierPatch's tessellation output (its vertices, triangle
+// indices and triangle depths), that can also live in a slice of someone else's buffer.
+//
+// attach() points the list at a slice: everything then goes straight into the slice, with no allocation,
+// until it would need more room than the slice has. At that point the list copies itself to storage of its
+// own and carries on like a vector. Copies of a list always get their own storage; moves keep the slice.
+//
+// T must be happy to be copied with assignment and never destroyed (DifferentialGeometry, indices)
+template <class T>
+class TessellationList {
+	public:
+		typedef T *iterator;
+		typedef const T *const_iterator;
+		typedef size_t size_type;
+
+	TessellationList() {
+		items = NULL;
+		count = 0;
+		capacity = 0;
+		ownsItems = false;
+	}
+
+	TessellationList(const TessellationList &other) {
+		items = NULL;
+		count = 0;
+		capacity = 0;
+		ownsItems = false;
+		assign(other.begin(), other.end());
+	}
+
+	TessellationList(TessellationList &&other) noexcept {
+		items = other.items;
+		count = other.count;
+		capacity = other.capacity;
+		ownsItems = other.ownsItems;
+		other.items = NULL;
+		other.count = other.capacity = 0;
+		other.ownsItems = false;
+	}
+
+	~TessellationList() {
+		release();
+	}
+
+	TessellationList &operator=(const TessellationList &other) {
+		if (this != &other) {
+			assign(other.begin(), other.end());
+		}
+		return *this;
+	}
+
+	TessellationList &operator=(TessellationList &&other) noexcept {
+		if (this != &other) {
+			release();
+			items = other.items;
+			count = other.count;
+			capacity = other.capacity;
+			ownsItems = other.ownsItems;
+			other.items = NULL;
+			other.count = other.capacity = 0;
+			other.ownsItems = false;
+		}
+		return *this;
+	}
+
+	//****************************************************
+	// Empties the list and makes it use slice[0 ... sliceCapacity - 1] as its storage.
+	// The slice must outlive the list, or the list must be attached elsewhere (or grow out of it) first
+	//***************************************************
+	void attach(T *slice, size_t sliceCapacity) {
+		release();
+		items = slice;
+		count = 0;
+		capacity = sliceCapacity;
+		ownsItems = false;
+	}
+
+	// True if the list is still using a slice it was attached to
+	bool isAttached() const {
+		return !ownsItems && items != NULL;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	bool empty() const {
+		return count == 0;
+	}
+
+	T *data() {
+		return items;
+	}
+
+	const T *data() const {
+		return items;
+	}
+
+	T *begin() {
+		return items;
+	}
+
+	T *end() {
+		return items + count;
+	}
+
+	const T *begin() const {
+		return items;
+	}
+
+	const T *end() const {
+		return items + count;
+	}
+
+	T &operator[](size_t i) {
+		return items[i];
+	}
+
+	const T &operator[](size_t i) const {
+		return items[i];
+	}
+
+	T &back() {
+		return items[count - 1];
+	}
+
+	// Keeps the storage (and the slice, if the list is attached to one)
+	void clear() {
+		count = 0;
+	}
+
+	void reserve(size_t newCapacity) {
+		if (newCapacity > capacity) {
+			T *newItems = new T[newCapacity];
+			std::copy(items, items + count, newItems);
+			size_t oldCount = count;
+			release();
+			items = newItems;
+			count = oldCount;
+			capacity = newCapacity;
+			ownsItems = true;
+		}
+	}
+
+	// New items are default-constructed (so plain numbers are left uninitialized)
+	void resize(size_t newSize) {
+		reserve(newSize);
+		count = newSize;
+	}
+
+	void push_back(const T &item) {
+		if (count == capacity) {
+			reserve(std::max((size_t) 16, 2 * capacity));
+		}
+		items[count++] = item;
+	}
+
+	template <class Iterator>
+	void assign(Iterator first, Iterator last) {
+		size_t newSize = last - first;
+		count = 0;
+		reserve(newSize);
+		std::copy(first, last, items);
+		count = newSize;
+	}
+
+	private:
+		T *items;
+		size_t count;
+		size_t capacity;
+
+		// False while 'items' is NULL or a slice the list was attached to
+		bool ownsItems;
+
+	void release() {
+		if (ownsItems) {
+			delete[] items;
+		}
+		items = NULL;
+		count = capacity = 0;
+		ownsItems = false;
+	}
+};
+
+
+#endif /* TESSELLATIONLIST_H_ */
@@ -0,0 +1,222 @@
+/*
+ * TextScanner.h
+ *
+ *  Created on: Apr 21, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef TEXTSCANNER_H_
+#define TEXTSCANNER_H_
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+// Walks a block of text (e.g. a MappedFile) token by token without copying it or allocating,
+// in the spirit of std::from_chars. Used by the .bez and .obj parsers.
+class TextScanner {
+	public:
+		const char *position;
+		const char *end;
+
+	TextScanner(const char *begin, const char *end) {
+		this->position = begin;
+		this->end = end;
+	}
+
+	bool atEnd() {
+		return position >= end;
+	}
+
+	// Skips spaces, tabs and newlines
+	void skipWhitespace() {
+		while (position < end && isWhitespace(*position)) {
+			position++;
+		}
+	}
+
+	// Skips spaces and tabs, but stops at the end of the line
+	void skipSpaces() {
+		while (position < end && (*position == ' ' || *position == '\t' || *position == '\r')) {
+			position++;
+		}
+	}
+
+	bool atEndOfLine() {
+		return position >= end || *position == '\n';
+	}
+
+	// Moves to the first character of the next line
+	void skipLine() {
+		const char *newline = (const char *) memchr(position, '\n', end - position);
+		position = (newline == NULL) ? end : newline + 1;
+	}
+
+	// Parses a non-negative or negative integer, leaving 'position' just past it
+	bool parseInt(long &value) {
+		const char *current = position;
+		bool negative = false;
+		if (current < end && (*current == '-' || *current == '+')) {
+			negative = (*current == '-');
+			current++;
+		}
+		if (current >= end || !isDigit(*current)) {
+			return false;
+		}
+
+		long result = 0;
+		while (current < end && isDigit(*current)) {
+			result = result * 10 + (*current - '0');
+			current++;
+		}
+
+		value = negative ? -result : result;
+		position = current;
+		return true;
+	}
+
+	//****************************************************
+	// Parses a decimal floating point number (e.g. "-1.25", "3", "2.5e-3"), leaving 'position' just past it.
+	//
+	// Gives bit-for-bit the same result as strtof: the digits are gathered into an integer mantissa and
+	// scaled by an exact power of ten in double precision, which is correctly rounded; the rare inputs where
+	// rounding that double to float could round differently, or that don't fit the fast path, go to strtof.
+	//***************************************************
+	bool parseFloat(float &value) {
+		const char *start = position;
+		const char *current = position;
+
+		bool negative = false;
+		if (current < end && (*current == '-' || *current == '+')) {
+			negative = (*current == '-');
+			current++;
+		}
+
+		uint64_t mantissa = 0;
+		int significantDigits = 0;
+		int exponent = 0;
+		bool sawDigit = false;
+
+		while (current < end && isDigit(*current)) {
+			accumulateDigit(*current - '0', mantissa, significantDigits, exponent, false);
+			sawDigit = true;
+			current++;
+		}
+		if (current < end && *current == '.') {
+			current++;
+			while (current < end && isDigit(*current)) {
+				accumulateDigit(*current - '0', mantissa, significantDigits, exponent, true);
+				sawDigit = true;
+				current++;
+			}
+		}
+		if (!sawDigit) {
+			return false;
+		}
+
+		if (current < end && (*current == 'e' || *current == 'E')) {
+			const char *exponentStart = current;
+			current++;
+			bool negativeExponent = false;
+			if (current < end && (*current == '-' || *current == '+')) {
+				negativeExponent = (*current == '-');
+				current++;
+			}
+			if (current < end && isDigit(*current)) {
+				int explicitExponent = 0;
+				while (current < end && isDigit(*current)) {
+					if (explicitExponent < 10000) {
+						explicitExponent = explicitExponent * 10 + (*current - '0');
+					}
+					current++;
+				}
+				exponent += negativeExponent ? -explicitExponent : explicitExponent;
+			} else {
+				// Not actually an exponent (e.g. "1e"), so the number stops before the 'e'
+				current = exponentStart;
+			}
+		}
+		position = current;
+
+		// Fast path: both the mantissa and 10^|exponent| are exact doubles, so one multiply/divide rounds correctly
+		static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		if (significantDigits <= 19 && mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+			double result = (double) mantissa;
+			result = (exponent < 0) ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+
+			float rounded = (float) result;
+			if (!isNearFloatMidpoint(result, rounded)) {
+				value = negative ? -rounded : rounded;
+				return true;
+			}
+		}
+
+		// Slow path: hand the token to strtof
+		char token[128];
+		size_t tokenLength = current - start;
+		if (tokenLength >= sizeof(token)) {
+			tokenLength = sizeof(token) - 1;
+		}
+		memcpy(token, start, tokenLength);
+		token[tokenLength] = '\0';
+		value = strtof(token, NULL);
+		return true;
+	}
+
+	// Returns the next whitespace-delimited token as [tokenBegin, tokenEnd), without consuming anything after it
+	bool nextToken(const char *&tokenBegin, const char *&tokenEnd) {
+		skipSpaces();
+		if (atEndOfLine()) {
+			return false;
+		}
+		tokenBegin = position;
+		while (position < end && !isWhitespace(*position)) {
+			position++;
+		}
+		tokenEnd = position;
+		return true;
+	}
+
+	static bool isDigit(char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	static bool isWhitespace(char c) {
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	private:
+
+	static void accumulateDigit(int digit, uint64_t &mantissa, int &significantDigits, int &exponent, bool afterDecimalPoint) {
+		if (mantissa == 0 && digit == 0) {
+			// Leading zeros don't count towards the precision we can represent
+			if (afterDecimalPoint) {
+				exponent--;
+			}
+			return;
+		}
+		if (significantDigits < 19) {
+			mantissa = mantissa * 10 + digit;
+			if (afterDecimalPoint) {
+				exponent--;
+			}
+		} else if (!afterDecimalPoint) {
+			exponent++;
+		}
+		significantDigits++;
+	}
+
+	// True if the correctly rounded double 'result' is within one double ulp of a point halfway
+	// between 'rounded' and one of its float neighbors, where rounding twice might go the wrong way
+	static bool isNearFloatMidpoint(double result, float rounded) {
+		double tolerance = std::fabs(result) * 2.3e-16;
+		double below = ((double) rounded + (double) nextafterf(rounded, -INFINITY)) / 2.0;
+		double above = ((double) rounded + (double) nextafterf(rounded, INFINITY)) / 2.0;
+		return std::fabs(result - below) <= tolerance || std::fabs(result - above) <= tolerance;
+	}
+};
+
+
+#endif /* TEXTSCANNER_H_ */
@@ -0,0 +1,195 @@
+/*
+ * ThreadPool.h
+ *
+ *  Created on: Apr 19, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+
+// A fixed set of worker threads that run parallel loops over task indices.
+//
+// Each worker (plus the calling thread, which works too) owns a deque of task indices.
+// Tasks are handed out in contiguous blocks; a worker takes tasks from the front of its own deque,
+// and once that runs dry it steals from the back of someone else's. This keeps every core busy
+// even when task costs vary wildly (e.g. BezierPatches under adaptive subdivision).
+class ThreadPool {
+	public:
+
+	// 'numberOfThreads' counts the calling thread, so ThreadPool(1) runs everything serially
+	ThreadPool(int numberOfThreads) {
+		if (numberOfThreads < 1) {
+			numberOfThreads = 1;
+		}
+
+		this->numberOfThreads = numberOfThreads;
+		generation = 0;
+		stopping = false;
+
+		for (int i = 1; i < numberOfThreads; i++) {
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeWorkers.notify_all();
+
+		for (std::vector<std::thread>::size_type i = 0; i < workers.size(); i++) {
+			workers[i].join();
+		}
+	}
+
+	int size() {
+		return numberOfThreads;
+	}
+
+	//****************************************************
+	// Runs task(i) for every i in [0, numberOfTasks) across all threads and
+	// returns once every task has finished
+	//***************************************************
+	void parallelFor(int numberOfTasks, std::function<void(int)> task) {
+		if (numberOfTasks <= 0) {
+			return;
+		}
+
+		// Deal the tasks out in contiguous blocks, one block per thread
+		std::shared_ptr<Job> job(new Job(numberOfThreads));
+		job->task = task;
+		job->tasksRemaining = numberOfTasks;
+		for (int q = 0; q < numberOfThreads; q++) {
+			int first = (long) numberOfTasks * q / numberOfThreads;
+			int last = (long) numberOfTasks * (q + 1) / numberOfThreads;
+			for (int i = first; i < last; i++) {
+				job->queues[q]->tasks.push_back(i);
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			currentJob = job;
+			generation++;
+		}
+		wakeWorkers.notify_all();
+
+		// The calling thread works on queue 0 alongside the workers
+		runTasks(*job, 0);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		while (job->tasksRemaining > 0) {
+			allTasksDone.wait(lock);
+		}
+		currentJob.reset();
+	}
+
+	private:
+
+	class WorkQueue {
+		public:
+			std::mutex mutex;
+			std::deque<int> tasks;
+	};
+
+	// One call to parallelFor. Workers hold on to the Job they woke up for, so a worker that
+	// wakes up late can only ever find that job's (empty) queues, never the next job's tasks.
+	class Job {
+		public:
+			std::function<void(int)> task;
+			std::vector<std::unique_ptr<WorkQueue> > queues;
+
+			// Guarded by ThreadPool::mutex
+			int tasksRemaining;
+
+		Job(int numberOfQueues) {
+			tasksRemaining = 0;
+			for (int q = 0; q < numberOfQueues; q++) {
+				queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+			}
+		}
+	};
+
+	int numberOfThreads;
+	std::vector<std::thread> workers;
+
+	// Guards everything below
+	std::mutex mutex;
+	std::condition_variable wakeWorkers;
+	std::condition_variable allTasksDone;
+
+	std::shared_ptr<Job> currentJob;
+	int generation;
+	bool stopping;
+
+	void workerLoop(int self) {
+		int lastGeneration = 0;
+		while (true) {
+			std::shared_ptr<Job> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (!stopping && generation == lastGeneration) {
+					wakeWorkers.wait(lock);
+				}
+				if (stopping) {
+					return;
+				}
+				lastGeneration = generation;
+				job = currentJob;
+			}
+			if (job) {
+				runTasks(*job, self);
+			}
+		}
+	}
+
+	// Takes the next task from our own queue, or steals one from the back of another thread's queue
+	bool takeTask(Job &job, int self, int &taskIndex) {
+		{
+			WorkQueue &own = *job.queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty()) {
+				taskIndex = own.tasks.front();
+				own.tasks.pop_front();
+				return true;
+			}
+		}
+
+		for (int offset = 1; offset < numberOfThreads; offset++) {
+			WorkQueue &victim = *job.queues[(self + offset) % numberOfThreads];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				taskIndex = victim.tasks.back();
+				victim.tasks.pop_back();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void runTasks(Job &job, int self) {
+		int taskIndex;
+		while (takeTask(job, self, taskIndex)) {
+			job.task(taskIndex);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			job.tasksRemaining--;
+			if (job.tasksRemaining == 0) {
+				allTasksDone.notify_all();
+			}
+		}
+	}
+};
+
+
+#endif /* THREADPOOL_H_ */
@@ -8,6 +8,8 @@
 #ifndef TRIANGLE_H_
 #define TRIANGLE_H_
 
+#include <stdint.h>
+
 class Triangle {
 public:
 	DifferentialGeometry point1, point2, point3;
@@ -61,4 +63,25 @@ public:
 
 };
 
+// A triangle stored as the indices of its three vertices in a BezierPatch's listOfDifferentialGeometries
+class IndexedTriangle {
+public:
+	uint32_t index1, index2, index3;
+
+	// How many times adaptive subdivision has split the triangles this one came from
+	uint32_t depth;
+
+	IndexedTriangle() {
+		index1 = index2 = index3 = 0;
+		depth = 0;
+	}
+
+	IndexedTriangle(uint32_t i1, uint32_t i2, uint32_t i3, uint32_t depth = 0) {
+		this->index1 = i1;
+		this->index2 = i2;
+		this->index3 = i3;
+		this->depth = depth;
+	}
+};
+
 #endif /* TRIANGLE_H_ */
@@ -0,0 +1,83 @@
+/*
+ * TriangleQueue.h
+ *
+ *  Created on: Apr 28, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef TRIANGLEQUEUE_H_
+#define TRIANGLEQUEUE_H_
+
+// Adaptive subdivision's queue of triangles still to test: a ring buffer in a TessellationArena that can
+// be taken from at either end (the front for breadth-first subdivision, the back for depth-first).
+//
+// Growing it copies the triangles to a buffer twice the size, leaving the old one in the arena until
+// the enclosing Scope ends, so a queue must not outlive the Scope it was created in
+class TriangleQueue {
+	public:
+
+	TriangleQueue(TessellationArena &arena) : arena(arena) {
+		triangles = NULL;
+		capacity = 0;
+		first = 0;
+		count = 0;
+	}
+
+	bool empty() const {
+		return count == 0;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	void push_back(const IndexedTriangle &triangle) {
+		if (count == capacity) {
+			grow();
+		}
+		triangles[(first + count) & (capacity - 1)] = triangle;
+		count++;
+	}
+
+	const IndexedTriangle &front() const {
+		return triangles[first];
+	}
+
+	const IndexedTriangle &back() const {
+		return triangles[(first + count - 1) & (capacity - 1)];
+	}
+
+	void pop_front() {
+		first = (first + 1) & (capacity - 1);
+		count--;
+	}
+
+	void pop_back() {
+		count--;
+	}
+
+	private:
+		enum { MINIMUM_CAPACITY = 64 };
+
+		TessellationArena &arena;
+
+		// 'capacity' (a power of two) slots, of which 'count' are in use starting at 'first' and wrapping around
+		IndexedTriangle *triangles;
+		size_t capacity;
+		size_t first;
+		size_t count;
+
+	void grow() {
+		size_t newCapacity = (capacity == 0) ? MINIMUM_CAPACITY : 2 * capacity;
+		IndexedTriangle *newTriangles = arena.allocate<IndexedTriangle>(newCapacity);
+		for (size_t i = 0; i < count; i++) {
+			newTriangles[i] = triangles[(first + i) & (capacity - 1)];
+		}
+		triangles = newTriangles;
+		capacity = newCapacity;
+		first = 0;
+	}
+};
+
+
+#endif /* TRIANGLEQUEUE_H_ */
@@ -0,0 +1,170 @@
+/*
+ * VertexArrays.h
+ *
+ *  Created on: Apr 28, 2015
+ *      Author: ryanyu
+ */
+
+#ifndef VERTEXARRAYS_H_
+#define VERTEXARRAYS_H_
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#define VERTEX_ARRAYS_SSE
+#include <xmmintrin.h>
+#endif
+
+// Points (or directions) stored as a structure of arrays: every x, then every y, then every z, each
+// array aligned for SIMD. Loops over one component at a time (bounds, transforms) then read memory
+// contiguously, four points per SSE register, instead of striding over mixed structs.
+class CoordinateArrays {
+	public:
+		typedef std::vector<float, Eigen::aligned_allocator<float> > FloatArray;
+
+		FloatArray x, y, z;
+
+	size_t size() const {
+		return x.size();
+	}
+
+	bool empty() const {
+		return x.empty();
+	}
+
+	void clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+	}
+
+	void reserve(size_t n) {
+		x.reserve(n);
+		y.reserve(n);
+		z.reserve(n);
+	}
+
+	void resize(size_t n) {
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+	}
+
+	void push_back(const Eigen::Vector3f &point) {
+		x.push_back(point.x());
+		y.push_back(point.y());
+		z.push_back(point.z());
+	}
+
+	Eigen::Vector3f get(size_t i) const {
+		return Eigen::Vector3f(x[i], y[i], z[i]);
+	}
+
+	void set(size_t i, const Eigen::Vector3f &point) {
+		x[i] = point.x();
+		y[i] = point.y();
+		z[i] = point.z();
+	}
+
+	//****************************************************
+	// Box around every point (empty if there are none), as one pass of SIMD min/max over the three arrays
+	//***************************************************
+	BoundingBox computeBounds() const {
+		BoundingBox bounds;
+		size_t n = size();
+		size_t i = 0;
+#ifdef VERTEX_ARRAYS_SSE
+		if (n >= 4) {
+			__m128 xMinimum = _mm_load_ps(&x[0]), xMaximum = xMinimum;
+			__m128 yMinimum = _mm_load_ps(&y[0]), yMaximum = yMinimum;
+			__m128 zMinimum = _mm_load_ps(&z[0]), zMaximum = zMinimum;
+			for (i = 4; i + 4 <= n; i += 4) {
+				__m128 xs = _mm_load_ps(&x[i]);
+				__m128 ys = _mm_load_ps(&y[i]);
+				__m128 zs = _mm_load_ps(&z[i]);
+				xMinimum = _mm_min_ps(xMinimum, xs);
+				xMaximum = _mm_max_ps(xMaximum, xs);
+				yMinimum = _mm_min_ps(yMinimum, ys);
+				yMaximum = _mm_max_ps(yMaximum, ys);
+				zMinimum = _mm_min_ps(zMinimum, zs);
+				zMaximum = _mm_max_ps(zMaximum, zs);
+			}
+
+			// Fold the 4 lanes together
+			alignas(16) float lanes[6][4];
+			_mm_store_ps(lanes[0], xMinimum);
+			_mm_store_ps(lanes[1], yMinimum);
+			_mm_store_ps(lanes[2], zMinimum);
+			_mm_store_ps(lanes[3], xMaximum);
+			_mm_store_ps(lanes[4], yMaximum);
+			_mm_store_ps(lanes[5], zMaximum);
+			for (int lane = 0; lane < 4; lane++) {
+				bounds.extend(Eigen::Vector3f(lanes[0][lane], lanes[1][lane], lanes[2][lane]));
+				bounds.extend(Eigen::Vector3f(lanes[3][lane], lanes[4][lane], lanes[5][lane]));
+			}
+		}
+#endif
+		// The last few points (or all of them, without SSE)
+		for (; i < n; i++) {
+			bounds.extend(get(i));
+		}
+		return bounds;
+	}
+};
+
+
+// A tessellation's vertices as a structure of arrays: positions, normals, and (u, v) parameter values.
+// The same vertices as a std::vector<DifferentialGeometry>, laid out for SIMD (see CoordinateArrays)
+class VertexArrays {
+	public:
+		CoordinateArrays positions;
+		CoordinateArrays normals;
+		CoordinateArrays::FloatArray u, v;
+
+	size_t size() const {
+		return positions.size();
+	}
+
+	void clear() {
+		positions.clear();
+		normals.clear();
+		u.clear();
+		v.clear();
+	}
+
+	void reserve(size_t n) {
+		positions.reserve(n);
+		normals.reserve(n);
+		u.reserve(n);
+		v.reserve(n);
+	}
+
+	void push_back(const DifferentialGeometry &vertex) {
+		positions.push_back(vertex.position);
+		normals.push_back(vertex.normal);
+		u.push_back(vertex.uvValues.x());
+		v.push_back(vertex.uvValues.y());
+	}
+
+	// Appends every vertex of 'vertices' (a std::vector or TessellationList of DifferentialGeometry)
+	template <class List>
+	void append(const List &vertices) {
+		reserve(size() + vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) {
+			push_back(vertices[i]);
+		}
+	}
+
+	DifferentialGeometry get(size_t i) const {
+		return DifferentialGeometry(positions.get(i), normals.get(i), Eigen::Vector2f(u[i], v[i]));
+	}
+
+	BoundingBox computeBounds() const {
+		return positions.computeBounds();
+	}
+};
+
+
+#endif /* VERTEXARRAYS_H_ */
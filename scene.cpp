@@ -1,1191 +1,2286 @@
-#include <vector>
-#include <iostream>
-#include <fstream>
-#include <cmath>
-#include <string>
-#include <limits>
-
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <sys/time.h>
-#endif
-
-#ifdef OSX
-#include <GLUT/glut.h>
-#include <OpenGL/glu.h>
-#else
-#include <GL/glut.h>
-#include <GL/glu.h>
-#endif
-
-#include <time.h>
-#include <math.h>
-#include <stdio.h>
-#include <bitset>
-#include <algorithm>
-
-
-#include "Eigen/Geometry"
-
-#include "CurveLocalGeometry.h"
-#include "Camera.h"
-#include "DifferentialGeometry.h"
-#include "Triangle.h"
-#include "BezierPatch.h"
-
-inline float sqr(float x) { return x*x; }
-
-using namespace std;
-
-//****************************************************
-// Some Classes
-//****************************************************
-
-class Viewport;
-
-class Viewport {
-public:
-	int w, h; // width and height
-
-};
-
-
-
-//****************************************************
-// Global Variables
-//****************************************************
-Camera camera;
-Viewport viewport;
-string filename;
-string subdivisionMethod;
-float subdivisionParameter;
-int numberOfBezierPatches;
-std::vector<BezierPatch> listOfBezierPatches;
-
-std::vector<Eigen::Vector3f> objFileVertices;
-std::vector<std::vector<DifferentialGeometry> > objFilePolygonList;
-bool objMode;
-string objFilenameOutput;
-bool WRITE_OBJ;
-
-// ***** Display-related global variables ***** //
-
-// if false, then in flat shading mode
-bool SMOOTH_SHADING;
-
-// if false, then in filled mode
-bool WIREFRAME_MODE;
-
-bool HIDDEN_LINE_MODE;
-
-bool debug;
-
-
-
-//****************************************************
-// Simple init function
-//****************************************************
-void initScene(){
-
-	// Hard code various diffuse and specular constants
-	// NOTE: Probably should change this, I copied it from online...
-
-	SMOOTH_SHADING = true;
-	WIREFRAME_MODE = true;
-	HIDDEN_LINE_MODE = false;
-
-	GLfloat ambientColor[] = {0.5f, 0.5f, 0.5f, 1.0f}; //Color(0.2, 0.2, 0.2)
-	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambientColor);
-
-	//Add directed light
-	GLfloat lightColor1[] = {0.6f, 0.5f, 0.4f, 1.0f}; //Color (0.5, 0.2, 0.2)
-	//Coming from the direction (-1, 0.5, 0.5)
-	GLfloat lightPos1[] = {-10.0f, 5.5f, 8.5f, 0.0f};
-	glLightfv(GL_LIGHT1, GL_DIFFUSE, lightColor1);
-	glLightfv(GL_LIGHT1, GL_POSITION, lightPos1);
-
-	//Add positioned light
-	GLfloat lightColor0[] = {0.6f, 0.55f, 0.55f, 1.0f}; //Color (0.5, 0.5, 0.5)
-	GLfloat lightPos0[] = {4.0f, 0.0f, 8.0f, 1.0f}; //Positioned at (4, 0, 8)
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, lightColor0);
-	glLightfv(GL_LIGHT0, GL_POSITION, lightPos0);
-
-	glEnable(GL_LIGHTING);
-	glEnable(GL_LIGHT0);
-	glEnable(GL_LIGHT1);
-	glEnable(GL_DEPTH_TEST);
-//	glEnable(GL_CULL_FACE);
-
-}
-
-
-//****************************************************
-// reshape viewport if the window is resized
-//****************************************************
-void myReshape(int w, int h) {
-	viewport.w = w;
-	viewport.h = h;
-
-	glViewport (0,0,viewport.w,viewport.h);
-
-	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
-
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-
-	gluPerspective(camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT, aspect_ratio, camera.zNear, camera.zFar);
-
-}
-
-
-
-
-//****************************************************
-// function that does the actual drawing of stuff
-//***************************************************
-void myDisplay() {
-
-	// clear the color buffer
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glMatrixMode(GL_PROJECTION);
-
-	// make sure transformation is "zero'd"
-	glLoadIdentity();
-
-	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
-
-	// set OpenGL viewport
-	glViewport(0, 0, viewport.w, viewport.h);
-
-	gluPerspective(camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT, aspect_ratio, camera.zNear, camera.zFar);
-
-	// set shading of model to smooth or flat, based on our global variable
-	if (SMOOTH_SHADING) {
-		glShadeModel(GL_SMOOTH);
-	} else {
-		glShadeModel(GL_FLAT);
-	}
-
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
-	// Set camera, via the following:
-	// void gluLookAt(GLdouble eyeX, GLdouble eyeY, GLdouble eyeZ, GLdouble centerX, GLdouble centerY,
-	//                GLdouble centerZ, GLdouble upX, GLdouble upY, GLdouble upZ);
-	gluLookAt(camera.position.x(), camera.position.y(), camera.position.z(), camera.lookAt.x(), camera.lookAt.y(),
-			camera.lookAt.z(), camera.up.x(), camera.up.y(), camera.up.z());
-
-	// Handle rotations
-	glRotatef(camera.X_ROTATION_AMOUNT, 1, 0, 0);
-	glRotatef(camera.Y_ROTATION_AMOUNT, 0, 1, 0);
-	glRotatef(camera.Z_ROTATION_AMOUNT, 0, 0, 1);
-
-	// Handle translations
-	glTranslatef(camera.X_TRANSLATION_AMOUNT, camera.Y_TRANSLATION_AMOUNT, camera.Z_TRANSLATION_AMOUNT);
-
-	if (objMode) {
-		for (std::vector<std::vector<DifferentialGeometry> >::size_type j = 0; j < objFilePolygonList.size(); j++) {
-			std::vector<DifferentialGeometry> currentPolygonToDraw = objFilePolygonList[j];
-
-			if (WIREFRAME_MODE) {
-				if (HIDDEN_LINE_MODE) {
-					glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-
-					glDisable(GL_LIGHTING);
-					glClearColor(0.0, 0.0, 0.0, 0.0);
-					// Default the drawing color to white
-					glColor3f(1.0f, 1.0f, 1.0f);
-
-					glBegin(GL_POLYGON);
-
-					for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-						glVertex3f(currentPolygonToDraw[k].position.x(),
-								currentPolygonToDraw[k].position.y(),
-								currentPolygonToDraw[k].position.z());
-					}
-
-					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-					glEnable(GL_POLYGON_OFFSET_FILL);
-					glPolygonOffset(1.0, 1.0);
-					glClearColor(0.0, 0.0, 0.0, 0.0);
-					glColor3f(0.0, 0.0, 0.0);
-
-					glBegin(GL_POLYGON);
-					for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-						glVertex3f(currentPolygonToDraw[k].position.x(),
-								currentPolygonToDraw[k].position.y(),
-								currentPolygonToDraw[k].position.z());
-					}
-					glEnd();
-					glDisable(GL_POLYGON_OFFSET_FILL);
-
-
-				} else {
-					// Draw objects in wireframe mode
-					glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-
-					glDisable(GL_LIGHTING);
-					glClearColor(0.0, 0.0, 0.0, 0.0);
-					// Default the drawing color to white
-					glColor3f(1.0f, 1.0f, 1.0f);
-
-					glBegin(GL_POLYGON);
-
-					for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-						glVertex3f(currentPolygonToDraw[k].position.x(),
-								currentPolygonToDraw[k].position.y(),
-								currentPolygonToDraw[k].position.z());
-					}
-
-					glEnd();
-				}
-
-
-			} else {
-				// Draw objects in filled mode
-				glPolygonMode( GL_FRONT, GL_FILL);
-				glPolygonMode( GL_BACK, GL_FILL);
-				glClearColor(0.0, 0.0, 0.0, 0.0);
-				glEnable(GL_LIGHTING);
-
-				glBegin(GL_POLYGON);
-
-				// TODO: Account for normals in non-wireframe mode
-				for (std::vector<DifferentialGeometry>::size_type k = 0; k < currentPolygonToDraw.size(); k++) {
-					glVertex3f(currentPolygonToDraw[k].position.x(),
-							currentPolygonToDraw[k].position.y(),
-							currentPolygonToDraw[k].position.z());
-				}
-
-
-				glEnd();
-			}
-		}
-
-
-	} else {
-
-		/*
-		Begin drawing all of the triangles
-		PSUEDOCODE:
-
-		for each BezierPatch in the scene's list of Bezier patches:
-			for each Triangle in the current Bezier patch's list of triangles
-				Grab the three vertices of the triangle and render the triangle
-
-		 */
-
-		// Iterate through each of our BezierPatches...
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			BezierPatch currentBezierPatch = listOfBezierPatches[i];
-			for (std::vector<Triangle>::size_type j = 0; j < currentBezierPatch.listOfTriangles.size(); j++) {
-				Triangle currentTriangleToDraw = currentBezierPatch.listOfTriangles[j];
-
-				DifferentialGeometry point1, point2, point3;
-				point1 = currentTriangleToDraw.point1;
-				point2 = currentTriangleToDraw.point2;
-				point3 = currentTriangleToDraw.point3;
-
-				if (WIREFRAME_MODE) {
-					if (HIDDEN_LINE_MODE) {
-						glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-
-						glDisable(GL_LIGHTING);
-						glClearColor(0.0, 0.0, 0.0, 0.0);
-						// Default the drawing color to white
-						glColor3f(1.0f, 1.0f, 1.0f);
-
-						glBegin(GL_POLYGON);
-
-						// Set vertex and normals of all three points of the current triangle
-						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-						glEnd();
-
-						glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-						glEnable(GL_POLYGON_OFFSET_FILL);
-						glPolygonOffset(1.0, 1.0);
-						glClearColor(0.0, 0.0, 0.0, 0.0);
-						glColor3f(0.0, 0.0, 0.0);
-
-						glBegin(GL_POLYGON);
-						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-						glEnd();
-						glDisable(GL_POLYGON_OFFSET_FILL);
-
-					} else {
-						// Draw objects in wireframe mode
-						glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
-
-						glDisable(GL_LIGHTING);
-						glClearColor(0.0, 0.0, 0.0, 0.0);
-						// Default the drawing color to white
-						glColor3f(1.0f, 1.0f, 1.0f);
-
-						glBegin(GL_POLYGON);
-
-						// Set vertex and normals of all three points of the current triangle
-						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-						glEnd();
-					}
-
-
-				} else {
-					// Draw objects in filled mode
-					glPolygonMode( GL_FRONT, GL_FILL);
-					glPolygonMode( GL_BACK, GL_FILL);
-					glClearColor(0.0, 0.0, 0.0, 0.0);
-					glEnable(GL_LIGHTING);
-
-					glBegin(GL_POLYGON);
-
-					// Set vertex and normals of all three points of the current triangle
-					glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
-					glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
-					glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
-					glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
-					glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
-					glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
-
-					glEnd();
-				}
-			}
-		}
-	}
-
-
-	glPopMatrix();
-
-	glFlush();
-	glutSwapBuffers();					// swap buffers (we earlier set double buffer)
-}
-
-
-
-//****************************************************
-// function that assists with regular key presses
-//***************************************************
-void keyPressed( unsigned char key, int x, int y )
-{
-	switch ( key )
-	{
-	// Space bar: exit program
-	case ' ':
-		exit(1);
-
-	case 's':
-		// Toggle between flat and smooth shading, but only if we aren't in wireframe mode
-		if (!WIREFRAME_MODE) {
-			SMOOTH_SHADING = !SMOOTH_SHADING;
-			if (debug) {
-				if (SMOOTH_SHADING) {
-					cout << "Turned smooth shading ON.\n";
-				} else {
-					cout << "Turned smooth shading OFF.\n";
-				}
-			}
-		}
-		break;
-
-	case 'w':
-		// Toggle between wireframe mode and filled mode
-		WIREFRAME_MODE = !WIREFRAME_MODE;
-		if (debug) {
-			if (WIREFRAME_MODE) {
-				cout << "Turned wireframe mode ON.\n";
-			} else {
-				cout << "Turned wireframe mode OFF.\n";
-			}
-		}
-		break;
-
-	case 'h':
-		// Toggle between filled and hidden-line mode
-		HIDDEN_LINE_MODE = !HIDDEN_LINE_MODE;
-		if (debug) {
-			if (HIDDEN_LINE_MODE) {
-				cout << "Turned hidden line mode ON.\n";
-			} else {
-				cout << "Turned hidden line mode OFF.\n";
-			}
-		}
-		break;
-
-	case '+':
-		// Zoom in
-		camera.zoomIn();
-		break;
-
-	case '-':
-		// Zoom out
-		camera.zoomOut();
-		break;
-
-	case 'r':
-		// Reset everything
-		SMOOTH_SHADING = true;
-		WIREFRAME_MODE = true;
-		camera.resetCamera();
-		break;
-
-	case '.':
-		// Rotate Z clockwise, looking from above
-		camera.rotateZDown();
-		break;
-
-	case ',':
-		// Rotate Z counterclockwise, looking from above
-		camera.rotateZUp();
-		break;
-	}
-
-}
-
-
-//****************************************************
-// function that assists with special (i.e. arrow key) key presses
-//***************************************************
-void handleSpecialKeypress(int key, int x, int y) {
-	int mod_key = glutGetModifiers();
-	switch (key) {
-		case GLUT_KEY_LEFT:
-			if (mod_key == GLUT_ACTIVE_SHIFT) {
-				camera.translateLeft();
-			} else {
-				camera.rotateDown();
-			}
-			break;
-
-		case GLUT_KEY_RIGHT:
-			if (mod_key == GLUT_ACTIVE_SHIFT) {
-				camera.translateRight();
-			} else {
-				camera.rotateUp();
-			}
-			break;
-
-		case GLUT_KEY_UP:
-			if (mod_key == GLUT_ACTIVE_SHIFT) {
-				camera.translateUp();
-			} else if (mod_key == GLUT_ACTIVE_ALT) {
-				camera.translateZUp();
-			} else {
-				camera.rotateLeft();
-			}
-			break;
-
-		case GLUT_KEY_DOWN:
-			if (mod_key == GLUT_ACTIVE_SHIFT) {
-				camera.translateDown();
-			} else if (mod_key == GLUT_ACTIVE_ALT) {
-				camera.translateZDown();
-			} else {
-				camera.rotateRight();
-			}
-			break;
-		case GLUT_KEY_PAGE_UP:
-			camera.translateZUp();
-			break;
-		case GLUT_KEY_PAGE_DOWN:
-			camera.translateZDown();
-			break;
-
-	}
-	glutPostRedisplay();
-
-}
-
-
-//****************************************************
-// function that prints all of our command line option variables
-//***************************************************
-void printCommandLineOptionVariables( )
-{
-	if (debug)
-	{
-		cout << "\nBezier file: " << filename << "\n";
-		cout << "Subdivision Parameter: " << subdivisionParameter << "\n";
-		cout << "Subdivision Method: " << subdivisionMethod << "\n\n";
-
-		cout << "We currently have " << listOfBezierPatches.size() << " Bezier patches.\n\n";
-		// Iterate through Bezier Patches
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "  Bezier patch " << (i + 1) << ":\n\n";
-			std::vector<std::vector <Eigen::Vector3f> > curves = listOfBezierPatches[i].listOfCurves;
-
-			// Iterate through curves in each Bezier patch
-			for (std::vector<std::vector <Eigen::Vector3f> >::size_type j = 0; j < curves.size(); j++) {
-				std::vector<Eigen::Vector3f> listOfPointsForCurrentCurve = curves[j];
-
-				cout << "    Curve " << (j + 1) << ":\n";
-
-				// Iterate through points in current curve and print them
-				for (std::vector<Eigen::Vector3f>::size_type k = 0; k < listOfPointsForCurrentCurve.size(); k++) {
-					printf("    (%f, %f, %f)\n", listOfPointsForCurrentCurve[k].x(), listOfPointsForCurrentCurve[k].y(), listOfPointsForCurrentCurve[k].z());
-				}
-				cout << "\n\n";
-			}
-		}
-
-		cout << "Display options:\n";
-		if (SMOOTH_SHADING) {
-			cout << "  Smooth shading is ON.\n";
-		} else {
-			cout << "  Flat shading is ON. (i.e. smooth shading is OFF)\n";
-		}
-
-		if (WIREFRAME_MODE) {
-			cout << "  Wireframe mode is ON.\n";
-		} else {
-			cout << "  Filled mode is ON. (i.e. Wireframe mode is OFF)\n";
-		}
-
-	}
-}
-
-
-//****************************************************
-// function that prints all triangles in every Bezier Patch
-//***************************************************
-void printTrianglesInBezierPatches() {
-	if (debug) {
-		// Iterate through Bezier Patches
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "  Bezier patch " << (i + 1) << ":\n\n";
-
-			// Iterate through Triangles in the current Bezier patch
-			for (std::vector<Triangle>::size_type j = 0; j < listOfBezierPatches[i].listOfTriangles.size(); j++) {
-				Triangle currentTriangle = listOfBezierPatches[i].listOfTriangles[j];
-				cout << "    Triangle " << (j + 1) << ":\n";
-				cout << "      " << currentTriangle.printTriangleInformation();
-			}
-
-		}
-	}
-}
-
-
-//****************************************************
-// function that prints all differential geometries in every Bezier Patch
-//***************************************************
-void printDifferentialGeometriesInBezierPatches() {
-	if (debug) {
-		// Iterate through Bezier Patches
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "  Bezier patch " << (i + 1) << ":\n\n";
-
-			// Iterate through Triangles in the current Bezier patch
-			for (std::vector<DifferentialGeometry>::size_type j = 0; j < listOfBezierPatches[i].listOfDifferentialGeometries.size(); j++) {
-				DifferentialGeometry currentDifferentialGeometry = listOfBezierPatches[i].listOfDifferentialGeometries[j];
-				cout << "    DifferentialGeometry " << (j + 1) << ":\n";
-				Eigen::Vector3f currentPosition = currentDifferentialGeometry.position;
-				cout << "      (" << currentPosition.x() << " , " << currentPosition.y() << " , " << currentPosition.z() << ")\n";
-			}
-
-		}
-	}
-}
-
-//****************************************************
-// function that prints the number of triangles and differential geometries for each Bezier patch
-//***************************************************
-void printStatistics() {
-	if (debug) {
-		cout << "\n  Statistics:\n\n";
-		// Iterate through Bezier Patches
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			cout << "    Bezier patch " << (i + 1) << " has " << listOfBezierPatches[i].listOfDifferentialGeometries.size()
-					<< " differential geometries and " << listOfBezierPatches[i].listOfTriangles.size() << " triangles.\n";
-		}
-	}
-}
-
-
-
-//****************************************************
-// function that prints the number of triangles and differential geometries for each Bezier patch
-//***************************************************
-void printCameraInformation() {
-	if (debug) {
-		cout << "\n  Camera information:\n\n";
-		cout << "Position:\n" << camera.position << "\n\n";
-		cout << "Up:\n" << camera.up << "\n\n";
-		cout << "Look At:\n" << camera.lookAt << "\n\n";
-		cout << "Z-Near: " << camera.zNear << "; Z-Far: " << camera.zFar << "\n";
-		cout << "Field of view: " << camera.FIELD_OF_VIEW << "\n";
-		cout << "Zoom amount: " << camera.ZOOM_AMOUNT << "\n";
-	}
-}
-
-
-//****************************************************
-// Method that populates each BezierPatch's list of DifferentialGeometries
-// and list of Triangles, based on what kind of subdivision (i.e. adaptive or uniform)
-// we are performing
-//***************************************************
-void perform_subdivision(bool adaptive_subdivision) {
-	// Iterate through each of the Bezier patches...
-	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-		if (adaptive_subdivision) {
-			listOfBezierPatches[i].performAdaptiveSubdivision(subdivisionParameter);
-		} else {
-			listOfBezierPatches[i].performUniformSubdivision(subdivisionParameter);
-
-		}
-	}
-
-}
-
-
-
-
-//****************************************************
-// Writes an .obj file that represents this BezierPatch
-//***************************************************
-void generateObjFile(std::string filename) {
-	std::ofstream myfile;
-	myfile.open(filename);
-
-	std::vector<Triangle> aggregateTriangleList;
-	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-		for (std::vector<Triangle>::size_type j = 0; j < listOfBezierPatches[i].listOfTriangles.size(); j++) {
-			aggregateTriangleList.push_back(listOfBezierPatches[i].listOfTriangles[j]);
-		}
-	}
-
-	// Generate all vertex lines in file
-	for (std::vector<Triangle>::size_type i = 0; i < aggregateTriangleList.size(); i++) {
-		DifferentialGeometry point1 = aggregateTriangleList[i].point1;
-		DifferentialGeometry point2 = aggregateTriangleList[i].point2;
-		DifferentialGeometry point3 = aggregateTriangleList[i].point3;
-
-		myfile << "v " << point1.position.x() << " " << point1.position.y() << " " << point1.position.z() << "\n";
-		myfile << "v " << point2.position.x() << " " << point2.position.y() << " " << point2.position.z() << "\n";
-		myfile << "v " << point3.position.x() << " " << point3.position.y() << " " << point3.position.z() << "\n";
-	}
-
-
-	for (std::vector<Triangle>::size_type i = 0; i < aggregateTriangleList.size(); i++) {
-		myfile << "f " << (3 * i) + 1 << " " << (3 * i) + 2 << " " << (3 * i) + 3 << "\n";
-	}
-}
-
-
-
-//****************************************************
-// function that parses an input .bez file and initializes
-// a list of Bezier patches
-//
-// psuedocode for parsing .bez file
-
-/*
-
-BezierPatch currentBezierPatch
-for each collection of 4 rows that correspond to one Bezier patch:
-    for i between 1 and 4 (ie. each of the 4 rows for the current patch):
-        Vect3 point1 = first row
-        Vect3 point2 = second row
-        Vect3 point3 = third row
-        Vect3 point4 = fourth row
-        vector<Vect3> curveI;
-        curveI.push_back(point1);
-        curveI.push_back(point2);
-        curveI.push_back(point3);
-        curveI.push_back(point4);
-        currentBezierPatch.addCurve(curveI);
-    all_bezier_patches.addPatch(currentBezierPatch);
-
-*/
-//****************************************************
-void parseBezierFile(string filename) {
-
-	ifstream file(filename);
-	// current line
-	string str;
-
-	// current word that we're parsing on a line
-	string currentWord;
-
-	// index of the line
-	int i = 0;
-
-	// index of a word on each specific line
-	int j = 0;
-
-	// coordinates for each set of four points (i.e. one line)
-	float p1x, p1y, p1z, p2x, p2y, p2z, p3x, p3y, p3z, p4x, p4y, p4z;
-
-	// number of lines that have already been processed for the current Bezier patch
-	int curvesParsedForCurrentPatch = 0;
-
-	BezierPatch currentBezierPatch;
-
-	bool readyForNextPatch = false;
-
-	while (getline(file, str)) {
-		// If we encounter a new line, then we know that the next 4 consecutive lines represent
-		// 4 curves that will make up a Bezier patch, so we reset our current Bezier patch
-		if (str.length() == 0) {
-			curvesParsedForCurrentPatch = 0;
-			currentBezierPatch = BezierPatch();
-			i++;
-			continue;
-		}
-
-		if (readyForNextPatch) {
-			readyForNextPatch = false;
-			curvesParsedForCurrentPatch = 0;
-			currentBezierPatch = BezierPatch();
-		}
-
-		j = 0;
-		if (i == 0) {
-			numberOfBezierPatches = stoi(str);
-			i++;
-			continue;
-		}
-
-		istringstream iss(str);
-		// Iterate through words on a single line...
-		while (iss >> currentWord) {
-			if (j == 0) { p1x = stof(currentWord); }
-			if (j == 1) { p1y = stof(currentWord); }
-			if (j == 2) { p1z = stof(currentWord); }
-			if (j == 3) { p2x = stof(currentWord); }
-			if (j == 4) { p2y = stof(currentWord); }
-			if (j == 5) { p2z = stof(currentWord); }
-			if (j == 6) { p3x = stof(currentWord); }
-			if (j == 7) { p3y = stof(currentWord); }
-			if (j == 8) { p3z = stof(currentWord); }
-			if (j == 9) { p4x = stof(currentWord); }
-			if (j == 10) { p4y = stof(currentWord); }
-			if (j == 11) { p4z = stof(currentWord); }
-			j++;
-		}
-
-		Eigen::Vector3f point1(p1x, p1y, p1z);
-		Eigen::Vector3f point2(p2x, p2y, p2z);
-		Eigen::Vector3f point3(p3x, p3y, p3z);
-		Eigen::Vector3f point4(p4x, p4y, p4z);
-
-		// 1 of the 4 curves for the currentBezierPatch
-		vector<Eigen::Vector3f> currentCurve;
-		currentCurve.push_back(point1);
-		currentCurve.push_back(point2);
-		currentCurve.push_back(point3);
-		currentCurve.push_back(point4);
-
-		currentBezierPatch.addCurve(currentCurve);
-		curvesParsedForCurrentPatch++;
-
-		// We have parsed all four curves for our current patch
-		if (curvesParsedForCurrentPatch == 4) {
-
-			listOfBezierPatches.push_back(currentBezierPatch);
-			readyForNextPatch = true;
-		}
-
-		i++;
-	}
-
-	// Perform subdivision of BezierPatches, based on whether we want to adaptively or uniformly subdivide
-	if (subdivisionMethod == "ADAPTIVE") {
-		perform_subdivision(true);
-	} else if (subdivisionMethod == "UNIFORM") {
-		perform_subdivision(false);
-	} else {
-		cout << "Invalid subdivision method, terminating program.";
-		exit(1);
-	}
-
-	// We want to write our Bezier patches to an .obj file
-	if (WRITE_OBJ) {
-		generateObjFile(objFilenameOutput);
-	}
-
-}
-
-//****************************************************
-// Parsing .OBJ file specified in scene file
-//****************************************************
-void parseObjFile(string filename) {
-
-	string str;
-	ifstream file(filename);
-
-	// The identifier that we're currently parsing
-	string currentlyParsing;
-
-	// current word that we're parsing on a line
-	string currentWord;
-
-	bool validLine = true;
-
-	while (getline(file, str)) {
-		// str represents the current line of the file
-
-		validLine = true;
-		int i = 0;
-
-		std::vector<DifferentialGeometry> currentPolygonPoints;
-
-		istringstream iss(str);
-		while (iss >> currentWord) {
-
-			// ********** Figure out what the first word of each line is ********** //
-			// We currently support:
-			// (1) v ... (vertex definitions)
-			// (2) f ... (face definitions)
-
-			if ((i == 0) && (currentWord == "v")) {
-				currentlyParsing = currentWord;
-
-			} else if ((i == 0) && (currentWord == "f")) {
-				currentlyParsing = currentWord;
-
-			} else if (i == 0) {
-				currentlyParsing = currentWord;
-				validLine = false;
-			}
-
-			// If the current line is not valid, then just keep skipping every word in the line
-			if (!validLine) {
-				i++;
-				continue;
-			}
-
-			// ********** After we've figured out the first word in each line, parse the rest of the line ********** //
-			// If we've hit here, then we're NOT on the first word of the line anymore
-
-			if (currentlyParsing == "v") {
-				float xCoor, yCoor, zCoor;
-				if (i == 0) { }
-				else if (i == 1) { xCoor = stof(currentWord); }
-				else if (i == 2) { yCoor = stof(currentWord); }
-				else if (i == 3) { zCoor = stof(currentWord); }
-				else if (i > 3) {
-					cerr << "Extra parameters for " << currentlyParsing << ". Ignoring them.\n";
-				}
-				if (i == 3) {
-					objFileVertices.push_back(Eigen::Vector3f(xCoor, yCoor, zCoor));
-				}
-
-			} else if (currentlyParsing == "f") {
-
-
-				if (i == 0) {
-					i++;
-					continue;
-				}
-				int currentIndexOfVertex = stoi(currentWord) - 1;
-
-				if (currentIndexOfVertex < objFileVertices.size()) {
-					currentPolygonPoints.push_back(DifferentialGeometry(objFileVertices[currentIndexOfVertex]));
-				}
-
-			}
-
-			i++;
-		}
-
-		// Finished parsing current line
-		if (currentlyParsing == "f") {
-			objFilePolygonList.push_back(currentPolygonPoints);
-		}
-	}
-}
-//****************************************************
-// function that determines if full string ends with ending
-//***************************************************
-
-static bool hasEnding (std::string const &fullString, std::string const &ending) {
-    if (fullString.length() >= ending.length()) {
-        return (0 == fullString.compare (fullString.length() - ending.length(), ending.length(), ending));
-    } else {
-        return false;
-    }
-}
-
-//****************************************************
-// function that parses command line options,
-// given number of command line arguments (argc)
-// and the argument array (argv)
-// Format:
-// % as3 inputfile.bez 0.1 -a
-//***************************************************
-void parseCommandLineOptions(int argc, char *argv[])
-{
-	subdivisionMethod = "UNIFORM";
-	string flag;
-
-	int i = 1;
-	while (i <= argc - 1) {
-		flag = argv[i];
-
-		if (i == 1) {
-			filename = flag;
-			if (hasEnding(flag, ".bez")) {
-				objMode = false;
-			} else if (hasEnding(flag, ".obj")) {
-				objMode = true;
-			} else {
-				std::cout << "Unrecognized input file format.";
-				exit(1);
-			}
-		} else if (i == 2) {
-			subdivisionParameter = stof(flag);
-		} else if (flag == "-o") {
-			if ((i + 1) > (argc - 1))
-			{
-				std::cout << "Invalid number of parameters for -o.";
-				exit(1);
-			}
-			if (!objMode) {
-				WRITE_OBJ = true;
-				objFilenameOutput = argv[i+1];
-			} else {
-				std::cout << "Error: cannot write to .obj file if in .obj mode.";
-				exit(1);
-			}
-			i += 1;
-		}
-
-		if (i == 3 && flag == "-a") {
-			subdivisionMethod = "ADAPTIVE";
-		}
-
-		i++;
-	}
-
-	if (hasEnding(filename, ".bez")) {
-		parseBezierFile(filename);
-	} else if (hasEnding(filename, ".obj")) {
-		parseObjFile(filename);
-	}
-}
-
-
-
-//****************************************************
-// Initializes the camera's vector instance variables,
-// based on each BezierPatch's DifferentialGeometry objects
-//
-// NOTE: This method MUST be called AFTER all Bezier objects and their
-//       DifferentialGeometry / Triangle lists are finished being initialized
-//****************************************************
-void initializeCamera() {
-	// First, we iterate through all of the objects in our scene and we determine the minimum and maximum x, y, z values over all objects
-
-	float xMin, xMax, yMin, yMax, zMin, zMax;
-
-	xMin = yMin = zMin = numeric_limits<int>::max();
-	xMax = yMax = zMax = numeric_limits<int>::min();
-
-
-	if (objMode) {
-		for (std::vector<std::vector<DifferentialGeometry> >::size_type i = 0; i < objFilePolygonList.size(); i++) {
-			std::vector<DifferentialGeometry> currentPolygon = objFilePolygonList[i];
-
-			for (std::vector<DifferentialGeometry>::size_type j = 0; j < currentPolygon.size(); j++) {
-				Eigen::Vector3f currentDifferentialGeometryPosition = currentPolygon[j].position;
-
-				// Update min's, if applicable
-				if (currentDifferentialGeometryPosition.x() < xMin) {
-					xMin = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() < yMin) {
-					yMin = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() < zMin) {
-					zMin = currentDifferentialGeometryPosition.z();
-				}
-
-				// Update max's, if applicable
-				if (currentDifferentialGeometryPosition.x() > xMax) {
-					xMax = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() > yMax) {
-					yMax = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() > zMax) {
-					zMax = currentDifferentialGeometryPosition.z();
-				}
-			}
-		}
-
-	} else {
-
-		// Iterate through all BezierPatches...
-		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
-			BezierPatch currentBezierPatch = listOfBezierPatches[i];
-
-			// Iterate through each BezierPatch's DifferentialGeometries...
-			for (std::vector<DifferentialGeometry>::size_type j = 0; j < currentBezierPatch.listOfDifferentialGeometries.size(); j++) {
-				Eigen::Vector3f currentDifferentialGeometryPosition = currentBezierPatch.listOfDifferentialGeometries[j].position;
-
-				// Update min's, if applicable
-				if (currentDifferentialGeometryPosition.x() < xMin) {
-					xMin = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() < yMin) {
-					yMin = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() < zMin) {
-					zMin = currentDifferentialGeometryPosition.z();
-				}
-
-				// Update max's, if applicable
-				if (currentDifferentialGeometryPosition.x() > xMax) {
-					xMax = currentDifferentialGeometryPosition.x();
-				}
-				if (currentDifferentialGeometryPosition.y() > yMax) {
-					yMax = currentDifferentialGeometryPosition.y();
-				}
-				if (currentDifferentialGeometryPosition.z() > zMax) {
-					zMax = currentDifferentialGeometryPosition.z();
-				}
-
-			}
-		}
-	}
-
-	// At this point, xMin, xMax, yMin, yMax, zMin, zMax are initialized, and form a box that has dimensions
-	// (xMax - xMin)  x  (yMax - yMin)  x  (zMax - zMin)
-	float xLength = xMax - xMin;
-	float yLength = yMax - yMin;
-	float zLength = zMax - zMin;
-	float largestLength = fmax(zLength, fmax(xLength, yLength));
-
-	// First, we find the CENTER of our x/y/z min/max values, and this becomes our camera's lookAt vector
-	Eigen::Vector3f center((xMin + xMax) / 2.0f, (yMin + yMax) / 2.0f, (zMin + zMax) / 2.0f);
-	camera.lookAt = center;
-
-	// Set the camera's position to (x, y) = (0, 0). The z-coordinate is the length of the largest coordinate
-	// between xLength, yLength, zLength as defined above, so that the object will always be visible in the scope of the camera's lens
-	camera.position = Eigen::Vector3f(0.0, 0.0, 2.0f * largestLength);
-
-	// Hardcode camera up vector to (0, 1, 0)
-	camera.up = Eigen::Vector3f(0, 1.0f, 0);
-
-	camera.zNear = 1.0f;
-
-	camera.zFar = camera.zNear + (10.0f * largestLength);
-}
-
-
-
-
-//****************************************************
-// psuedocode for... everything
-//****************************************************
-
-/*
-
-- Parse command line arguments to get subdivision parameter and subdivision method (adaptive vs. uniform)
-
-- Use parsed command line arguments to initialize a list of all Bezier patches (with psuedocode above)
-
-- Iterate through list of patches and subdivide all of the patches in the list, either adapatively or uniformly
-
-  - for uniform subdivision:
-    - take given u | v step size, initialize a list of LocalGeometry objects, starting from (u, v) = (0, 0) and moving
-      up by u = v = stepsize each time. NOTE: this list of LocalGeometry objects is specific for the current patch.
-      That is, the list of LocalGeometry objects will be given by currentPatch.local_geo_list
-    - take list of LocalGeometry objects and generate a list of triangles with it. NOTE: this list of triangles is specific
-      for the current patch. That is, it is given by currentPatch.triangle_list
-
-  - for adaptive subdivision:
-    - split based on lecture slides
-      (http://www.cs.berkeley.edu/~job/Classes/CS184/Spring-2015-Slides/14-Surfaces.pdf)
-
-- At this point, each of the patches (ie. surfaces) has its own list of LocalGeometry objects and its own list of triangles
-
-- Create an overarching list of LocalGeometry objects and an overarching list of Triangle objects, and aggregate
-  all LocalGeometry and Triangle objects, respectively, into these two overarching lists
-
-- Define myDisplay():
-  - Set the gluLookAt, and other OpenGL variables (?)
-  - for each BezierPatch in the Scene's BezierPatch list:
-    - for each Triangle in the current BezierPatch's triangle list (ie. currentPatch.triangle_list):
-      - set OpenGL Vertex3f/Normal3f and other things to draw the current triangle
-      - NOTE: need to change this slightly when wireframe mode/other modes are active/non-active
-
-- Call glutDisplayFunc(myDisplay)
-
- */
-
-
-//****************************************************
-// the usual stuff, nothing exciting here
-//****************************************************
-int main(int argc, char *argv[]) {
-
-	// Turns debug mode ON or OFF
-	debug = true;
-	WRITE_OBJ = false;
-
-	// This initializes glut
-	glutInit(&argc, argv);
-
-	// Parse command line options
-	parseCommandLineOptions(argc, argv);
-	printCommandLineOptionVariables();
-
-	// At this point, all subdivision of Bezier Patches has been completed
-
-	printStatistics();
-
-//	printDifferentialGeometriesInBezierPatches();
-//	printTrianglesInBezierPatches();
-
-	// Initialize position, lookAt, and up vectors of camera so that we may feed them into OpenGL rendering system later
-	initializeCamera();
-
-	//This tells glut to use a double-buffered window with red, green, and blue channels
-	glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGB);
-
-	// Initalize theviewport size
-	viewport.w = 1000;
-	viewport.h = 1000;
-
-	printCameraInformation();
-
-	//The size and position of the window
-	glutInitWindowSize(viewport.w, viewport.h);
-	glutInitWindowPosition(0,0);
-	glutCreateWindow(argv[0]);
-
-	initScene();							// quick function to set up scene
-
-	glutDisplayFunc(myDisplay);				// function to run when its time to draw something
-	glutReshapeFunc(myReshape);				// function to run when the window gets resized
-	glutIdleFunc(myDisplay);
-
-	// Handles key presses
-	glutKeyboardFunc( keyPressed );
-	glutSpecialFunc( handleSpecialKeypress );
-
-	glutMainLoop();							// infinite loop that will keep drawing and resizing
-	// and whatever else
-
-	return 0;
-}
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <string>
+#include <limits>
+#include <chrono>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#ifdef OSX
+#include <GLUT/glut.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/glut.h>
+#include <GL/glu.h>
+#endif
+
+#include <time.h>
+#include <math.h>
+#include <stdio.h>
+#include <bitset>
+#include <algorithm>
+
+
+#include "Eigen/Geometry"
+
+#include "CurveLocalGeometry.h"
+#include "Camera.h"
+#include "DifferentialGeometry.h"
+#include "Triangle.h"
+#include "SamplePacket.h"
+#include "EdgeMidpointCache.h"
+#include "BoundingBox.h"
+#include "VertexArrays.h"
+#include "TessellationArena.h"
+#include "TessellationList.h"
+#include "TriangleQueue.h"
+#include "BezierSurface.h"
+#include "BezierPatch.h"
+#include "ThreadPool.h"
+#include "PatchIntersector.h"
+#include "PatchBVH.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "TextScanner.h"
+#include "ObjMesh.h"
+#include "ObjWriter.h"
+#include "MeshBuffer.h"
+#include "OffscreenRenderer.h"
+#include "SoftwareRasterizer.h"
+#include "AllocationCounter.h"
+#include "Profiler.h"
+#include "BenchmarkSuite.h"
+
+inline float sqr(float x) { return x*x; }
+
+using namespace std;
+
+//****************************************************
+// Some Classes
+//****************************************************
+
+class Viewport;
+
+class Viewport {
+public:
+	int w, h; // width and height
+
+};
+
+
+
+//****************************************************
+// Global Variables
+//****************************************************
+Camera camera;
+Viewport viewport;
+string filename;
+string subdivisionMethod;
+string evaluationMethod;
+float subdivisionParameter;
+int numberOfBezierPatches;
+std::vector<BezierPatch> listOfBezierPatches;
+
+// With uniform subdivision, every patch's vertices and triangle indices, in one slice per patch (see attachPatchesToSceneBuffers)
+std::vector<DifferentialGeometry> sceneVertices;
+std::vector<uint32_t> sceneTriangleIndices;
+
+// The patches' bounding volume hierarchy, and the patches it found in view for the frame being drawn
+PatchBVH patchBVH;
+std::vector<int> visiblePatches;
+
+// if false, draw every patch instead of only those whose bounding boxes are in view
+bool FRUSTUM_CULLING;
+
+ObjMesh objMesh;
+bool objMode;
+string objFilenameOutput;
+bool WRITE_OBJ;
+
+// if not empty, the binary file that tessellations are saved to and loaded from (see MeshCache)
+string meshCacheFilename;
+
+// ***** Display-related global variables ***** //
+
+// if false, then in flat shading mode
+bool SMOOTH_SHADING;
+
+// if false, then in filled mode
+bool WIREFRAME_MODE;
+
+bool HIDDEN_LINE_MODE;
+
+bool debug;
+
+// if true, run the surface evaluation micro-benchmark instead of opening a window
+bool BENCHMARK_MODE;
+
+// Adaptive subdivision options: depth-first traversal, and the maximum number of splits (0 = unlimited)
+bool DEPTH_FIRST_SUBDIVISION;
+int maxSubdivisionDepth;
+
+// if true, adaptive subdivision's error is in pixels on screen, and patches re-tessellate as the view changes
+bool SCREEN_SPACE_SUBDIVISION;
+
+// Number of threads used for tessellation (1 = serial; 0 on the command line = one per core)
+int numberOfThreads;
+ThreadPool *threadPool;
+
+// Bumped every time the patches are (re)tessellated, so that meshBuffer knows when to re-upload them
+long tessellationGeneration;
+MeshBuffer meshBuffer;
+
+// if true, draw the patches one glBegin/glEnd per triangle instead of from meshBuffer
+bool IMMEDIATE_MODE;
+
+// if true, render headlessFrames frames of each display mode offscreen, save a snapshot of each
+// as <headlessSnapshotPrefix>_<mode>.ppm, and report frame times instead of opening a window
+bool HEADLESS_MODE;
+int headlessFrames;
+string headlessSnapshotPrefix;
+
+// if true, cast a ray through every pixel at the patches' surfaces, report rays per second,
+// and save the image as <rayCastSnapshotPrefix>_raycast.ppm instead of opening a window
+bool RAY_CAST_MODE;
+string rayCastSnapshotPrefix;
+
+// if true, draw with softwareRasterizer on the CPU instead of through OpenGL
+bool SOFTWARE_RENDERING;
+SoftwareRasterizer softwareRasterizer;
+
+// Per-stage timings and counters (see printProfile)
+Profiler profiler;
+
+// if true, count allocations too, and print the profile (and save it as JSON to profileFilename) at exit
+bool PROFILE_MODE;
+string profileFilename;
+
+// The lights, shared by OpenGL (in initScene) and softwareRasterizer
+GLfloat ambientColor[] = {0.5f, 0.5f, 0.5f, 1.0f}; //Color(0.2, 0.2, 0.2)
+
+//Add directed light
+GLfloat lightColor1[] = {0.6f, 0.5f, 0.4f, 1.0f}; //Color (0.5, 0.2, 0.2)
+//Coming from the direction (-1, 0.5, 0.5)
+GLfloat lightPos1[] = {-10.0f, 5.5f, 8.5f, 0.0f};
+
+//Add positioned light
+GLfloat lightColor0[] = {0.6f, 0.55f, 0.55f, 1.0f}; //Color (0.5, 0.5, 0.5)
+GLfloat lightPos0[] = {4.0f, 0.0f, 8.0f, 1.0f}; //Positioned at (4, 0, 8)
+
+
+
+//****************************************************
+// Returns the scene's thread pool, creating it on first use
+//***************************************************
+ThreadPool &getThreadPool() {
+	if (threadPool == NULL) {
+		threadPool = new ThreadPool(numberOfThreads);
+	}
+	return *threadPool;
+}
+
+
+//****************************************************
+// Sets the display modes the program starts with
+//****************************************************
+void initDisplayModes() {
+	SMOOTH_SHADING = true;
+	WIREFRAME_MODE = true;
+	HIDDEN_LINE_MODE = false;
+}
+
+
+//****************************************************
+// Simple init function
+//****************************************************
+void initScene(){
+
+	// Hard code various diffuse and specular constants
+	// NOTE: Probably should change this, I copied it from online...
+
+	initDisplayModes();
+
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambientColor);
+
+	glLightfv(GL_LIGHT1, GL_DIFFUSE, lightColor1);
+	glLightfv(GL_LIGHT1, GL_POSITION, lightPos1);
+
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, lightColor0);
+	glLightfv(GL_LIGHT0, GL_POSITION, lightPos0);
+
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_LIGHT1);
+	glEnable(GL_DEPTH_TEST);
+//	glEnable(GL_CULL_FACE);
+
+}
+
+
+//****************************************************
+// reshape viewport if the window is resized
+//****************************************************
+void myReshape(int w, int h) {
+	viewport.w = w;
+	viewport.h = h;
+
+	glViewport (0,0,viewport.w,viewport.h);
+
+	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+
+	gluPerspective(camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT, aspect_ratio, camera.zNear, camera.zFar);
+
+}
+
+
+
+
+//****************************************************
+// Sends the vertices of objMesh's p-th polygon to OpenGL, along with the file's normals if 'withNormals'
+// (between glBegin and glEnd)
+//****************************************************
+void drawObjPolygon(int p, bool withNormals) {
+	for (uint32_t k = objMesh.polygonOffsets[p]; k < objMesh.polygonOffsets[p + 1]; k++) {
+		if (withNormals && objMesh.normalIndices[k] != ObjMesh::NO_INDEX) {
+			Eigen::Vector3f normal = objMesh.normals.get(objMesh.normalIndices[k]);
+			glNormal3f(normal.x(), normal.y(), normal.z());
+		}
+		Eigen::Vector3f position = objMesh.vertices.get(objMesh.positionIndices[k]);
+		glVertex3f(position.x(), position.y(), position.z());
+	}
+}
+
+
+//****************************************************
+// With screen-space subdivision, re-tessellates the patches that the current view shows at a noticeably
+// different size (by more than a factor of sqrt(2)) than the view they were last tessellated for, and
+// the patches that came into or went out of view
+//***************************************************
+void updateScreenSpaceTessellation() {
+	if (!SCREEN_SPACE_SUBDIVISION || objMode) {
+		return;
+	}
+
+	// One pixel at depth 1 spans 2 * tan(fov / 2) / height world units
+	Eigen::Matrix4f modelview = camera.getModelviewMatrix();
+	Eigen::Matrix4f projection = camera.getProjectionMatrix((float) viewport.w / viewport.h);
+	float fieldOfView = camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT * M_PI / 180.0f;
+	float worldErrorPerPixel = 2.0f * tan(fieldOfView / 2.0f) / viewport.h;
+	const float tolerance = sqrt(2.0f);
+
+	std::vector<int> patchesToUpdate;
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		if (listOfBezierPatches[i].needsScreenSpaceRetessellation(modelview, projection, worldErrorPerPixel, camera.zNear, tolerance)) {
+			patchesToUpdate.push_back(i);
+		}
+	}
+	if (patchesToUpdate.empty()) {
+		return;
+	}
+
+	Profiler::ScopedTimer timer(profiler, Profiler::SCREEN_SPACE_TESSELLATION);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	getThreadPool().parallelFor(patchesToUpdate.size(), [&](int k) {
+		BezierPatch &patch = listOfBezierPatches[patchesToUpdate[k]];
+		patch.setScreenSpaceError(modelview, projection, worldErrorPerPixel, camera.zNear);
+		patch.retessellateAdaptive(subdivisionParameter);
+	});
+	tessellationGeneration++;
+
+	if (debug) {
+		long numberOfTriangles = 0;
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			numberOfTriangles += listOfBezierPatches[i].getNumberOfTriangles();
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		cout << "Re-tessellated " << patchesToUpdate.size() << " of " << listOfBezierPatches.size() << " patches for the view in "
+				<< elapsed.count() << " ms (" << numberOfTriangles << " triangles).\n";
+	}
+}
+
+
+//****************************************************
+// Fills visiblePatches with the patches the current view may see, in increasing order
+//***************************************************
+void findVisiblePatches() {
+	if (!FRUSTUM_CULLING) {
+		visiblePatches.resize(listOfBezierPatches.size());
+		for (std::vector<int>::size_type i = 0; i < visiblePatches.size(); i++) {
+			visiblePatches[i] = i;
+		}
+		return;
+	}
+
+	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
+	patchBVH.findVisiblePatches(camera.getProjectionMatrix(aspect_ratio) * camera.getModelviewMatrix(), visiblePatches);
+}
+
+
+//****************************************************
+// function that does the actual drawing of stuff
+// (into whatever the current GL draw target is)
+//***************************************************
+void renderScene() {
+	updateScreenSpaceTessellation();
+
+	// clear the color buffer
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glMatrixMode(GL_PROJECTION);
+
+	// make sure transformation is "zero'd"
+	glLoadIdentity();
+
+	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
+
+	// set OpenGL viewport
+	glViewport(0, 0, viewport.w, viewport.h);
+
+	gluPerspective(camera.FIELD_OF_VIEW * camera.ZOOM_AMOUNT, aspect_ratio, camera.zNear, camera.zFar);
+
+	// set shading of model to smooth or flat, based on our global variable
+	if (SMOOTH_SHADING) {
+		glShadeModel(GL_SMOOTH);
+	} else {
+		glShadeModel(GL_FLAT);
+	}
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	// Set camera, via the following:
+	// void gluLookAt(GLdouble eyeX, GLdouble eyeY, GLdouble eyeZ, GLdouble centerX, GLdouble centerY,
+	//                GLdouble centerZ, GLdouble upX, GLdouble upY, GLdouble upZ);
+	gluLookAt(camera.position.x(), camera.position.y(), camera.position.z(), camera.lookAt.x(), camera.lookAt.y(),
+			camera.lookAt.z(), camera.up.x(), camera.up.y(), camera.up.z());
+
+	// Handle rotations
+	glRotatef(camera.X_ROTATION_AMOUNT, 1, 0, 0);
+	glRotatef(camera.Y_ROTATION_AMOUNT, 0, 1, 0);
+	glRotatef(camera.Z_ROTATION_AMOUNT, 0, 0, 1);
+
+	// Handle translations
+	glTranslatef(camera.X_TRANSLATION_AMOUNT, camera.Y_TRANSLATION_AMOUNT, camera.Z_TRANSLATION_AMOUNT);
+
+	if (objMode) {
+		for (int j = 0; j < objMesh.getNumberOfPolygons(); j++) {
+
+			if (WIREFRAME_MODE) {
+				if (HIDDEN_LINE_MODE) {
+					glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
+
+					glDisable(GL_LIGHTING);
+					glClearColor(0.0, 0.0, 0.0, 0.0);
+					// Default the drawing color to white
+					glColor3f(1.0f, 1.0f, 1.0f);
+
+					glBegin(GL_POLYGON);
+
+					drawObjPolygon(j, false);
+
+					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+					glEnable(GL_POLYGON_OFFSET_FILL);
+					glPolygonOffset(1.0, 1.0);
+					glClearColor(0.0, 0.0, 0.0, 0.0);
+					glColor3f(0.0, 0.0, 0.0);
+
+					glBegin(GL_POLYGON);
+					drawObjPolygon(j, false);
+					glEnd();
+					glDisable(GL_POLYGON_OFFSET_FILL);
+
+
+				} else {
+					// Draw objects in wireframe mode
+					glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
+
+					glDisable(GL_LIGHTING);
+					glClearColor(0.0, 0.0, 0.0, 0.0);
+					// Default the drawing color to white
+					glColor3f(1.0f, 1.0f, 1.0f);
+
+					glBegin(GL_POLYGON);
+
+					drawObjPolygon(j, false);
+
+					glEnd();
+				}
+
+
+			} else {
+				// Draw objects in filled mode
+				glPolygonMode( GL_FRONT, GL_FILL);
+				glPolygonMode( GL_BACK, GL_FILL);
+				glClearColor(0.0, 0.0, 0.0, 0.0);
+				glEnable(GL_LIGHTING);
+
+				glBegin(GL_POLYGON);
+
+				drawObjPolygon(j, true);
+
+
+				glEnd();
+			}
+		}
+
+
+	} else if (!IMMEDIATE_MODE) {
+		// Draw the visible patches' triangles from the GPU, uploading them first if they've been retessellated since last frame
+		if (!meshBuffer.isCurrent(tessellationGeneration)) {
+			meshBuffer.upload(listOfBezierPatches, tessellationGeneration);
+		}
+		findVisiblePatches();
+
+		if (WIREFRAME_MODE) {
+			// Draw objects in wireframe mode
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+			glDisable(GL_LIGHTING);
+			glClearColor(0.0, 0.0, 0.0, 0.0);
+			// Default the drawing color to white
+			glColor3f(1.0f, 1.0f, 1.0f);
+
+			meshBuffer.draw(visiblePatches);
+
+			if (HIDDEN_LINE_MODE) {
+				// Fill the triangles in black, pushed back a little so that they hide only the lines behind them
+				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+				glEnable(GL_POLYGON_OFFSET_FILL);
+				glPolygonOffset(1.0, 1.0);
+				glColor3f(0.0, 0.0, 0.0);
+
+				meshBuffer.draw(visiblePatches);
+
+				glDisable(GL_POLYGON_OFFSET_FILL);
+			}
+
+		} else {
+			// Draw objects in filled mode
+			glPolygonMode(GL_FRONT, GL_FILL);
+			glPolygonMode(GL_BACK, GL_FILL);
+			glClearColor(0.0, 0.0, 0.0, 0.0);
+			glEnable(GL_LIGHTING);
+
+			meshBuffer.draw(visiblePatches);
+		}
+
+	} else {
+
+		/*
+		Begin drawing all of the triangles
+		PSUEDOCODE:
+
+		for each BezierPatch in the scene's list of Bezier patches:
+			for each Triangle in the current Bezier patch's list of triangles
+				Grab the three vertices of the triangle and render the triangle
+
+		 */
+
+		// Iterate through each of our BezierPatches that are in view...
+		findVisiblePatches();
+		for (std::vector<int>::size_type i = 0; i < visiblePatches.size(); i++) {
+			BezierPatch &currentBezierPatch = listOfBezierPatches[visiblePatches[i]];
+			for (TessellationList<uint32_t>::size_type j = 0; j < currentBezierPatch.listOfTriangleIndices.size(); j += 3) {
+				// Look up the triangle's three vertices in the patch's vertex list
+				const DifferentialGeometry &point1 = currentBezierPatch.listOfDifferentialGeometries[currentBezierPatch.listOfTriangleIndices[j]];
+				const DifferentialGeometry &point2 = currentBezierPatch.listOfDifferentialGeometries[currentBezierPatch.listOfTriangleIndices[j + 1]];
+				const DifferentialGeometry &point3 = currentBezierPatch.listOfDifferentialGeometries[currentBezierPatch.listOfTriangleIndices[j + 2]];
+
+				if (WIREFRAME_MODE) {
+					if (HIDDEN_LINE_MODE) {
+						glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
+
+						glDisable(GL_LIGHTING);
+						glClearColor(0.0, 0.0, 0.0, 0.0);
+						// Default the drawing color to white
+						glColor3f(1.0f, 1.0f, 1.0f);
+
+						glBegin(GL_POLYGON);
+
+						// Set vertex and normals of all three points of the current triangle
+						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
+						glEnd();
+
+						glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+						glEnable(GL_POLYGON_OFFSET_FILL);
+						glPolygonOffset(1.0, 1.0);
+						glClearColor(0.0, 0.0, 0.0, 0.0);
+						glColor3f(0.0, 0.0, 0.0);
+
+						glBegin(GL_POLYGON);
+						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
+						glEnd();
+						glDisable(GL_POLYGON_OFFSET_FILL);
+
+					} else {
+						// Draw objects in wireframe mode
+						glPolygonMode( GL_FRONT_AND_BACK, GL_LINE);
+
+						glDisable(GL_LIGHTING);
+						glClearColor(0.0, 0.0, 0.0, 0.0);
+						// Default the drawing color to white
+						glColor3f(1.0f, 1.0f, 1.0f);
+
+						glBegin(GL_POLYGON);
+
+						// Set vertex and normals of all three points of the current triangle
+						glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+						glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+						glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+						glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+						glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+						glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
+						glEnd();
+					}
+
+
+				} else {
+					// Draw objects in filled mode
+					glPolygonMode( GL_FRONT, GL_FILL);
+					glPolygonMode( GL_BACK, GL_FILL);
+					glClearColor(0.0, 0.0, 0.0, 0.0);
+					glEnable(GL_LIGHTING);
+
+					glBegin(GL_POLYGON);
+
+					// Set vertex and normals of all three points of the current triangle
+					glNormal3f(point1.normal.x(), point1.normal.y(), point1.normal.z());
+					glVertex3f(point1.position.x(), point1.position.y(), point1.position.z());
+					glNormal3f(point2.normal.x(), point2.normal.y(), point2.normal.z());
+					glVertex3f(point2.position.x(), point2.position.y(), point2.position.z());
+					glNormal3f(point3.normal.x(), point3.normal.y(), point3.normal.z());
+					glVertex3f(point3.position.x(), point3.position.y(), point3.position.z());
+
+					glEnd();
+				}
+			}
+		}
+	}
+
+
+	glPopMatrix();
+
+	glFlush();
+}
+
+//****************************************************
+// Draws the scene with softwareRasterizer, through the same camera and display modes as renderScene()
+//***************************************************
+void renderSceneInSoftware() {
+	updateScreenSpaceTessellation();
+
+	if (!objMode) {
+		findVisiblePatches();
+	}
+	if (!softwareRasterizer.isCurrent(tessellationGeneration) || (!objMode && !softwareRasterizer.holdsPatches(visiblePatches))) {
+		SoftwareRasterizer::LightList lights;
+		lights.push_back(SoftwareRasterizer::Light(Eigen::Vector4f(lightPos0), Eigen::Vector3f(lightColor0)));
+		lights.push_back(SoftwareRasterizer::Light(Eigen::Vector4f(lightPos1), Eigen::Vector3f(lightColor1)));
+		softwareRasterizer.setLighting(Eigen::Vector3f(ambientColor), lights);
+
+		if (objMode) {
+			softwareRasterizer.setObjMesh(objMesh, tessellationGeneration);
+		} else {
+			softwareRasterizer.setPatches(listOfBezierPatches, visiblePatches, tessellationGeneration);
+		}
+	}
+
+	SoftwareRasterizer::Mode mode = SoftwareRasterizer::FILLED;
+	if (WIREFRAME_MODE) {
+		mode = HIDDEN_LINE_MODE ? SoftwareRasterizer::HIDDEN_LINE : SoftwareRasterizer::WIREFRAME;
+	}
+
+	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
+	softwareRasterizer.render(getThreadPool(), viewport.w, viewport.h, camera.getModelviewMatrix(),
+			camera.getProjectionMatrix(aspect_ratio), mode, SMOOTH_SHADING);
+}
+
+void myDisplay() {
+	Profiler::ScopedTimer timer(profiler, Profiler::FRAME);
+
+	if (SOFTWARE_RENDERING) {
+		renderSceneInSoftware();
+
+		// Copy the image into the window, bottom left corner first
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glViewport(0, 0, viewport.w, viewport.h);
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glDisable(GL_LIGHTING);
+		glDisable(GL_DEPTH_TEST);
+		glRasterPos2f(-1.0f, -1.0f);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glDrawPixels(viewport.w, viewport.h, GL_RGB, GL_UNSIGNED_BYTE, softwareRasterizer.getPixels());
+		glEnable(GL_DEPTH_TEST);
+	} else {
+		renderScene();
+	}
+	glutSwapBuffers();					// swap buffers (we earlier set double buffer)
+}
+
+
+
+// (defined with the rest of the subdivision code, below)
+void retessellate(float newSubdivisionParameter);
+void printProfile();
+
+//****************************************************
+// function that assists with regular key presses
+//***************************************************
+void keyPressed( unsigned char key, int x, int y )
+{
+	switch ( key )
+	{
+	// Space bar: exit program
+	case ' ':
+		exit(1);
+
+	case 's':
+		// Toggle between flat and smooth shading, but only if we aren't in wireframe mode
+		if (!WIREFRAME_MODE) {
+			SMOOTH_SHADING = !SMOOTH_SHADING;
+			if (debug) {
+				if (SMOOTH_SHADING) {
+					cout << "Turned smooth shading ON.\n";
+				} else {
+					cout << "Turned smooth shading OFF.\n";
+				}
+			}
+		}
+		break;
+
+	case 'w':
+		// Toggle between wireframe mode and filled mode
+		WIREFRAME_MODE = !WIREFRAME_MODE;
+		if (debug) {
+			if (WIREFRAME_MODE) {
+				cout << "Turned wireframe mode ON.\n";
+			} else {
+				cout << "Turned wireframe mode OFF.\n";
+			}
+		}
+		break;
+
+	case 'h':
+		// Toggle between filled and hidden-line mode
+		HIDDEN_LINE_MODE = !HIDDEN_LINE_MODE;
+		if (debug) {
+			if (HIDDEN_LINE_MODE) {
+				cout << "Turned hidden line mode ON.\n";
+			} else {
+				cout << "Turned hidden line mode OFF.\n";
+			}
+		}
+		break;
+
+	case '+':
+		// Zoom in
+		camera.zoomIn();
+		break;
+
+	case '-':
+		// Zoom out
+		camera.zoomOut();
+		break;
+
+	case ']':
+		// Refine: halve the step size (uniform) or error (adaptive), re-tessellating only what changes
+		if (!objMode) {
+			retessellate(subdivisionParameter / 2.0f);
+		}
+		break;
+
+	case '[':
+		// Coarsen: double the step size (up to a single step per side) or error
+		if (!objMode && (subdivisionMethod == "ADAPTIVE" || subdivisionParameter * 2.0f <= 1.0f)) {
+			retessellate(subdivisionParameter * 2.0f);
+		}
+		break;
+
+	case 'p':
+		// Print (and with -profile, save) the profile so far
+		printProfile();
+		break;
+
+	case 'r':
+		// Reset everything
+		SMOOTH_SHADING = true;
+		WIREFRAME_MODE = true;
+		camera.resetCamera();
+		break;
+
+	case '.':
+		// Rotate Z clockwise, looking from above
+		camera.rotateZDown();
+		break;
+
+	case ',':
+		// Rotate Z counterclockwise, looking from above
+		camera.rotateZUp();
+		break;
+	}
+
+}
+
+
+//****************************************************
+// function that assists with special (i.e. arrow key) key presses
+//***************************************************
+void handleSpecialKeypress(int key, int x, int y) {
+	int mod_key = glutGetModifiers();
+	switch (key) {
+		case GLUT_KEY_LEFT:
+			if (mod_key == GLUT_ACTIVE_SHIFT) {
+				camera.translateLeft();
+			} else {
+				camera.rotateDown();
+			}
+			break;
+
+		case GLUT_KEY_RIGHT:
+			if (mod_key == GLUT_ACTIVE_SHIFT) {
+				camera.translateRight();
+			} else {
+				camera.rotateUp();
+			}
+			break;
+
+		case GLUT_KEY_UP:
+			if (mod_key == GLUT_ACTIVE_SHIFT) {
+				camera.translateUp();
+			} else if (mod_key == GLUT_ACTIVE_ALT) {
+				camera.translateZUp();
+			} else {
+				camera.rotateLeft();
+			}
+			break;
+
+		case GLUT_KEY_DOWN:
+			if (mod_key == GLUT_ACTIVE_SHIFT) {
+				camera.translateDown();
+			} else if (mod_key == GLUT_ACTIVE_ALT) {
+				camera.translateZDown();
+			} else {
+				camera.rotateRight();
+			}
+			break;
+		case GLUT_KEY_PAGE_UP:
+			camera.translateZUp();
+			break;
+		case GLUT_KEY_PAGE_DOWN:
+			camera.translateZDown();
+			break;
+
+	}
+	glutPostRedisplay();
+
+}
+
+
+//****************************************************
+// The ray from the near plane through the center of pixel (x, y) of the window (y counting down from the top),
+// as the current camera sees it. t = 1 is at the far plane
+//***************************************************
+Ray getCameraRay(const Eigen::Matrix4f &inverseModelviewProjection, int x, int y) {
+	float ndcX = 2.0f * (x + 0.5f) / viewport.w - 1.0f;
+	float ndcY = 1.0f - 2.0f * (y + 0.5f) / viewport.h;
+	Eigen::Vector3f nearPoint = (inverseModelviewProjection * Eigen::Vector4f(ndcX, ndcY, -1.0f, 1.0f)).hnormalized();
+	Eigen::Vector3f farPoint = (inverseModelviewProjection * Eigen::Vector4f(ndcX, ndcY, 1.0f, 1.0f)).hnormalized();
+	return Ray(nearPoint, farPoint - nearPoint);
+}
+
+Eigen::Matrix4f getInverseModelviewProjection() {
+	float aspect_ratio = ((float) viewport.w) / ((float) viewport.h);
+	return (camera.getProjectionMatrix(aspect_ratio) * camera.getModelviewMatrix()).inverse();
+}
+
+
+//****************************************************
+// Left click: finds the point of the surface under the mouse, intersecting a ray through the pixel
+// with the patches themselves, and prints it
+//***************************************************
+void mouseClicked(int button, int state, int x, int y) {
+	if (button != GLUT_LEFT_BUTTON || state != GLUT_DOWN || objMode) {
+		return;
+	}
+
+	RayHit hit;
+	if (!patchBVH.intersect(listOfBezierPatches, getCameraRay(getInverseModelviewProjection(), x, y), hit)) {
+		cout << "Picked nothing.\n";
+	} else {
+		const DifferentialGeometry &point = hit.geometry;
+		printf("Picked Bezier patch %d at (u, v) = (%f, %f): position (%f, %f, %f), normal (%f, %f, %f).\n", hit.patch + 1,
+				point.uvValues.x(), point.uvValues.y(), point.position.x(), point.position.y(), point.position.z(),
+				point.normal.x(), point.normal.y(), point.normal.z());
+	}
+}
+
+
+//****************************************************
+// function that prints all of our command line option variables
+//***************************************************
+void printCommandLineOptionVariables( )
+{
+	if (debug)
+	{
+		cout << "\nBezier file: " << filename << "\n";
+		cout << "Subdivision Parameter: " << subdivisionParameter << "\n";
+		cout << "Subdivision Method: " << subdivisionMethod << "\n";
+		cout << "Evaluation Method: " << evaluationMethod << "\n\n";
+
+		cout << "We currently have " << listOfBezierPatches.size() << " Bezier patches.\n\n";
+		// Iterate through Bezier Patches
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			cout << "  Bezier patch " << (i + 1) << ":\n\n";
+			std::vector<std::vector <Eigen::Vector3f> > curves = listOfBezierPatches[i].getCurves();
+
+			// Iterate through curves in each Bezier patch
+			for (std::vector<std::vector <Eigen::Vector3f> >::size_type j = 0; j < curves.size(); j++) {
+				std::vector<Eigen::Vector3f> listOfPointsForCurrentCurve = curves[j];
+
+				cout << "    Curve " << (j + 1) << ":\n";
+
+				// Iterate through points in current curve and print them (with their weights, if the patch is rational)
+				for (std::vector<Eigen::Vector3f>::size_type k = 0; k < listOfPointsForCurrentCurve.size(); k++) {
+					printf("    (%f, %f, %f)", listOfPointsForCurrentCurve[k].x(), listOfPointsForCurrentCurve[k].y(), listOfPointsForCurrentCurve[k].z());
+					if (listOfBezierPatches[i].rational) {
+						printf(" weight %f", listOfBezierPatches[i].getWeight(j, k));
+					}
+					printf("\n");
+				}
+				cout << "\n\n";
+			}
+		}
+
+		cout << "Display options:\n";
+		if (SMOOTH_SHADING) {
+			cout << "  Smooth shading is ON.\n";
+		} else {
+			cout << "  Flat shading is ON. (i.e. smooth shading is OFF)\n";
+		}
+
+		if (WIREFRAME_MODE) {
+			cout << "  Wireframe mode is ON.\n";
+		} else {
+			cout << "  Filled mode is ON. (i.e. Wireframe mode is OFF)\n";
+		}
+
+	}
+}
+
+
+//****************************************************
+// function that prints all triangles in every Bezier Patch
+//***************************************************
+void printTrianglesInBezierPatches() {
+	if (debug) {
+		// Iterate through Bezier Patches
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			cout << "  Bezier patch " << (i + 1) << ":\n\n";
+
+			// Iterate through Triangles in the current Bezier patch
+			for (int j = 0; j < listOfBezierPatches[i].getNumberOfTriangles(); j++) {
+				Triangle currentTriangle = listOfBezierPatches[i].getTriangle(j);
+				cout << "    Triangle " << (j + 1) << ":\n";
+				cout << "      " << currentTriangle.printTriangleInformation();
+			}
+
+		}
+	}
+}
+
+
+//****************************************************
+// function that prints all differential geometries in every Bezier Patch
+//***************************************************
+void printDifferentialGeometriesInBezierPatches() {
+	if (debug) {
+		// Iterate through Bezier Patches
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			cout << "  Bezier patch " << (i + 1) << ":\n\n";
+
+			// Iterate through Triangles in the current Bezier patch
+			for (TessellationList<DifferentialGeometry>::size_type j = 0; j < listOfBezierPatches[i].listOfDifferentialGeometries.size(); j++) {
+				DifferentialGeometry currentDifferentialGeometry = listOfBezierPatches[i].listOfDifferentialGeometries[j];
+				cout << "    DifferentialGeometry " << (j + 1) << ":\n";
+				Eigen::Vector3f currentPosition = currentDifferentialGeometry.position;
+				cout << "      (" << currentPosition.x() << " , " << currentPosition.y() << " , " << currentPosition.z() << ")\n";
+			}
+
+		}
+	}
+}
+
+// (defined with the benchmarks, below)
+long countSceneTriangles();
+
+//****************************************************
+// Prints how long each stage of the program has taken (see Profiler), and totals over the scene: vertices,
+// triangles, surface evaluations, how many triangles adaptive subdivision sorted into each of its cases,
+// and how often the tessellation scratch arenas (see TessellationArena) have had to grow.
+// With -profile, also saves all of it to profileFilename
+//***************************************************
+void printProfile() {
+	long numberOfVertices = 0;
+	long numberOfTriangles = 0;
+	long numberOfSurfaceEvaluations = 0;
+	long peakFrontierSize = 0;
+	long numberOfTrianglesPerCase[8] = { 0 };
+	if (objMode) {
+		numberOfVertices = objMesh.vertices.size();
+		numberOfTriangles = countSceneTriangles();
+	}
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		const BezierPatch &patch = listOfBezierPatches[i];
+		numberOfVertices += patch.listOfDifferentialGeometries.size();
+		numberOfTriangles += patch.listOfTriangleIndices.size() / 3;
+		numberOfSurfaceEvaluations += patch.numberOfSurfaceEvaluations;
+		peakFrontierSize = std::max(peakFrontierSize, patch.peakFrontierSize);
+		for (int k = 0; k < 8; k++) {
+			numberOfTrianglesPerCase[k] += patch.numberOfTrianglesPerCase[k];
+		}
+	}
+	profiler.setCounter(Profiler::PATCHES, listOfBezierPatches.size());
+	profiler.setCounter(Profiler::VERTICES, numberOfVertices);
+	profiler.setCounter(Profiler::TRIANGLES, numberOfTriangles);
+	profiler.setCounter(Profiler::SURFACE_EVALUATIONS, numberOfSurfaceEvaluations);
+	profiler.setCounter(Profiler::PEAK_ADAPTIVE_FRONTIER, peakFrontierSize);
+	for (int k = 0; k < 8; k++) {
+		profiler.setCounter((Profiler::Counter) (Profiler::ADAPTIVE_CASE_1 + k), numberOfTrianglesPerCase[k]);
+	}
+	profiler.setCounter(Profiler::SCRATCH_ARENA_BLOCK_ALLOCATIONS, TessellationArena::numberOfBlockAllocations());
+	profiler.setCounter(Profiler::SCRATCH_ARENA_BYTES, TessellationArena::bytesReserved());
+
+	profiler.print(PROFILE_MODE);
+	if (PROFILE_MODE && !profileFilename.empty() && !profiler.writeJSON(profileFilename, PROFILE_MODE)) {
+		cout << "Could not write " << profileFilename << "\n";
+	}
+}
+
+
+
+//****************************************************
+// function that prints the number of triangles and differential geometries for each Bezier patch
+//***************************************************
+void printCameraInformation() {
+	if (debug) {
+		cout << "\n  Camera information:\n\n";
+		cout << "Position:\n" << camera.position << "\n\n";
+		cout << "Up:\n" << camera.up << "\n\n";
+		cout << "Look At:\n" << camera.lookAt << "\n\n";
+		cout << "Z-Near: " << camera.zNear << "; Z-Far: " << camera.zFar << "\n";
+		cout << "Field of view: " << camera.FIELD_OF_VIEW << "\n";
+		cout << "Zoom amount: " << camera.ZOOM_AMOUNT << "\n";
+	}
+}
+
+
+//****************************************************
+// The BezierPatch evaluator that evaluationMethod names
+//***************************************************
+BezierPatch::EvaluationMethod getEvaluationMethod() {
+	if (evaluationMethod == "CASTELJAU") {
+		return BezierPatch::DE_CASTELJAU;
+	} else if (evaluationMethod == "SIMD") {
+		return BezierPatch::SIMD;
+	} else {
+		return BezierPatch::BERNSTEIN;
+	}
+}
+
+
+//****************************************************
+// Gives a BezierPatch the command line's evaluation and subdivision options
+//***************************************************
+void configurePatch(BezierPatch &patch) {
+	patch.evaluationMethod = getEvaluationMethod();
+	patch.depthFirstSubdivision = DEPTH_FIRST_SUBDIVISION;
+	patch.maxSubdivisionDepth = maxSubdivisionDepth;
+}
+
+
+//****************************************************
+// Subdivides a single BezierPatch. Patches share no state, so this
+// is safe to call for different patches from different threads.
+//***************************************************
+void subdividePatch(BezierPatch &patch, bool adaptive_subdivision) {
+	configurePatch(patch);
+
+	if (adaptive_subdivision && SCREEN_SPACE_SUBDIVISION) {
+		// The view isn't known yet (the camera is framed around this tessellation), so start with a coarse grid
+		// that updateScreenSpaceTessellation replaces before the first frame
+		patch.performUniformSubdivision(0.125f);
+	} else if (adaptive_subdivision) {
+		patch.performAdaptiveSubdivision(subdivisionParameter);
+	} else {
+		patch.performUniformSubdivision(subdivisionParameter);
+	}
+}
+
+
+//****************************************************
+// For uniform subdivision, where every patch's tessellation has a size known up front: makes one
+// scene-wide vertex buffer and one index buffer, and attaches each patch's lists to its own slice of them,
+// so the patches (on whichever thread) write their tessellations straight into place. A patch that's later
+// retessellated more finely than its slice holds moves out into storage of its own (see TessellationList)
+//***************************************************
+void attachPatchesToSceneBuffers(float stepSize) {
+	if (listOfBezierPatches.empty()) {
+		return;
+	}
+
+	size_t verticesPerPatch, indicesPerPatch;
+	BezierPatch::getUniformTessellationSize(stepSize, verticesPerPatch, indicesPerPatch);
+	sceneVertices.resize(listOfBezierPatches.size() * verticesPerPatch);
+	sceneTriangleIndices.resize(listOfBezierPatches.size() * indicesPerPatch);
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		listOfBezierPatches[i].listOfDifferentialGeometries.attach(&sceneVertices[i * verticesPerPatch], verticesPerPatch);
+		listOfBezierPatches[i].listOfTriangleIndices.attach(&sceneTriangleIndices[i * indicesPerPatch], indicesPerPatch);
+	}
+}
+
+
+//****************************************************
+// Frees sceneVertices / sceneTriangleIndices once no patch is attached to them any more (e.g. after
+// retessellating more finely has moved every patch out into storage of its own), so that the scene
+// doesn't go on holding its old tessellation next to the new one
+//***************************************************
+void releaseDetachedSceneBuffers() {
+	bool verticesInUse = false;
+	bool indicesInUse = false;
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		verticesInUse = verticesInUse || listOfBezierPatches[i].listOfDifferentialGeometries.isAttached();
+		indicesInUse = indicesInUse || listOfBezierPatches[i].listOfTriangleIndices.isAttached();
+	}
+	if (!verticesInUse) {
+		std::vector<DifferentialGeometry>().swap(sceneVertices);
+	}
+	if (!indicesInUse) {
+		std::vector<uint32_t>().swap(sceneTriangleIndices);
+	}
+}
+
+
+//****************************************************
+// Method that populates each BezierPatch's list of DifferentialGeometries
+// and list of Triangles, based on what kind of subdivision (i.e. adaptive or uniform)
+// we are performing
+//***************************************************
+void perform_subdivision(bool adaptive_subdivision) {
+	Profiler::ScopedTimer timer(profiler, Profiler::SUBDIVIDE);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if (!adaptive_subdivision) {
+		attachPatchesToSceneBuffers(subdivisionParameter);
+	}
+
+	if (numberOfThreads > 1) {
+		// Each patch is an independent task; the pool balances them by work stealing
+		getThreadPool().parallelFor(listOfBezierPatches.size(), [adaptive_subdivision](int i) {
+			subdividePatch(listOfBezierPatches[i], adaptive_subdivision);
+		});
+	} else {
+		// Iterate through each of the Bezier patches...
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			subdividePatch(listOfBezierPatches[i], adaptive_subdivision);
+		}
+	}
+	tessellationGeneration++;
+
+	if (debug) {
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		cout << "Subdivision took " << elapsed.count() << " ms using the " << evaluationMethod << " evaluator on "
+				<< numberOfThreads << " thread(s).\n";
+	}
+}
+
+
+//****************************************************
+// Re-tessellates every patch with a new step size (uniform) or error (adaptive), reusing as much
+// of the current tessellation as each patch can (see BezierPatch::retessellateUniform / retessellateAdaptive)
+//***************************************************
+void retessellate(float newSubdivisionParameter) {
+	Profiler::ScopedTimer timer(profiler, Profiler::RETESSELLATE);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	subdivisionParameter = newSubdivisionParameter;
+	bool adaptive_subdivision = (subdivisionMethod == "ADAPTIVE");
+	getThreadPool().parallelFor(listOfBezierPatches.size(), [adaptive_subdivision](int i) {
+		if (adaptive_subdivision) {
+			listOfBezierPatches[i].retessellateAdaptive(subdivisionParameter);
+		} else {
+			listOfBezierPatches[i].retessellateUniform(subdivisionParameter);
+		}
+	});
+	releaseDetachedSceneBuffers();
+	tessellationGeneration++;
+
+	if (debug) {
+		long numberOfTriangles = 0;
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			numberOfTriangles += listOfBezierPatches[i].getNumberOfTriangles();
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		cout << "Re-tessellated with " << (adaptive_subdivision ? "error " : "step size ") << subdivisionParameter
+				<< " in " << elapsed.count() << " ms (" << numberOfTriangles << " triangles).\n";
+	}
+}
+
+
+
+
+//****************************************************
+// Writes an .obj file that represents this BezierPatch
+//
+// Each vertex is written once along with its normal, and each face refers to both with "f v//vn".
+// Neighboring patches share the vertices along their common edges, so vertices on a patch's
+// boundary (u or v is 0 or 1) are only written if no other patch has written the same one already.
+// Returns the number of bytes written (0 if the file couldn't be opened)
+//***************************************************
+long generateObjFile(std::string filename) {
+	Profiler::ScopedTimer timer(profiler, Profiler::EXPORT_OBJ);
+	chrono::high_resolution_clock::time_point writeStart = chrono::high_resolution_clock::now();
+
+	ObjWriter writer(filename);
+	if (!writer.isOpen()) {
+		cout << "Could not open " << filename << " for writing.\n";
+		return 0;
+	}
+
+	// For each patch, the .obj indices its vertices ended up with
+	std::vector<long> vertexIndices;
+	std::vector<long> normalIndices;
+
+	// (uniform subdivision's last row can land a rounding error short of 1)
+	const float boundaryTolerance = 1e-5f;
+
+	long numberOfVertices = 0;
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		const TessellationList<DifferentialGeometry> &vertices = listOfBezierPatches[i].listOfDifferentialGeometries;
+		numberOfVertices += vertices.size();
+
+		vertexIndices.resize(vertices.size());
+		normalIndices.resize(vertices.size());
+		for (TessellationList<DifferentialGeometry>::size_type j = 0; j < vertices.size(); j++) {
+			const Eigen::Vector2f &uv = vertices[j].uvValues;
+			if (uv.x() < boundaryTolerance || uv.x() > 1.0f - boundaryTolerance || uv.y() < boundaryTolerance
+					|| uv.y() > 1.0f - boundaryTolerance) {
+				vertexIndices[j] = writer.writeUniqueVertex(vertices[j].position);
+				normalIndices[j] = writer.writeUniqueNormal(vertices[j].normal);
+			} else {
+				vertexIndices[j] = writer.writeVertex(vertices[j].position);
+				normalIndices[j] = writer.writeNormal(vertices[j].normal);
+			}
+		}
+
+		const TessellationList<uint32_t> &indices = listOfBezierPatches[i].listOfTriangleIndices;
+		for (TessellationList<uint32_t>::size_type j = 0; j < indices.size(); j += 3) {
+			writer.writeTriangle(vertexIndices[indices[j]], normalIndices[indices[j]],
+					vertexIndices[indices[j + 1]], normalIndices[indices[j + 1]],
+					vertexIndices[indices[j + 2]], normalIndices[indices[j + 2]]);
+		}
+	}
+	writer.flush();
+
+	if (debug) {
+		double milliseconds = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - writeStart).count();
+		double megabytes = writer.getBytesWritten() / (1024.0 * 1024.0);
+		cout << "Wrote " << filename << ": " << megabytes << " MB (" << numberOfVertices << " patch vertices) in "
+				<< milliseconds << " ms, " << megabytes / (milliseconds / 1000.0) << " MB/s\n";
+	}
+	return writer.getBytesWritten();
+}
+
+
+
+//****************************************************
+// Fills in the key that the current .bez file's tessellation is cached under: the file's contents,
+// plus every option that changes the tessellation. Returns false if the file can't be read
+//***************************************************
+bool getMeshCacheKey(MeshCache::Key &key) {
+	MappedFile file(filename);
+	if (!file.isOpen()) {
+		return false;
+	}
+	key.sourceHash = MeshCache::hash(file.begin(), file.end());
+	key.sourceSize = file.size();
+	key.adaptive = (subdivisionMethod == "ADAPTIVE") ? 1 : 0;
+	key.evaluationMethod = getEvaluationMethod();
+	key.subdivisionParameter = subdivisionParameter;
+	key.depthFirstSubdivision = DEPTH_FIRST_SUBDIVISION ? 1 : 0;
+	key.maxSubdivisionDepth = maxSubdivisionDepth;
+	return true;
+}
+
+
+//****************************************************
+// Saves the tessellated patches to meshCacheFilename, for loadMeshCache to pick up next time
+//***************************************************
+void saveMeshCache() {
+	chrono::high_resolution_clock::time_point saveStart = chrono::high_resolution_clock::now();
+
+	MeshCache::Key key;
+	if (!getMeshCacheKey(key) || !MeshCache::save(meshCacheFilename, key, listOfBezierPatches)) {
+		cout << "Could not write the mesh cache " << meshCacheFilename << ".\n";
+		return;
+	}
+
+	if (debug) {
+		cout << "Saved the mesh cache " << meshCacheFilename << " in "
+				<< chrono::duration<double, milli>(chrono::high_resolution_clock::now() - saveStart).count() << " ms" << endl;
+	}
+}
+
+
+//****************************************************
+// Loads the patches and their tessellations from meshCacheFilename instead of parsing and tessellating
+// the .bez file, if the cache was saved from the same file with the same options.
+// Returns false, changing nothing, if there is no such cache
+//***************************************************
+bool loadMeshCache() {
+	Profiler::ScopedTimer timer(profiler, Profiler::LOAD_MESH_CACHE);
+	chrono::high_resolution_clock::time_point loadStart = chrono::high_resolution_clock::now();
+
+	MeshCache::Key key;
+	if (!getMeshCacheKey(key) || !MeshCache::load(meshCacheFilename, key, listOfBezierPatches)) {
+		if (debug) {
+			cout << "No usable mesh cache in " << meshCacheFilename << "; tessellating " << filename << endl;
+		}
+		return false;
+	}
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		configurePatch(listOfBezierPatches[i]);
+	}
+	numberOfBezierPatches = listOfBezierPatches.size();
+	patchBVH.build(listOfBezierPatches);
+	tessellationGeneration++;
+
+	if (debug) {
+		cout << "Loaded " << numberOfBezierPatches << " tessellated patches from " << meshCacheFilename << " in "
+				<< chrono::duration<double, milli>(chrono::high_resolution_clock::now() - loadStart).count() << " ms" << endl;
+	}
+	return true;
+}
+
+
+//****************************************************
+// function that parses an input .bez file and initializes
+// a list of Bezier patches
+//
+// A patch is usually 4 rows of 4 points (bicubic), but may have any degree up to
+// MAX_BEZIER_DEGREE: a patch whose rows have n points has n rows, unless it is preceded by
+// a line "degreeU degreeV", in which case it has degreeV + 1 rows of degreeU + 1 points.
+// A line "degreeU degreeV rational" makes the patch rational: each of its points is then
+// 4 numbers, "x y z weight", with a positive weight
+//
+// psuedocode for parsing .bez file (of bicubic patches)
+
+/*
+
+BezierPatch currentBezierPatch
+for each collection of 4 rows that correspond to one Bezier patch:
+    for i between 1 and 4 (ie. each of the 4 rows for the current patch):
+        Vect3 point1 = first row
+        Vect3 point2 = second row
+        Vect3 point3 = third row
+        Vect3 point4 = fourth row
+        vector<Vect3> curveI;
+        curveI.push_back(point1);
+        curveI.push_back(point2);
+        curveI.push_back(point3);
+        curveI.push_back(point4);
+        currentBezierPatch.addCurve(curveI);
+    all_bezier_patches.addPatch(currentBezierPatch);
+
+*/
+//****************************************************
+void readBezierFile(string filename) {
+	Profiler::ScopedTimer timer(profiler, Profiler::PARSE_BEZIER);
+
+	chrono::high_resolution_clock::time_point parseStart = chrono::high_resolution_clock::now();
+
+	MappedFile file(filename);
+	if (!file.isOpen()) {
+		cout << "Could not open " << filename << ", terminating program." << endl;
+		exit(1);
+	}
+	TextScanner scanner(file.begin(), file.end());
+
+	// The first line holds the number of patches, which we use to size listOfBezierPatches up front
+	// (but never past what the file could hold: the smallest patch is 2 curves of 2 points like "0 0 0 0 0 0")
+	const long minimumBytesPerPatch = 2 * (2 * 3 * 2);
+	long declaredNumberOfPatches = 0;
+	scanner.skipWhitespace();
+	if (!scanner.parseInt(declaredNumberOfPatches)) {
+		cout << "Malformed .bez file (missing patch count), terminating program." << endl;
+		exit(1);
+	}
+	scanner.skipLine();
+	listOfBezierPatches.reserve(min(max(declaredNumberOfPatches, 0L), (long) (file.size() / minimumBytesPerPatch)));
+
+	// line number, for error messages
+	int lineNumber = 2;
+
+	// number of lines that have already been processed for the current Bezier patch
+	int curvesParsedForCurrentPatch = 0;
+
+	// degrees given by a "degreeU degreeV" line for the next patch (0 = none, so the patch is square),
+	// and whether the line also said "rational"
+	long declaredDegreeU = 0, declaredDegreeV = 0;
+	bool declaredRational = false;
+
+	// Each patch is parsed in place as the last one in listOfBezierPatches, and dropped again if it is left unfinished
+	while (!scanner.atEnd()) {
+		scanner.skipSpaces();
+
+		// If we encounter a blank line, then we know that the next consecutive lines represent
+		// the curves that will make up a Bezier patch, so we reset our current Bezier patch
+		if (scanner.atEndOfLine()) {
+			if (curvesParsedForCurrentPatch != 0) {
+				listOfBezierPatches.pop_back();
+			}
+			curvesParsedForCurrentPatch = 0;
+			scanner.skipLine();
+			lineNumber++;
+			continue;
+		}
+
+		// Each line is one curve: degreeU + 1 points of 3 coordinates (or 4, with the weight, for a rational
+		// patch). Read up to one point past the most a curve can have, to tell a curve that is too long from one that fits
+		float numbers[4 * (MAX_BEZIER_DEGREE + 2)];
+		int numberOfNumbers = 0;
+		bool rationalKeyword = false;
+		scanner.skipSpaces();
+		while (!scanner.atEndOfLine() && numberOfNumbers < 4 * (MAX_BEZIER_DEGREE + 2)) {
+			if (!scanner.parseFloat(numbers[numberOfNumbers])) {
+				// ...unless it is the "rational" ending a line of degrees
+				const char *wordBegin;
+				const char *wordEnd;
+				rationalKeyword = numberOfNumbers == 2 && scanner.nextToken(wordBegin, wordEnd)
+						&& wordEnd - wordBegin == 8 && memcmp(wordBegin, "rational", 8) == 0;
+				scanner.skipSpaces();
+				if (!rationalKeyword || !scanner.atEndOfLine()) {
+					cout << "Malformed .bez file (bad number on line " << lineNumber << "), terminating program." << endl;
+					exit(1);
+				}
+				break;
+			}
+			numberOfNumbers++;
+			scanner.skipSpaces();
+		}
+		scanner.skipLine();
+		lineNumber++;
+
+		// A line of two numbers gives the degrees (along each curve, then across the curves) of the next patch
+		if (numberOfNumbers == 2 && curvesParsedForCurrentPatch == 0) {
+			declaredDegreeU = (long) numbers[0];
+			declaredDegreeV = (long) numbers[1];
+			declaredRational = rationalKeyword;
+			if (declaredDegreeU != numbers[0] || declaredDegreeV != numbers[1] || !BezierPatch().setDegrees(declaredDegreeU, declaredDegreeV)) {
+				cout << "Malformed .bez file (degrees on line " << (lineNumber - 1) << " must be whole numbers from 1 to "
+						<< MAX_BEZIER_DEGREE << "), terminating program." << endl;
+				exit(1);
+			}
+			continue;
+		}
+		if (rationalKeyword) {
+			cout << "Malformed .bez file (\"rational\" on line " << (lineNumber - 1) << " must follow the degrees of a patch), terminating program." << endl;
+			exit(1);
+		}
+
+		// The first curve decides the patch's degree along its curves; without declared degrees the patch
+		// is square, so e.g. lines of 4 points make the usual bicubic patch of 4 curves
+		int numbersPerPoint = declaredRational ? 4 : 3;
+		int numberOfPoints = numberOfNumbers / numbersPerPoint;
+		if (curvesParsedForCurrentPatch == 0) {
+			listOfBezierPatches.emplace_back();
+		}
+		BezierPatch &currentBezierPatch = listOfBezierPatches.back();
+		if (curvesParsedForCurrentPatch == 0) {
+			bool validDegrees = (declaredDegreeU != 0) ? currentBezierPatch.setDegrees(declaredDegreeU, declaredDegreeV)
+					: currentBezierPatch.setDegrees(numberOfPoints - 1, numberOfPoints - 1);
+			if (!validDegrees || numberOfNumbers % numbersPerPoint != 0) {
+				cout << "Malformed .bez file (expected 2 to " << MAX_BEZIER_DEGREE + 1 << " points of " << numbersPerPoint
+						<< " numbers each on line " << (lineNumber - 1) << "), terminating program." << endl;
+				exit(1);
+			}
+		}
+		if (numberOfNumbers != numbersPerPoint * (currentBezierPatch.degreeU + 1)) {
+			cout << "Malformed .bez file (expected " << numbersPerPoint * (currentBezierPatch.degreeU + 1) << " numbers on line "
+					<< (lineNumber - 1) << "), terminating program." << endl;
+			exit(1);
+		}
+		if (declaredRational) {
+			for (int j = 0; j <= currentBezierPatch.degreeU; j++) {
+				const float *point = &numbers[4 * j];
+				if (!currentBezierPatch.setControlPoint(curvesParsedForCurrentPatch, j, Eigen::Vector3f(point[0], point[1], point[2]), point[3])) {
+					cout << "Malformed .bez file (weights on line " << (lineNumber - 1) << " must be positive), terminating program." << endl;
+					exit(1);
+				}
+			}
+		} else {
+			Eigen::Vector3f *curve = currentBezierPatch.controlPoints[curvesParsedForCurrentPatch];
+			for (int j = 0; j < numberOfNumbers; j++) {
+				curve[j / 3][j % 3] = numbers[j];
+			}
+		}
+
+		currentBezierPatch.numberOfCurves++;
+		curvesParsedForCurrentPatch++;
+
+		// We have parsed all the curves for our current patch
+		if (curvesParsedForCurrentPatch == currentBezierPatch.degreeV + 1) {
+			currentBezierPatch.computeBounds();
+			curvesParsedForCurrentPatch = 0;
+			declaredDegreeU = declaredDegreeV = 0;
+			declaredRational = false;
+		}
+	}
+	if (curvesParsedForCurrentPatch != 0) {
+		listOfBezierPatches.pop_back();
+	}
+
+	// Trust what is actually in the file over the header
+	numberOfBezierPatches = listOfBezierPatches.size();
+	if (debug) {
+		if (numberOfBezierPatches != declaredNumberOfPatches) {
+			cout << "Warning: " << filename << " declares " << declaredNumberOfPatches << " patches but contains "
+					<< numberOfBezierPatches << endl;
+		}
+		cout << "Parsed " << numberOfBezierPatches << " patches in "
+				<< chrono::duration<double, milli>(chrono::high_resolution_clock::now() - parseStart).count() << " ms" << endl;
+	}
+}
+
+
+//****************************************************
+// Reads an input .bez file, then tessellates its patches (and saves or
+// exports the tessellation, if asked to)
+//****************************************************
+void parseBezierFile(string filename) {
+	readBezierFile(filename);
+
+	patchBVH.build(listOfBezierPatches);
+
+	// Perform subdivision of BezierPatches, based on whether we want to adaptively or uniformly subdivide
+	if (subdivisionMethod == "ADAPTIVE") {
+		perform_subdivision(true);
+	} else if (subdivisionMethod == "UNIFORM") {
+		perform_subdivision(false);
+	} else {
+		cout << "Invalid subdivision method, terminating program.";
+		exit(1);
+	}
+
+	if (!meshCacheFilename.empty()) {
+		saveMeshCache();
+	}
+
+	// We want to write our Bezier patches to an .obj file
+	if (WRITE_OBJ) {
+		generateObjFile(objFilenameOutput);
+	}
+
+}
+
+//****************************************************
+// Parsing .OBJ file specified in scene file
+//****************************************************
+void parseObjFile(string filename) {
+	Profiler::ScopedTimer timer(profiler, Profiler::PARSE_OBJ);
+
+	chrono::high_resolution_clock::time_point parseStart = chrono::high_resolution_clock::now();
+
+	if (!objMesh.load(filename, getThreadPool())) {
+		cout << "Could not open " << filename << ", terminating program." << endl;
+		exit(1);
+	}
+
+	if (debug) {
+		cout << "Parsed " << objMesh.vertices.size() << " vertices, " << objMesh.normals.size() << " normals and "
+				<< objMesh.getNumberOfPolygons() << " polygons in "
+				<< chrono::duration<double, milli>(chrono::high_resolution_clock::now() - parseStart).count() << " ms" << endl;
+	}
+}
+//****************************************************
+// function that determines if full string ends with ending
+//***************************************************
+
+static bool hasEnding (std::string const &fullString, std::string const &ending) {
+    if (fullString.length() >= ending.length()) {
+        return (0 == fullString.compare (fullString.length() - ending.length(), ending.length(), ending));
+    } else {
+        return false;
+    }
+}
+
+//****************************************************
+// function that parses command line options,
+// given number of command line arguments (argc)
+// and the argument array (argv)
+// Format:
+// % as3 inputfile.bez 0.1 -a
+// % as3 inputfile.bez 0.1 -e casteljau     (surface evaluator: bernstein (default), casteljau or simd;
+//                                           bernstein evaluates uniform grids in one batch)
+// % as3 inputfile.bez 0.1 -benchmark        (print surface evaluation throughput and exit)
+// % as3 inputfile.bez 0.1 -threads 8        (tessellate patches in parallel; 0 = one thread per core)
+// % as3 inputfile.bez 0.01 -a -dfs          (adaptive subdivision depth-first, using O(depth) memory)
+// % as3 inputfile.bez 0.01 -a -maxdepth 20  (never split a triangle more than 20 times)
+// % as3 inputfile.bez 0.5 -a -screenspace  (the error is in pixels on screen, and patches re-tessellate
+//                                           as zooming or moving the camera changes their size on screen)
+// % as3 inputfile.bez 0.1 -immediate        (draw with glBegin/glEnd per triangle instead of vertex buffers)
+// % as3 inputfile.bez 0.1 -headless 100 out (render 100 frames of each mode offscreen, print frame times,
+//                                           and save out_wireframe.ppm, out_hiddenline.ppm, out_filled.ppm)
+// % as3 inputfile.bez 0.1 -software        (draw with the multithreaded CPU rasterizer instead of OpenGL;
+//                                           works with -headless, which then needs no GL at all)
+// % as3 inputfile.bez 0.1 -noculling       (draw every patch, not just those whose bounding boxes are in view)
+// % as3 inputfile.bez 0.1 -raycast out      (intersect a ray per pixel with the exact surfaces, print rays per
+//                                           second, and save out_raycast.ppm; use with -threads)
+// % as3 -suite out.json a.bez b.obj ...     (time parsing, evaluation, subdivision, retessellation and .obj
+//                                           export/import on each file, and save min/median/p99 and allocations
+//                                           as JSON)
+// % as3 inputfile.bez 0.1 -profile out.json (count allocations per stage too, and print the profile and save it
+//                                           as out.json at exit; 'p' prints it at any time)
+// % as3 inputfile.bez 0.01 -cache out.mesh  (load the tessellation from out.mesh if it was saved from the same
+//                                           file and options, else tessellate and save it there)
+//***************************************************
+void parseCommandLineOptions(int argc, char *argv[])
+{
+	subdivisionMethod = "UNIFORM";
+	evaluationMethod = "BERNSTEIN";
+	numberOfThreads = 1;
+	DEPTH_FIRST_SUBDIVISION = false;
+	maxSubdivisionDepth = 0;
+	SCREEN_SPACE_SUBDIVISION = false;
+	IMMEDIATE_MODE = false;
+	HEADLESS_MODE = false;
+	SOFTWARE_RENDERING = false;
+	FRUSTUM_CULLING = true;
+	RAY_CAST_MODE = false;
+	string flag;
+
+	int i = 1;
+	while (i <= argc - 1) {
+		flag = argv[i];
+
+		if (i == 1) {
+			filename = flag;
+			if (hasEnding(flag, ".bez")) {
+				objMode = false;
+			} else if (hasEnding(flag, ".obj")) {
+				objMode = true;
+			} else {
+				std::cout << "Unrecognized input file format.";
+				exit(1);
+			}
+		} else if (i == 2) {
+			subdivisionParameter = stof(flag);
+		} else if (flag == "-o") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -o.";
+				exit(1);
+			}
+			if (!objMode) {
+				WRITE_OBJ = true;
+				objFilenameOutput = argv[i+1];
+			} else {
+				std::cout << "Error: cannot write to .obj file if in .obj mode.";
+				exit(1);
+			}
+			i += 1;
+		} else if (flag == "-e") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -e.";
+				exit(1);
+			}
+			string method = argv[i+1];
+			if (method == "casteljau") {
+				evaluationMethod = "CASTELJAU";
+			} else if (method == "bernstein") {
+				evaluationMethod = "BERNSTEIN";
+			} else if (method == "simd") {
+				evaluationMethod = "SIMD";
+			} else {
+				std::cout << "Unrecognized evaluation method: " << method;
+				exit(1);
+			}
+			i += 1;
+		} else if (flag == "-benchmark") {
+			BENCHMARK_MODE = true;
+		} else if (flag == "-immediate") {
+			IMMEDIATE_MODE = true;
+		} else if (flag == "-software") {
+			SOFTWARE_RENDERING = true;
+		} else if (flag == "-noculling") {
+			FRUSTUM_CULLING = false;
+		} else if (flag == "-raycast") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -raycast.";
+				exit(1);
+			}
+			RAY_CAST_MODE = true;
+			rayCastSnapshotPrefix = argv[i+1];
+			i += 1;
+		} else if (flag == "-profile") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -profile.";
+				exit(1);
+			}
+			PROFILE_MODE = true;
+			profileFilename = argv[i+1];
+			i += 1;
+		} else if (flag == "-cache") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -cache.";
+				exit(1);
+			}
+			meshCacheFilename = argv[i+1];
+			i += 1;
+		} else if (flag == "-headless") {
+			if ((i + 2) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -headless.";
+				exit(1);
+			}
+			HEADLESS_MODE = true;
+			headlessFrames = max(1, stoi(argv[i+1]));
+			headlessSnapshotPrefix = argv[i+2];
+			i += 2;
+		} else if (flag == "-screenspace") {
+			SCREEN_SPACE_SUBDIVISION = true;
+		} else if (flag == "-dfs") {
+			DEPTH_FIRST_SUBDIVISION = true;
+		} else if (flag == "-maxdepth") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -maxdepth.";
+				exit(1);
+			}
+			maxSubdivisionDepth = stoi(argv[i+1]);
+			i += 1;
+		} else if (flag == "-threads") {
+			if ((i + 1) > (argc - 1))
+			{
+				std::cout << "Invalid number of parameters for -threads.";
+				exit(1);
+			}
+			numberOfThreads = stoi(argv[i+1]);
+			if (numberOfThreads <= 0) {
+				numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			i += 1;
+		}
+
+		if (i == 3 && flag == "-a") {
+			subdivisionMethod = "ADAPTIVE";
+		}
+
+		i++;
+	}
+
+	if (SCREEN_SPACE_SUBDIVISION && (subdivisionMethod != "ADAPTIVE" || WRITE_OBJ)) {
+		std::cout << "Error: -screenspace needs adaptive subdivision (-a), and its tessellation depends on the view, so it can't be written with -o.";
+		exit(1);
+	}
+
+	if (!meshCacheFilename.empty() && (objMode || SCREEN_SPACE_SUBDIVISION)) {
+		std::cout << "Error: -cache saves tessellated Bezier patches, so it needs a .bez file, and can't be used with -screenspace, whose tessellation depends on the view.";
+		exit(1);
+	}
+
+	if (RAY_CAST_MODE && objMode) {
+		std::cout << "Error: -raycast intersects Bezier patches, so it needs a .bez file.";
+		exit(1);
+	}
+
+	// (before reading the input, so that its allocations count too)
+	if (PROFILE_MODE) {
+		AllocationCounter::isCounting = true;
+		atexit(printProfile);
+	}
+
+	if (hasEnding(filename, ".bez")) {
+		if (meshCacheFilename.empty() || !loadMeshCache()) {
+			parseBezierFile(filename);
+		} else if (WRITE_OBJ) {
+			generateObjFile(objFilenameOutput);
+		}
+	} else if (hasEnding(filename, ".obj")) {
+		parseObjFile(filename);
+	}
+}
+
+
+
+//****************************************************
+// Initializes the camera's vector instance variables,
+// based on the box around every BezierPatch's control points (or every .obj vertex)
+//
+// NOTE: This method MUST be called AFTER the scene file is parsed
+//****************************************************
+void initializeCamera() {
+	// First, we iterate through all of the objects in our scene and we determine the minimum and maximum x, y, z values over all objects
+
+	float xMin, xMax, yMin, yMax, zMin, zMax;
+
+	xMin = yMin = zMin = numeric_limits<int>::max();
+	xMax = yMax = zMax = numeric_limits<int>::min();
+
+
+	// The patches' bounding volume hierarchy already has a box around all of their control points,
+	// and an .obj mesh's box comes from a SIMD scan over its vertices (only those that faces use)
+	BoundingBox sceneBounds = objMode ? objMesh.computeBounds() : patchBVH.getSceneBounds();
+	if (!sceneBounds.isEmpty()) {
+		xMin = sceneBounds.minimum.x();
+		yMin = sceneBounds.minimum.y();
+		zMin = sceneBounds.minimum.z();
+		xMax = sceneBounds.maximum.x();
+		yMax = sceneBounds.maximum.y();
+		zMax = sceneBounds.maximum.z();
+	}
+
+	// At this point, xMin, xMax, yMin, yMax, zMin, zMax are initialized, and form a box that has dimensions
+	// (xMax - xMin)  x  (yMax - yMin)  x  (zMax - zMin)
+	float xLength = xMax - xMin;
+	float yLength = yMax - yMin;
+	float zLength = zMax - zMin;
+	float largestLength = fmax(zLength, fmax(xLength, yLength));
+
+	// First, we find the CENTER of our x/y/z min/max values, and this becomes our camera's lookAt vector
+	Eigen::Vector3f center((xMin + xMax) / 2.0f, (yMin + yMax) / 2.0f, (zMin + zMax) / 2.0f);
+	camera.lookAt = center;
+
+	// Set the camera's position to (x, y) = (0, 0). The z-coordinate is the length of the largest coordinate
+	// between xLength, yLength, zLength as defined above, so that the object will always be visible in the scope of the camera's lens
+	camera.position = Eigen::Vector3f(0.0, 0.0, 2.0f * largestLength);
+
+	// Hardcode camera up vector to (0, 1, 0)
+	camera.up = Eigen::Vector3f(0, 1.0f, 0);
+
+	camera.zNear = 1.0f;
+
+	camera.zFar = camera.zNear + (10.0f * largestLength);
+}
+
+
+
+
+//****************************************************
+// Micro-benchmark that evaluates every BezierPatch on a dense (u, v) grid
+// with each of our evaluators and prints the throughput in samples/second.
+// The last two rows evaluate the same patches made rational (with the weights
+// they have, i.e. all 1 unless the file's patches are rational already), so
+// they compare the homogeneous path with the polynomial rows above them
+//****************************************************
+void runEvaluationBenchmark() {
+	const int samplesPerSide = 128;
+	const int repetitions = 4;
+
+	Eigen::VectorXf parameterValues(samplesPerSide);
+	for (int k = 0; k < samplesPerSide; k++) {
+		parameterValues(k) = k / (float) (samplesPerSide - 1);
+	}
+
+	long numberOfSamples = (long) repetitions * listOfBezierPatches.size() * samplesPerSide * samplesPerSide;
+	string kernel = "scalar";
+#ifdef BEZIER_PATCH_X86_SIMD
+	if (BezierPatch::cpuSupportsAVX()) {
+		kernel = "AVX";
+	} else if (BezierPatch::cpuSupportsSSE2()) {
+		kernel = "SSE";
+	}
+#endif
+
+	std::vector<BezierPatch> rationalPatches(listOfBezierPatches.size());
+	for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+		const BezierPatch &patch = listOfBezierPatches[i];
+		rationalPatches[i].setDegrees(patch.degreeU, patch.degreeV);
+		for (int curve = 0; curve < patch.numberOfCurves; curve++) {
+			for (int point = 0; point <= patch.degreeU; point++) {
+				rationalPatches[i].setControlPoint(curve, point, patch.controlPoints[curve][point], patch.getWeight(curve, point));
+			}
+		}
+		rationalPatches[i].numberOfCurves = patch.numberOfCurves;
+	}
+
+	cout << "\nEvaluation benchmark on " << filename << ": " << listOfBezierPatches.size() << " patches, "
+			<< numberOfSamples << " samples per evaluator (SIMD kernel: " << kernel << ")\n\n";
+
+	const char *evaluatorNames[] = { "casteljau", "bernstein", "grid", "simd", "rational", "rational grid" };
+	for (int evaluator = 0; evaluator < 6; evaluator++) {
+		// Accumulate every result so that the compiler can't skip the work
+		float checksum = 0.0f;
+		std::vector<DifferentialGeometry> grid;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int repetition = 0; repetition < repetitions; repetition++) {
+			for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+				BezierPatch &patch = (evaluator >= 4) ? rationalPatches[i] : listOfBezierPatches[i];
+
+				if (evaluator == 0 || evaluator == 1 || evaluator == 4) {
+					for (int k = 0; k < samplesPerSide; k++) {
+						for (int l = 0; l < samplesPerSide; l++) {
+							DifferentialGeometry result = (evaluator == 0)
+									? patch.evaluateDifferentialGeometryDeCasteljau(parameterValues(k), parameterValues(l))
+									: patch.evaluateDifferentialGeometryBernstein(parameterValues(k), parameterValues(l));
+							checksum += result.position.x();
+						}
+					}
+				} else if (evaluator == 2 || evaluator == 5) {
+					grid.clear();
+					patch.evaluateGrid(parameterValues, parameterValues, grid);
+					checksum += grid.back().position.x();
+				} else {
+					SamplePacket packet;
+					for (int k = 0; k < samplesPerSide; k++) {
+						for (int l = 0; l < samplesPerSide; l += SamplePacket::MAX_SIZE) {
+							packet.count = 0;
+							for (int lane = 0; lane < SamplePacket::MAX_SIZE; lane++) {
+								packet.addSample(parameterValues(k), parameterValues(l + lane));
+							}
+							patch.evaluatePacket(packet);
+							checksum += packet.x[0];
+						}
+					}
+				}
+			}
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		printf("  %-14s %10.2f Msamples/s  (%8.2f ms, checksum %g)\n", evaluatorNames[evaluator],
+				numberOfSamples / elapsed.count() / 1.0e6, elapsed.count() * 1000.0, checksum);
+	}
+}
+
+
+
+//****************************************************
+// Prints the 50th / 90th / 99th percentile and worst of a list of frame times,
+// and how many of the scene's numberOfTriangles are drawn per second at the median
+//***************************************************
+void printFrameTimePercentiles(string name, std::vector<double> frameTimes, long numberOfTriangles) {
+	std::sort(frameTimes.begin(), frameTimes.end());
+	int n = frameTimes.size();
+
+	// Nearest-rank percentiles
+	double p50 = frameTimes[max(0, (int) ceil(0.50 * n) - 1)];
+	double p90 = frameTimes[max(0, (int) ceil(0.90 * n) - 1)];
+	double p99 = frameTimes[max(0, (int) ceil(0.99 * n) - 1)];
+
+	printf("  %-12s p50 %8.3f ms   p90 %8.3f ms   p99 %8.3f ms   max %8.3f ms   (%.1f fps, %.2f Mtriangles/s at p50)\n",
+			name.c_str(), p50, p90, p99, frameTimes[n - 1], 1000.0 / p50, numberOfTriangles / p50 / 1000.0);
+}
+
+//****************************************************
+// Number of triangles in the scene (polygons count as the triangles of their fans)
+//***************************************************
+long countSceneTriangles() {
+	long numberOfTriangles = 0;
+	if (objMode) {
+		for (int p = 0; p < objMesh.getNumberOfPolygons(); p++) {
+			numberOfTriangles += max(0, objMesh.getPolygonSize(p) - 2);
+		}
+	} else {
+		for (std::vector<BezierPatch>::size_type i = 0; i < listOfBezierPatches.size(); i++) {
+			numberOfTriangles += listOfBezierPatches[i].getNumberOfTriangles();
+		}
+	}
+	return numberOfTriangles;
+}
+
+//****************************************************
+// Renders headlessFrames frames of each display mode into an offscreen framebuffer
+// the size of the window, through the same camera and renderScene() as the interactive view
+// (or into softwareRasterizer's image, with -software, which needs no GL context at all).
+// Prints frame time percentiles per mode and saves the last frame of each as a .ppm
+//***************************************************
+int runHeadlessBenchmark(int argc, char *argv[]) {
+	OffscreenRenderer renderer;
+	string rendererName;
+	if (SOFTWARE_RENDERING) {
+		initDisplayModes();
+		rendererName = "the CPU (" + to_string(getThreadPool().size()) + (getThreadPool().size() == 1 ? " thread)" : " threads)");
+	} else {
+		if (!renderer.create(viewport.w, viewport.h, argc, argv)) {
+			return 1;
+		}
+		initScene();
+		rendererName = renderer.getRendererName();
+	}
+	long numberOfTriangles = countSceneTriangles();
+
+	const char *modeNames[] = { "wireframe", "hiddenline", "filled" };
+	const bool wireframe[] = { true, true, false };
+	const bool hiddenLine[] = { false, true, false };
+
+	const char *pathName = "vertex buffers";
+	if (SOFTWARE_RENDERING) {
+		pathName = "software rasterizer";
+	} else if (objMode || IMMEDIATE_MODE) {
+		pathName = "immediate mode";
+	}
+	printf("Rendering %d frames per mode of %ld triangles at %dx%d on %s (%s):\n", headlessFrames, numberOfTriangles,
+			viewport.w, viewport.h, rendererName.c_str(), pathName);
+
+	for (int mode = 0; mode < 3; mode++) {
+		WIREFRAME_MODE = wireframe[mode];
+		HIDDEN_LINE_MODE = hiddenLine[mode];
+
+		// One untimed frame first, so that uploading the mesh doesn't count as a frame
+		if (SOFTWARE_RENDERING) {
+			renderSceneInSoftware();
+		} else {
+			renderScene();
+			glFinish();
+		}
+
+		std::vector<double> frameTimes;
+		for (int frame = 0; frame < headlessFrames; frame++) {
+			Profiler::ScopedTimer timer(profiler, Profiler::FRAME);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			if (SOFTWARE_RENDERING) {
+				renderSceneInSoftware();
+			} else {
+				renderScene();
+				glFinish();
+			}
+			frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		printFrameTimePercentiles(modeNames[mode], frameTimes, numberOfTriangles);
+
+		string snapshotFilename = headlessSnapshotPrefix + "_" + modeNames[mode] + ".ppm";
+		bool written = SOFTWARE_RENDERING ? softwareRasterizer.writePPM(snapshotFilename) : renderer.writePPM(snapshotFilename);
+		if (!written) {
+			cout << "Could not write " << snapshotFilename << "\n";
+		}
+	}
+	return 0;
+}
+
+
+//****************************************************
+// Casts one ray through every pixel of the window at the patches' exact surfaces (no tessellation
+// involved), on every thread of the pool. Prints the rays per second and saves the hits, shaded by
+// how squarely each ray hit the surface, as <rayCastSnapshotPrefix>_raycast.ppm
+//***************************************************
+int runRayCastBenchmark() {
+	Eigen::Matrix4f inverseModelviewProjection = getInverseModelviewProjection();
+	std::vector<Ray> rays;
+	rays.reserve(viewport.w * viewport.h);
+	for (int y = 0; y < viewport.h; y++) {
+		for (int x = 0; x < viewport.w; x++) {
+			rays.push_back(getCameraRay(inverseModelviewProjection, x, y));
+		}
+	}
+
+	std::vector<RayHit> hits;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	patchBVH.intersect(getThreadPool(), listOfBezierPatches, rays, hits);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	long numberOfHits = 0;
+	std::vector<unsigned char> pixels(rays.size() * 3, 0);
+	for (std::vector<RayHit>::size_type i = 0; i < hits.size(); i++) {
+		if (hits[i].patch < 0) {
+			continue;
+		}
+		numberOfHits++;
+		float facing = std::fabs(hits[i].geometry.normal.dot(rays[i].direction.normalized()));
+		unsigned char shade = std::isfinite(facing) ? (unsigned char) (255.0f * std::min(facing, 1.0f)) : 0;
+		pixels[3 * i] = pixels[3 * i + 1] = pixels[3 * i + 2] = shade;
+	}
+	printf("Cast %zu rays at %zu patches in %.1f ms on %d thread%s (%.2f Mrays/s), %ld hits.\n", rays.size(),
+			listOfBezierPatches.size(), seconds * 1000.0, getThreadPool().size(), getThreadPool().size() == 1 ? "" : "s",
+			rays.size() / seconds / 1e6, numberOfHits);
+
+	// The rays went row by row from the top, which is already .ppm's order
+	string snapshotFilename = rayCastSnapshotPrefix + "_raycast.ppm";
+	FILE *file = fopen(snapshotFilename.c_str(), "wb");
+	if (file == NULL) {
+		cout << "Could not write " << snapshotFilename << "\n";
+		return 1;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", viewport.w, viewport.h);
+	fwrite(&pixels[0], 1, pixels.size(), file);
+	fclose(file);
+	return 0;
+}
+
+
+//****************************************************
+// Times each stage of the pipeline on every input file in argv[3...] (as in "as3 -suite out.json
+// teapot.bez cow.obj"): for .bez files parsing, evaluating patches, uniform and adaptive subdivision
+// at a few step sizes and errors, retessellating each tessellation finer and back (which, once warmed up,
+// should allocate nothing), exporting each uniform tessellation to .obj and importing it back;
+// for .obj files importing them. Serial, so that the numbers compare between machines and runs.
+// Prints a summary table and writes every stage's run times and allocations to argv[2] as JSON
+//****************************************************
+int runBenchmarkSuite(int argc, char *argv[]) {
+	if (argc < 4) {
+		cout << "Usage: as3 -suite results.json input.bez|input.obj...\n";
+		return 1;
+	}
+	string resultsFilename = argv[2];
+	string exportFilename = resultsFilename + ".export.obj";
+
+	const float stepSizes[] = { 0.1f, 0.05f, 0.02f };
+	const float errors[] = { 0.01f, 0.005f, 0.002f };
+	const int samplesPerSide = 32;
+
+	debug = false;
+	objMode = false;
+	numberOfThreads = 1;
+	evaluationMethod = "BERNSTEIN";
+	DEPTH_FIRST_SUBDIVISION = false;
+	maxSubdivisionDepth = 0;
+	SCREEN_SPACE_SUBDIVISION = false;
+
+	BenchmarkSuite suite(0.5, 3, 100);
+	printf("Benchmarking %d input files (at least %d runs and %g s per stage):\n", argc - 3, suite.minimumRuns,
+			suite.secondsPerStage);
+	for (int i = 3; i < argc; i++) {
+		filename = argv[i];
+		if (!MappedFile(filename).isOpen()) {
+			cout << "Could not open " << filename << ", terminating program." << endl;
+			return 1;
+		}
+
+		if (hasEnding(filename, ".obj")) {
+			suite.measure(filename, "import", -1, [] {}, [] {
+				objMesh.load(filename, getThreadPool());
+				return (long) objMesh.getNumberOfPolygons();
+			});
+			continue;
+		}
+
+		suite.measure(filename, "parse", -1, [] {
+			listOfBezierPatches.clear();
+		}, [] {
+			readBezierFile(filename);
+			return (long) listOfBezierPatches.size();
+		});
+		std::vector<BezierPatch> parsedPatches = listOfBezierPatches;
+
+		suite.measure(filename, "evaluate", -1, [] {}, [] {
+			long numberOfSamples = 0;
+			for (std::vector<BezierPatch>::size_type p = 0; p < listOfBezierPatches.size(); p++) {
+				for (int k = 0; k < samplesPerSide; k++) {
+					for (int l = 0; l < samplesPerSide; l++) {
+						DifferentialGeometry sample = listOfBezierPatches[p].evaluateDifferentialGeometry(
+								k / (float) (samplesPerSide - 1), l / (float) (samplesPerSide - 1));
+						numberOfSamples += std::isfinite(sample.position.x()) ? 1 : 0;
+					}
+				}
+			}
+			return numberOfSamples;
+		});
+
+		for (float stepSize : stepSizes) {
+			subdivisionParameter = stepSize;
+			suite.measure(filename, "uniform", stepSize, [&parsedPatches] {
+				// (clearing first, so that the tessellation starts from empty vectors rather than reusing the last one's)
+				listOfBezierPatches.clear();
+				listOfBezierPatches = parsedPatches;
+			}, [] {
+				perform_subdivision(false);
+				return countSceneTriangles();
+			});
+			suite.measure(filename, "export", stepSize, [] {}, [&exportFilename] {
+				return generateObjFile(exportFilename);
+			});
+			suite.measure(filename, "import", stepSize, [] {}, [&exportFilename] {
+				objMesh.load(exportFilename, getThreadPool());
+				return (long) objMesh.getNumberOfPolygons();
+			});
+			suite.measure(filename, "retessellate_uniform", stepSize, [] {}, [stepSize] {
+				for (std::vector<BezierPatch>::size_type p = 0; p < listOfBezierPatches.size(); p++) {
+					listOfBezierPatches[p].retessellateUniform(stepSize / 2.0f);
+					listOfBezierPatches[p].retessellateUniform(stepSize);
+				}
+				return countSceneTriangles();
+			});
+		}
+		std::remove(exportFilename.c_str());
+
+		for (float error : errors) {
+			subdivisionParameter = error;
+			suite.measure(filename, "adaptive", error, [&parsedPatches] {
+				// (clearing first, so that the tessellation starts from empty vectors rather than reusing the last one's)
+				listOfBezierPatches.clear();
+				listOfBezierPatches = parsedPatches;
+			}, [] {
+				perform_subdivision(true);
+				return countSceneTriangles();
+			});
+			suite.measure(filename, "retessellate_adaptive", error, [] {}, [error] {
+				for (std::vector<BezierPatch>::size_type p = 0; p < listOfBezierPatches.size(); p++) {
+					listOfBezierPatches[p].retessellateAdaptive(error / 2.0f);
+					listOfBezierPatches[p].retessellateAdaptive(error);
+				}
+				return countSceneTriangles();
+			});
+		}
+	}
+
+	if (!suite.writeJSON(resultsFilename)) {
+		cout << "Could not write " << resultsFilename << "\n";
+		return 1;
+	}
+	cout << "Wrote " << suite.results.size() << " results to " << resultsFilename << "\n";
+	return 0;
+}
+
+
+//****************************************************
+// psuedocode for... everything
+//****************************************************
+
+/*
+
+- Parse command line arguments to get subdivision parameter and subdivision method (adaptive vs. uniform)
+
+- Use parsed command line arguments to initialize a list of all Bezier patches (with psuedocode above)
+
+- Iterate through list of patches and subdivide all of the patches in the list, either adapatively or uniformly
+
+  - for uniform subdivision:
+    - take given u | v step size, initialize a list of LocalGeometry objects, starting from (u, v) = (0, 0) and moving
+      up by u = v = stepsize each time. NOTE: this list of LocalGeometry objects is specific for the current patch.
+      That is, the list of LocalGeometry objects will be given by currentPatch.local_geo_list
+    - take list of LocalGeometry objects and generate a list of triangles with it. NOTE: this list of triangles is specific
+      for the current patch. That is, it is given by currentPatch.triangle_list
+
+  - for adaptive subdivision:
+    - split based on lecture slides
+      (http://www.cs.berkeley.edu/~job/Classes/CS184/Spring-2015-Slides/14-Surfaces.pdf)
+
+- At this point, each of the patches (ie. surfaces) has its own list of LocalGeometry objects and its own list of triangles
+
+- Create an overarching list of LocalGeometry objects and an overarching list of Triangle objects, and aggregate
+  all LocalGeometry and Triangle objects, respectively, into these two overarching lists
+
+- Define myDisplay():
+  - Set the gluLookAt, and other OpenGL variables (?)
+  - for each BezierPatch in the Scene's BezierPatch list:
+    - for each Triangle in the current BezierPatch's triangle list (ie. currentPatch.triangle_list):
+      - set OpenGL Vertex3f/Normal3f and other things to draw the current triangle
+      - NOTE: need to change this slightly when wireframe mode/other modes are active/non-active
+
+- Call glutDisplayFunc(myDisplay)
+
+ */
+
+
+//****************************************************
+// the usual stuff, nothing exciting here
+//****************************************************
+int main(int argc, char *argv[]) {
+
+	// The benchmark suite takes a list of input files instead of a scene
+	if (argc > 1 && string(argv[1]) == "-suite") {
+		return runBenchmarkSuite(argc, argv);
+	}
+
+	// Turns debug mode ON or OFF
+	debug = true;
+	WRITE_OBJ = false;
+	BENCHMARK_MODE = false;
+
+	// Parse command line options
+	parseCommandLineOptions(argc, argv);
+
+	// The benchmark never opens a window, so it has to run before GLUT wants a display
+	if (BENCHMARK_MODE) {
+		runEvaluationBenchmark();
+		return 0;
+	}
+
+	printCommandLineOptionVariables();
+
+	if (RAY_CAST_MODE && !objMode) {
+		initializeCamera();
+		viewport.w = 1000;
+		viewport.h = 1000;
+		return runRayCastBenchmark();
+	}
+
+	if (HEADLESS_MODE) {
+		printProfile();
+		initializeCamera();
+		viewport.w = 1000;
+		viewport.h = 1000;
+		return runHeadlessBenchmark(argc, argv);
+	}
+
+	// This initializes glut
+	glutInit(&argc, argv);
+
+	// At this point, all subdivision of Bezier Patches has been completed
+
+	printProfile();
+
+//	printDifferentialGeometriesInBezierPatches();
+//	printTrianglesInBezierPatches();
+
+	// Initialize position, lookAt, and up vectors of camera so that we may feed them into OpenGL rendering system later
+	initializeCamera();
+
+	//This tells glut to use a double-buffered window with red, green, and blue channels
+	glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGB);
+
+	// Initalize theviewport size
+	viewport.w = 1000;
+	viewport.h = 1000;
+
+	printCameraInformation();
+
+	//The size and position of the window
+	glutInitWindowSize(viewport.w, viewport.h);
+	glutInitWindowPosition(0,0);
+	glutCreateWindow(argv[0]);
+
+	initScene();							// quick function to set up scene
+
+	glutDisplayFunc(myDisplay);				// function to run when its time to draw something
+	glutReshapeFunc(myReshape);				// function to run when the window gets resized
+	glutIdleFunc(myDisplay);
+
+	// Handles key presses
+	glutKeyboardFunc( keyPressed );
+	glutSpecialFunc( handleSpecialKeypress );
+	glutMouseFunc( mouseClicked );
+
+	glutMainLoop();							// infinite loop that will keep drawing and resizing
+	// and whatever else
+
+	return 0;
+}